@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../translator/asmIR.h"
+#include "../translator/binarizer.h"
+
+// Assembler throughput on a generated listing: ./asm_bench [megabytes] [iterations]
+
+namespace {
+
+std::string generateListing(size_t targetBytes) {
+    std::string data = ".data\n";
+    std::string text = ".text\n.org 0x20\n_start:\n";
+    text.reserve(targetBytes + 256);
+
+    size_t index = 0;
+    for (; data.size() + text.size() < targetBytes; index++) {
+        std::string id = std::to_string(index);
+
+        data += "  var_" + id + ": 0\n";
+        data += "  str_" + id + ": \"item " + id + "\\n\\0\"\n";
+
+        text += "L" + id + ":\n";
+        text += "  ld var_" + id + "  ; load\n";
+        text += "  push\n";
+        text += "  ldi " + std::to_string(index % 4096) + "\n";
+        text += "  st temp_right\n";
+        text += "  pop\n";
+        text += "  add temp_right\n";
+        text += "  st var_" + id + "\n";
+        text += "  ldi str_" + id + "\n";
+        text += "  jz L" + std::to_string(index + 1) + "\n";
+        text += "  jmp L" + std::to_string(index / 2) + "\n";
+    }
+
+    return data + "  temp_right: 0\n" + text + "L" + std::to_string(index) + ":\n  halt\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::vector<std::string> args(argv, argv + argc);
+
+    size_t megabytes  = args.size() > 1 ? std::stoul(args[1]) : 8;
+    size_t iterations = args.size() > 2 ? std::stoul(args[2]) : 5;
+
+    constexpr size_t BYTES_PER_MB = 1024 * 1024;
+    std::string listing           = generateListing(megabytes * BYTES_PER_MB);
+
+    double best       = 0;
+    size_t lineCount  = std::count(listing.begin(), listing.end(), '\n');
+    size_t labelCount = 0;
+
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        auto start = std::chrono::steady_clock::now();
+
+        AsmProgram program;
+        parseAssembly(listing, program);
+        Binarizer binarizer;
+        binarizer.assemble(program);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double rate = static_cast<double>(listing.size()) / BYTES_PER_MB / elapsed.count();
+        best        = std::max(best, rate);
+        labelCount  = program.labelCount();
+
+        std::cout << "run " << iteration << ": " << elapsed.count() * 1000 << " ms, " << rate
+                  << " MB/s\n";
+    }
+
+    std::cout << listing.size() << " bytes, " << lineCount << " lines, " << labelCount
+              << " labels, best " << best << " MB/s\n";
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../translator/lexer.h"
+
+// Lexer throughput on a generated source: ./lexer_bench [megabytes] [iterations]
+
+namespace {
+
+std::string generateSource(size_t targetBytes) {
+    std::string source;
+    source.reserve(targetBytes + 256);
+
+    for (size_t index = 0; source.size() < targetBytes; index++) {
+        std::string id = std::to_string(index % 512);
+
+        source += "int compute_" + id + "(int value, uint limit) {\n";
+        source += "    int[] table = {1, 2, 3, 42};\n";
+        source += "    string label = \"item " + id + "\";\n";
+        source += "    char sep = '\\n';\n";
+        source += "    while (value < limit && value != 0 || !false) {\n";
+        source += "        if (value % 2 == 0) {\n";
+        source += "            value = value / 2 + table[1] * " + id + ";\n";
+        source += "        } else {\n";
+        source += "            value = value - 1;\n";
+        source += "            break;\n";
+        source += "        }\n";
+        source += "    }\n";
+        source += "    print_str(label);\n";
+        source += "    return value >= " + id + ";\n";
+        source += "}\n\n";
+    }
+
+    return source;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::vector<std::string> args(argv, argv + argc);
+
+    size_t megabytes  = args.size() > 1 ? std::stoul(args[1]) : 16;
+    size_t iterations = args.size() > 2 ? std::stoul(args[2]) : 5;
+
+    constexpr size_t BYTES_PER_MB = 1024 * 1024;
+    std::string source            = generateSource(megabytes * BYTES_PER_MB);
+
+    double best       = 0;
+    size_t tokenCount = 0;
+    size_t symbols    = 0;
+
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        Interner interner;
+        Lexer lexer(interner);
+
+        auto start                = std::chrono::steady_clock::now();
+        std::vector<Token> tokens = lexer.tokenize(source);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double rate = static_cast<double>(source.size()) / BYTES_PER_MB / elapsed.count();
+        best        = std::max(best, rate);
+        tokenCount  = tokens.size();
+        symbols     = interner.size();
+
+        std::cout << "run " << iteration << ": " << elapsed.count() * 1000 << " ms, " << rate
+                  << " MB/s\n";
+    }
+
+    std::cout << source.size() << " bytes, " << tokenCount << " tokens, " << symbols
+              << " symbols, best " << best << " MB/s\n";
+}
@@ -8,6 +8,7 @@
 #include <unordered_map>
 
 enum InputMode : uint8_t { NONE, MODE_TOKEN, MODE_STREAM };
+enum CpuModel : uint8_t { MULTICYCLE, PIPELINED };
 
 struct MachineConfig {
     std::string input_file;
@@ -18,6 +19,11 @@ struct MachineConfig {
     std::string log_file;
     std::string binary_repr_file;
     std::string log_hash_file;
+    std::string stats_file;
+    std::string cost_file = "cost.txt";
+    CpuModel cpu_model    = CpuModel::MULTICYCLE;
+    size_t cores          = 1;
+    size_t sync_quantum   = 1000;
 };
 
 inline auto trim(const std::string& val) -> std::string {
@@ -33,6 +39,51 @@ inline auto unquote(const std::string& val) -> std::string {
     return val;
 }
 
+inline auto applyConfigKey(MachineConfig& config, const std::string& key,
+                           const std::string& value) -> void {
+    if (key == "input_file") {
+        config.input_file = value;
+    } else if (key == "input_mode") {
+        if (value == "token") {
+            config.input_mode = InputMode::MODE_TOKEN;
+        } else if (value == "stream") {
+            config.input_mode = InputMode::MODE_STREAM;
+        } else {
+            throw std::runtime_error("Invalid input_mode: " + value);
+        }
+    } else if (key == "schedule_start") {
+        config.schedule_start = std::stoi(value);
+    } else if (key == "schedule_offset") {
+        config.schedule_offset = std::stoi(value);
+    } else if (key == "output_file") {
+        config.output_file = value;
+    } else if (key == "log_file") {
+        config.log_file = value;
+    } else if (key == "binary_repr_file") {
+        config.binary_repr_file = value;
+    } else if (key == "log_hash_file") {
+        config.log_hash_file = value;
+    } else if (key == "stats_file") {
+        config.stats_file = value;
+    } else if (key == "cost_file") {
+        config.cost_file = value;
+    } else if (key == "cpu_model") {
+        if (value == "multicycle") {
+            config.cpu_model = CpuModel::MULTICYCLE;
+        } else if (value == "pipelined") {
+            config.cpu_model = CpuModel::PIPELINED;
+        } else {
+            throw std::runtime_error("Invalid cpu_model: " + value);
+        }
+    } else if (key == "cores") {
+        config.cores = std::stoul(value);
+    } else if (key == "sync_quantum") {
+        config.sync_quantum = std::stoul(value);
+    } else {
+        throw std::runtime_error("Unknown config key: " + key);
+    }
+}
+
 inline auto parseConfig(const std::string& fileName) -> MachineConfig {
     std::ifstream inFile(fileName);
     if (!inFile.is_open()) {
@@ -50,31 +101,7 @@ inline auto parseConfig(const std::string& fileName) -> MachineConfig {
         std::string key   = trim(line.substr(0, colon));
         std::string value = unquote(trim(line.substr(colon + 1)));
 
-        if (key == "input_file") {
-            config.input_file = value;
-        } else if (key == "input_mode") {
-            if (value == "token") {
-                config.input_mode = InputMode::MODE_TOKEN;
-            } else if (value == "stream") {
-                config.input_mode = InputMode::MODE_STREAM;
-            } else {
-                throw std::runtime_error("Invalid input_mode: " + value);
-            }
-        } else if (key == "schedule_start") {
-            config.schedule_start = std::stoi(value);
-        } else if (key == "schedule_offset") {
-            config.schedule_offset = std::stoi(value);
-        } else if (key == "output_file") {
-            config.output_file = value;
-        } else if (key == "log_file") {
-            config.log_file = value;
-        } else if (key == "binary_repr_file") {
-            config.binary_repr_file = value;
-        } else if (key == "log_hash_file") {
-            config.log_hash_file = value;
-        } else {
-            throw std::runtime_error("Unknown config key: " + key);
-        }
+        applyConfigKey(config, key, value);
     }
 
     return config;
@@ -0,0 +1,512 @@
+#include "costEstimator.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+
+#include "processorModel.h"
+
+namespace {
+
+constexpr size_t LISTING_COLUMN = 36;
+
+uint8_t opcodeOf(uint32_t word) {
+    return (word >> BITS_24) & FULL_MASK_8;
+}
+
+uint32_t operandOf(uint32_t word) {
+    return word & FULL_MASK_24;
+}
+
+bool isJump(uint8_t code) {
+    return code == CU::OP_JMP || (code >= CU::OP_JZ && code <= CU::OP_JBE);
+}
+
+bool endsBlock(uint8_t code) {
+    return isJump(code) || code == CU::OP_RET || code == CU::OP_IRET || code == CU::OP_HALT;
+}
+
+bool contains(const std::vector<uint32_t>& sorted, uint32_t value) {
+    return std::binary_search(sorted.begin(), sorted.end(), value);
+}
+
+}  // namespace
+
+CostEstimator::CostEstimator(const std::string& binaryFile) {
+    std::ifstream inFile(binaryFile, std::ios::binary);
+    if (!inFile) {
+        throw std::runtime_error("Can't open binary file: " + binaryFile);
+    }
+
+    size_t textSize = ProcessorModel::read_uint32(inFile);
+    size_t dataSize = ProcessorModel::read_uint32(inFile);
+    if (textSize + dataSize > MEM_SIZE) {
+        throw std::runtime_error("Binary too large for memory");
+    }
+
+    text.resize(textSize);
+    for (uint32_t& word : text) {
+        word = ProcessorModel::read_uint32(inFile);
+    }
+    data.resize(dataSize);
+    for (uint32_t& word : data) {
+        word = ProcessorModel::read_uint32(inFile);
+    }
+}
+
+void CostEstimator::loadLoopBounds(const std::string& filename) {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        throw std::runtime_error("Failed to open loop bounds file: " + filename);
+    }
+
+    std::string line;
+    while (std::getline(inFile, line)) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        uint32_t header = 0;
+        uint64_t bound  = 0;
+        if (!(iss >> header >> bound)) {
+            throw std::runtime_error("Invalid loop bound: " + line);
+        }
+        loopBounds[header] = bound;
+    }
+}
+
+void CostEstimator::analyze() {
+    findFunctions();
+    findBlocks();
+
+    for (auto& [entry, function] : functions) {
+        collectBlocks(function);
+        findLoops(function);
+    }
+    for (auto& [entry, function] : functions) {
+        functionCost(entry);
+    }
+}
+
+bool CostEstimator::isInstruction(uint32_t address) const {
+    // Opcode 0 does not exist, so zero words are the padding before .org.
+    return address < text.size() && text[address] != 0;
+}
+
+// The program starts at address 0, the interrupt handlers at the first two data words, and every
+// call target is a subroutine.
+void CostEstimator::findFunctions() {
+    functions.emplace(0, Function{0, "program"});
+    for (size_t vector = 0; vector < 2 && vector < data.size(); vector++) {
+        if (isInstruction(data[vector])) {
+            functions.emplace(data[vector], Function{data[vector], "interrupt"});
+        }
+    }
+
+    for (uint32_t at = 0; at < text.size(); at++) {
+        if (isInstruction(at) && opcodeOf(text[at]) == CU::OP_CALL) {
+            uint32_t target = operandOf(text[at]);
+            functions.emplace(target, Function{target, "subroutine"});
+        }
+    }
+}
+
+void CostEstimator::findBlocks() {
+    std::set<uint32_t> leaders;
+    for (const auto& [entry, function] : functions) {
+        leaders.insert(entry);
+    }
+
+    for (uint32_t at = 0; at < text.size(); at++) {
+        if (!isInstruction(at)) {
+            continue;
+        }
+        if (at == 0 || !isInstruction(at - 1)) {
+            leaders.insert(at);
+        }
+
+        uint8_t code = opcodeOf(text[at]);
+        if (CU::microsteps(code) == 0) {
+            throw std::runtime_error("Unknown opcode at " + address(at));
+        }
+        if (isJump(code)) {
+            leaders.insert(operandOf(text[at]));
+        }
+        if (endsBlock(code)) {
+            leaders.insert(at + 1);
+        }
+    }
+
+    for (uint32_t leader : leaders) {
+        if (!isInstruction(leader)) {
+            continue;
+        }
+
+        Block block{leader, leader, 0, {}};
+        uint8_t last = 0;
+        do {
+            last = opcodeOf(text[block.end]);
+            block.ticks += CU::instructionTicks(last);
+            block.end++;
+        } while (!endsBlock(last) && isInstruction(block.end) && leaders.count(block.end) == 0);
+
+        if (isJump(last)) {
+            block.successors.push_back(operandOf(text[block.end - 1]));
+        }
+        if (!endsBlock(last) || (isJump(last) && last != CU::OP_JMP)) {
+            if (isInstruction(block.end)) {
+                block.successors.push_back(block.end);
+            }
+        }
+
+        blocks.emplace(leader, std::move(block));
+    }
+}
+
+// Successors inside the function. A jump to another function's entry is a tail call, charged in
+// blockCost() instead.
+std::vector<uint32_t> CostEstimator::edges(const Function& function, uint32_t block) const {
+    std::vector<uint32_t> result;
+    for (uint32_t successor : blocks.at(block).successors) {
+        if (blocks.count(successor) != 0 &&
+            (successor == function.entry || functions.count(successor) == 0)) {
+            result.push_back(successor);
+        }
+    }
+    return result;
+}
+
+void CostEstimator::collectBlocks(Function& function) {
+    if (blocks.count(function.entry) == 0) {
+        return;
+    }
+
+    std::vector<uint32_t> pending = {function.entry};
+    std::set<uint32_t> seen       = {function.entry};
+    while (!pending.empty()) {
+        uint32_t block = pending.back();
+        pending.pop_back();
+        for (uint32_t successor : edges(function, block)) {
+            if (seen.insert(successor).second) {
+                pending.push_back(successor);
+            }
+        }
+    }
+    function.blocks.assign(seen.begin(), seen.end());
+}
+
+// Natural loops: an edge back to a block that dominates its source closes a loop made of every
+// block that reaches the source without passing that header. Loops sharing a header are merged.
+void CostEstimator::findLoops(Function& function) {
+    size_t count = function.blocks.size();
+    auto index   = [&](uint32_t block) {
+        return static_cast<size_t>(
+            std::lower_bound(function.blocks.begin(), function.blocks.end(), block) -
+            function.blocks.begin());
+    };
+
+    std::vector<std::vector<size_t>> predecessors(count);
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t successor : edges(function, function.blocks[i])) {
+            predecessors[index(successor)].push_back(i);
+        }
+    }
+
+    size_t entry = index(function.entry);
+    std::vector<std::vector<bool>> dominators(count, std::vector<bool>(count, true));
+    if (count != 0) {
+        dominators[entry].assign(count, false);
+        dominators[entry][entry] = true;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < count; i++) {
+            if (i == entry) {
+                continue;
+            }
+            std::vector<bool> meet(count, !predecessors[i].empty());
+            for (size_t predecessor : predecessors[i]) {
+                for (size_t j = 0; j < count; j++) {
+                    meet[j] = meet[j] && dominators[predecessor][j];
+                }
+            }
+            meet[i] = true;
+            if (meet != dominators[i]) {
+                dominators[i] = std::move(meet);
+                changed       = true;
+            }
+        }
+    }
+
+    std::map<size_t, std::set<size_t>> bodies;
+    for (size_t latch = 0; latch < count; latch++) {
+        for (uint32_t successor : edges(function, function.blocks[latch])) {
+            size_t header = index(successor);
+            if (!dominators[latch][header]) {
+                continue;
+            }
+
+            std::set<size_t>& body = bodies[header];
+            body.insert(header);
+            std::vector<size_t> pending;
+            if (body.insert(latch).second) {
+                pending.push_back(latch);
+            }
+            while (!pending.empty()) {
+                size_t block = pending.back();
+                pending.pop_back();
+                for (size_t predecessor : predecessors[block]) {
+                    if (body.insert(predecessor).second) {
+                        pending.push_back(predecessor);
+                    }
+                }
+            }
+        }
+    }
+
+    for (const auto& [header, body] : bodies) {
+        Loop loop{function.blocks[header], {}, std::nullopt, std::nullopt, std::nullopt};
+        for (size_t block : body) {
+            loop.body.push_back(function.blocks[block]);
+        }
+        function.loops.push_back(std::move(loop));
+    }
+    std::stable_sort(function.loops.begin(), function.loops.end(),
+                     [](const Loop& lhs, const Loop& rhs) {
+                         return lhs.body.size() < rhs.body.size();
+                     });
+}
+
+CostEstimator::Cost CostEstimator::functionCost(uint32_t entry) {
+    Function& function = functions.at(entry);
+    if (function.done) {
+        return function.total;
+    }
+    // Recursion has no static bound.
+    if (function.inProgress) {
+        return std::nullopt;
+    }
+    function.inProgress = true;
+
+    // Every run of the header but the last ends on a back edge and the last one leaves the loop;
+    // a loop that can only leave through a back edge is charged a full iteration instead.
+    for (Loop& loop : function.loops) {
+        loop.iteration = longestPath(function, &loop, PathEnd::Latch).value_or(std::nullopt);
+        loop.exit      = longestPath(function, &loop, PathEnd::Exit).value_or(loop.iteration);
+
+        auto bound = loopBounds.find(loop.header);
+        if (bound == loopBounds.end() || !loop.iteration || !loop.exit) {
+            continue;
+        }
+        loop.total = bound->second == 0 ? 0 : *loop.iteration * (bound->second - 1) + *loop.exit;
+    }
+    function.total = function.blocks.empty()
+                         ? std::nullopt
+                         : longestPath(function, nullptr, PathEnd::Anywhere).value_or(std::nullopt);
+
+    function.inProgress = false;
+    function.done       = true;
+    return function.total;
+}
+
+CostEstimator::Cost CostEstimator::blockCost(const Function& function, const Block& block) {
+    Cost cost = block.ticks;
+    for (uint32_t at = block.begin; at < block.end; at++) {
+        if (opcodeOf(text[at]) == CU::OP_CALL) {
+            cost = add(cost, functionCost(operandOf(text[at])));
+        }
+    }
+    for (uint32_t successor : block.successors) {
+        if (successor != function.entry && functions.count(successor) != 0) {
+            cost = add(cost, functionCost(successor));
+        }
+    }
+    return cost;
+}
+
+// Costliest path from the region's header (the function entry without a region) that stays in
+// the region, does not take a back edge to the header and finishes at a node allowed by end.
+// Loops nested in the region count as single nodes costing their total, which leaves the region's
+// graph acyclic; any other cycle makes the result unbounded. Returns nullopt when no path can
+// finish as asked.
+std::optional<CostEstimator::Cost> CostEstimator::longestPath(Function& function,
+                                                              const Loop* region, PathEnd end) {
+    const std::vector<uint32_t>& area = region != nullptr ? region->body : function.blocks;
+
+    // Loops are innermost first, so the last one that contains the block and is smaller than
+    // the region is the outermost loop nested in it.
+    auto representative = [&](uint32_t block) {
+        Node node{false, block};
+        for (size_t i = 0; i < function.loops.size() && function.loops[i].body.size() < area.size();
+             i++) {
+            if (contains(function.loops[i].body, block)) {
+                node = {true, static_cast<uint32_t>(i)};
+            }
+        }
+        return node;
+    };
+
+    // Where control can go from the node's blocks: targets outside the node, and whether it can
+    // leave the function through ret, iret, halt or a tail call.
+    auto targetsOf = [&](Node node, bool& leavesFunction) {
+        std::vector<uint32_t> members = {node.id};
+        if (node.isLoop) {
+            members = function.loops[node.id].body;
+        }
+
+        std::vector<uint32_t> targets;
+        leavesFunction = false;
+        for (uint32_t block : members) {
+            std::vector<uint32_t> next = edges(function, block);
+            leavesFunction |= next.size() < blocks.at(block).successors.size() ||
+                              blocks.at(block).successors.empty();
+            for (uint32_t successor : next) {
+                if (!contains(members, successor) || !node.isLoop) {
+                    targets.push_back(successor);
+                }
+            }
+        }
+        return targets;
+    };
+
+    auto longer = [](std::optional<Cost> path, Cost cost) -> Cost {
+        if (!path) {
+            return cost;
+        }
+        return *path && cost ? Cost(std::max(**path, *cost)) : std::nullopt;
+    };
+
+    std::map<Node, std::optional<Cost>> memo;
+    std::set<Node> visiting;
+    std::function<std::optional<Cost>(Node)> best = [&](Node node) -> std::optional<Cost> {
+        auto known = memo.find(node);
+        if (known != memo.end()) {
+            return known->second;
+        }
+        if (!visiting.insert(node).second) {
+            return Cost(std::nullopt);
+        }
+
+        bool leavesFunction = false;
+        bool finishes       = end == PathEnd::Anywhere;
+        std::optional<Cost> rest;
+        for (uint32_t target : targetsOf(node, leavesFunction)) {
+            bool backEdge = region != nullptr && target == region->header;
+            finishes |= (end == PathEnd::Latch && backEdge) ||
+                        (end == PathEnd::Exit && !contains(area, target));
+            if (backEdge || !contains(area, target)) {
+                continue;
+            }
+
+            Node next = representative(target);
+            if (next == node) {
+                continue;
+            }
+            std::optional<Cost> cost = best(next);
+            if (cost) {
+                rest = longer(rest, *cost);
+            }
+        }
+        finishes |= end == PathEnd::Exit && leavesFunction;
+        if (finishes) {
+            rest = longer(rest, 0);
+        }
+
+        visiting.erase(node);
+        if (!rest) {
+            return memo[node] = std::nullopt;
+        }
+        Cost own = node.isLoop ? function.loops[node.id].total
+                               : blockCost(function, blocks.at(node.id));
+        return memo[node] = add(own, *rest);
+    };
+
+    return best(region != nullptr ? Node{false, region->header} : representative(function.entry));
+}
+
+CostEstimator::Cost CostEstimator::add(Cost left, Cost right) {
+    return left && right ? Cost(*left + *right) : std::nullopt;
+}
+
+std::string CostEstimator::address(uint32_t address) {
+    std::ostringstream result;
+    result << std::dec << std::setw(4) << std::setfill('0') << address;
+    return result.str();
+}
+
+std::string CostEstimator::ticks(Cost cost) {
+    return cost ? std::to_string(*cost) + " ticks" : "unbounded";
+}
+
+void CostEstimator::writeListing(std::ostream& out) const {
+    out << "; Ticks per instruction on the multicycle CU: FetchAR, FetchIR, microsteps and\n"
+        << "; IncrementIP. Calls add the callee's worst case; a loop runs its header the bound\n"
+        << "; number of times, each run costing the costliest iteration except the last, which\n"
+        << "; costs the costliest way out.\n";
+
+    for (const auto& [entry, function] : functions) {
+        out << "\nfunction " << address(entry) << " (" << function.kind
+            << "): worst case " << ticks(function.total) << "\n";
+
+        for (const Loop& loop : function.loops) {
+            out << "  loop " << address(loop.header) << ": " << ticks(loop.iteration)
+                << " per iteration, " << ticks(loop.exit) << " on exit, ";
+            auto bound = loopBounds.find(loop.header);
+            if (bound == loopBounds.end()) {
+                out << "no bound\n";
+            } else {
+                out << "bound " << bound->second << ", " << ticks(loop.total) << "\n";
+            }
+        }
+
+        for (uint32_t begin : function.blocks) {
+            const Block& block = blocks.at(begin);
+            out << "  block " << address(begin) << ": " << block.ticks << " ticks\n";
+
+            for (uint32_t at = block.begin; at < block.end; at++) {
+                uint8_t code     = opcodeOf(text[at]);
+                uint32_t operand = operandOf(text[at]);
+
+                std::ostringstream line;
+                line << address(at) << " - " << std::hex << std::uppercase << std::setw(BITS_8)
+                     << std::setfill('0') << text[at] << " - " << CU::opcodeStr(code)
+                     << (CU::hasOperand(code) ? (" " + std::to_string(operand)) : "");
+
+                out << "    " << std::left << std::setw(LISTING_COLUMN) << line.str() << std::right
+                    << std::setw(2) << CU::instructionTicks(code);
+
+                bool tailCall = isJump(code) && operand != entry && functions.count(operand) != 0;
+                if (code == CU::OP_CALL || tailCall) {
+                    out << " + " << ticks(functions.at(operand).total) << " in "
+                        << address(operand);
+                }
+                out << "\n";
+            }
+        }
+    }
+}
+
+void CostEstimator::printSummary(std::ostream& out) const {
+    out << "Worst case from entry: " << ticks(functions.at(0).total) << "\n";
+
+    std::vector<uint32_t> unbounded;
+    for (const auto& [entry, function] : functions) {
+        for (const Loop& loop : function.loops) {
+            if (loopBounds.count(loop.header) == 0) {
+                unbounded.push_back(loop.header);
+            }
+        }
+    }
+    if (!unbounded.empty()) {
+        out << "Loops without a bound:";
+        for (uint32_t header : unbounded) {
+            out << " " << address(header);
+        }
+        out << "\n";
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef _COST_ESTIMATOR_H
+#define _COST_ESTIMATOR_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Worst-case tick costs of a program binary on the multicycle CU, found without running it.
+// Every instruction costs CU::instructionTicks(), so straight-line code is exact. A call adds the
+// callee's worst case and a loop adds its bound times its costliest iteration, the last one only
+// as far as the exit; a loop without a bound, or recursion, leaves everything that reaches it
+// unbounded.
+//
+// Entry points follow the translator's layout: the program starts at address 0 and the first two
+// data words are the interrupt vectors. A vector is only taken for a handler when it points at an
+// instruction, so a program without handlers can keep its own data there.
+class CostEstimator {
+public:
+    explicit CostEstimator(const std::string& binaryFile);
+
+    // One `<header address> <iterations>` pair per line, the address as the listing prints it.
+    // The bound is how many times the loop header may run.
+    void loadLoopBounds(const std::string& filename);
+    void analyze();
+
+    void writeListing(std::ostream& out) const;
+    void printSummary(std::ostream& out) const;
+
+private:
+    // Ticks, or nullopt when no bound is known.
+    using Cost = std::optional<uint64_t>;
+
+    struct Block {
+        uint32_t begin;
+        uint32_t end;  // one past the last instruction
+        uint64_t ticks;
+        std::vector<uint32_t> successors;
+    };
+
+    struct Loop {
+        uint32_t header;
+        std::vector<uint32_t> body;  // sorted block addresses
+        Cost iteration;  // header back to the header
+        Cost exit;       // header out of the loop
+        Cost total;
+    };
+
+    struct Function {
+        Function(uint32_t entry, std::string kind) : entry(entry), kind(std::move(kind)) {
+        }
+
+        uint32_t entry;
+        std::string kind;
+        std::vector<uint32_t> blocks;  // sorted
+        std::vector<Loop> loops;       // innermost first
+        Cost total      = std::nullopt;
+        bool inProgress = false;
+        bool done       = false;
+    };
+
+    // Where a path through a region has to finish: anywhere, on a back edge to the region's
+    // header, or on an edge out of the region or the function.
+    enum class PathEnd { Anywhere, Latch, Exit };
+
+    // A block of the function, or a loop of it standing in for all of its blocks.
+    struct Node {
+        bool isLoop;
+        uint32_t id;  // block address or index into Function::loops
+
+        bool operator<(const Node& other) const {
+            return isLoop != other.isLoop ? isLoop < other.isLoop : id < other.id;
+        }
+        bool operator==(const Node& other) const {
+            return isLoop == other.isLoop && id == other.id;
+        }
+    };
+
+    std::vector<uint32_t> text;
+    std::vector<uint32_t> data;
+    std::map<uint32_t, uint64_t> loopBounds;
+
+    std::map<uint32_t, Block> blocks;
+    std::map<uint32_t, Function> functions;
+
+    [[nodiscard]] bool isInstruction(uint32_t address) const;
+    void findBlocks();
+    void findFunctions();
+    void collectBlocks(Function& function);
+    void findLoops(Function& function);
+
+    [[nodiscard]] std::vector<uint32_t> edges(const Function& function, uint32_t block) const;
+    Cost functionCost(uint32_t entry);
+    Cost blockCost(const Function& function, const Block& block);
+    std::optional<Cost> longestPath(Function& function, const Loop* region, PathEnd end);
+
+    static Cost add(Cost left, Cost right);
+    static std::string address(uint32_t address);
+    static std::string ticks(Cost cost);
+};
+
+#endif
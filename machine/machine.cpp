@@ -1,19 +1,65 @@
 #include "configParser.hpp"
+#include "costEstimator.h"
 #include "processorModel.h"
+#include "sweep.h"
 
 int main(int argc, char* argv[]) {
     const std::vector<std::string> args(argv, argv + argc);
 
     try {
         if (argc < 3) {
-            throw std::runtime_error("Usage: ./machine <config> <binary>");
+            throw std::runtime_error(
+                "Usage: ./machine <config> <binary> [--sweep <variants>] [--jobs N] "
+                "[--estimate] [--loop-bounds <file>]");
+        }
+
+        std::string sweepFile;
+        std::string loopBoundsFile;
+        bool estimate = false;
+        size_t jobs   = std::max(1U, std::thread::hardware_concurrency());
+
+        for (size_t i = 3; i < args.size(); i++) {
+            if (args[i] == "--sweep" && i + 1 < args.size()) {
+                sweepFile = args[++i];
+            } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+                jobs = std::stoul(args[++i]);
+            } else if (args[i] == "--estimate") {
+                estimate = true;
+            } else if (args[i] == "--loop-bounds" && i + 1 < args.size()) {
+                loopBoundsFile = args[++i];
+            } else {
+                throw std::runtime_error("Unknown argument: " + args[i]);
+            }
         }
 
         MachineConfig cfg = parseConfig(args[1]);
+
+        // Static costs only; the program is not run.
+        if (estimate) {
+            CostEstimator estimator(args[2]);
+            if (!loopBoundsFile.empty()) {
+                estimator.loadLoopBounds(loopBoundsFile);
+            }
+            estimator.analyze();
+
+            std::ofstream listing(cfg.cost_file);
+            estimator.writeListing(listing);
+            estimator.printSummary(std::cout);
+            std::cout << "Wrote cost listing to " << cfg.cost_file << "\n";
+            return 0;
+        }
+
+        if (!sweepFile.empty()) {
+            Sweep sweep(cfg, args[2]);
+            sweep.loadVariants(sweepFile);
+            sweep.run(jobs);
+            return 0;
+        }
+
         ProcessorModel processorModel(cfg);
         processorModel.loadBinary(args[2]);
         processorModel.process();
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << "\n";
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+// Host-side timing of the simulator's own tick loop. Everything below compiles to nothing unless
+// the machine is built with MACHINE_PROFILE (cmake -DMACHINE_PROFILE=ON).
+
+enum class Phase : uint8_t {
+    IOCheck,
+    Decode,
+    Latches,
+    ALU,
+    RegisterDump,
+    Hash,
+    LogWrite,
+    COUNT
+};
+
+#ifdef MACHINE_PROFILE
+
+inline auto phaseName(Phase phase) -> const char* {
+    switch (phase) {
+        case Phase::IOCheck:
+            return "iosim.check";
+        case Phase::Decode:
+            return "cu.decode";
+        case Phase::Latches:
+            return "latches";
+        case Phase::ALU:
+            return "alu.perform";
+        case Phase::RegisterDump:
+            return "registerDump";
+        case Phase::Hash:
+            return "hash";
+        case Phase::LogWrite:
+            return "log write";
+        default:
+            return "unknown";
+    }
+}
+
+// Totals are atomics because cores may tick on several host threads.
+class PhaseProfiler {
+public:
+    static auto instance() -> PhaseProfiler& {
+        static PhaseProfiler profiler;
+        return profiler;
+    }
+
+    void add(Phase phase, uint64_t nanoseconds) {
+        auto index = static_cast<size_t>(phase);
+        totals.at(index).fetch_add(nanoseconds, std::memory_order_relaxed);
+        calls.at(index).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void report(std::ostream& out, size_t ticks) const {
+        constexpr double NS_PER_MS = 1e6;
+
+        uint64_t sum = 0;
+        for (const auto& total : totals) {
+            sum += total.load(std::memory_order_relaxed);
+        }
+
+        out << "Phase profile (host time, " << ticks << " ticks):\n";
+        for (size_t index = 0; index < totals.size(); index++) {
+            uint64_t total = totals.at(index).load(std::memory_order_relaxed);
+            uint64_t count = calls.at(index).load(std::memory_order_relaxed);
+
+            out << "  " << std::left << std::setw(14) << phaseName(static_cast<Phase>(index))
+                << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+                << static_cast<double>(total) / NS_PER_MS << " ms " << std::setw(6)
+                << (sum != 0 ? 100.0 * static_cast<double>(total) / static_cast<double>(sum) : 0)
+                << "% " << std::setw(8)
+                << (ticks != 0 ? static_cast<double>(total) / static_cast<double>(ticks) : 0)
+                << " ns/tick " << std::setw(10) << count << " calls\n";
+        }
+        out << "  " << std::left << std::setw(14) << "total" << std::right << std::setw(10)
+            << static_cast<double>(sum) / NS_PER_MS << " ms\n";
+    }
+
+private:
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::COUNT);
+
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> totals{};
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> calls{};
+};
+
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {
+    }
+
+    ScopedPhase(const ScopedPhase&)            = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    ScopedPhase(ScopedPhase&&)            = delete;
+    ScopedPhase& operator=(ScopedPhase&&) = delete;
+
+    ~ScopedPhase() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        PhaseProfiler::instance().add(
+            phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_PHASE(phase) ScopedPhase scopedPhase(phase)
+#define PROFILE_REPORT(out, ticks) PhaseProfiler::instance().report(out, ticks)
+
+#else
+
+#define PROFILE_PHASE(phase)
+#define PROFILE_REPORT(out, ticks)
+
+#endif
@@ -1,13 +1,17 @@
 #include "processorModel.h"
 
-ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
-    parseInput();
-    iosim.connectOutput(outputFile);
+Core::Core(Memory& memory, CpuModel model, uint32_t coreId) : memory(memory), id(coreId) {
+    if (id != 0) {
+        stackBase = FULL_MASK_24 - (id * CORE_STACK_WORDS);
+        registers.set(Registers::ACC, id);
+        registers.set(Registers::SP, stackBase);
+    }
 
     mux1.addInput(zero);
     mux1.addInput(registers.getRef(Registers::ACC));
     mux1.addInput(zero);
     mux1.addInput(registers.getRef(Registers::IP));
+    mux1.addInput(registers.getRef(Registers::XR));
 
     mux2.addInput(zero);
     mux2.addInput(registers.getRef(Registers::AR));
@@ -36,11 +40,14 @@ ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
     latchALU_SPC.setSource(alu.getResultRef());
     latchALU_SPC.setTarget(interruptHandler.getSPCRef());
 
+    latchALU_XR.setSource(alu.getResultRef());
+    latchALU_XR.setTarget(registers.getRef(Registers::XR));
+
     latchRouter.setLatches(latchALU_AC, latchALU_AR, latchALU_DR, latchALU_PC, latchALU_SP,
-                           latchALU_SPC);
+                           latchALU_SPC, latchALU_XR);
 
     auto memoryGetter = [this]() -> uint32_t& {
-        return this->memory.at(this->registers.getRef(Registers::AR));
+        return this->memory.load(this->registers.getRef(Registers::AR));
     };
 
     latchMEM_IR.setSourceGetter(memoryGetter);
@@ -50,7 +57,15 @@ ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
     latchMEM_DR.setTarget(registers.getRef(Registers::DR));
 
     latchDR_MEM.setSource(registers.getRef(Registers::DR));
-    latchDR_MEM.setTargetGetter(memoryGetter);
+    latchDR_MEM.setTargetGetter([this]() -> uint32_t& {
+        return this->memory.store(this->registers.getRef(Registers::AR));
+    });
+
+    latchMEM_TAS.setSourceGetter([this]() -> uint32_t& {
+        tasValue = this->memory.testAndSet(this->registers.getRef(Registers::AR));
+        return tasValue;
+    });
+    latchMEM_TAS.setTarget(registers.getRef(Registers::DR));
 
     latchSPC_PC.setSource(interruptHandler.getSPCRef());
     latchSPC_PC.setTarget(registers.getRef(Registers::IP));
@@ -59,20 +74,159 @@ ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
 
     interruptHandler.connect(latchALU_SPC, latchSPC_PC, latchVec_PC);
 
-    iosim.connect(interruptHandler, memory);
+    if (model == CpuModel::PIPELINED) {
+        auto pipelined = std::make_unique<PipelinedCU>();
+        pipelined->connectFetchPort(this->memory, registers.getRef(Registers::IP),
+                                    registers.getRef(Registers::IR),
+                                    registers.getRef(Registers::AR));
+        cu = std::move(pipelined);
+    } else {
+        cu = std::make_unique<CU>();
+    }
+
+    cu->setLog(logChunk);
+    cu->connect(interruptHandler, mux1, mux2, alu, latchRouter, latchMEM_IR, latchMEM_DR,
+                latchDR_MEM, latchMEM_TAS);
+    cu->connectFlags(registers.getFlags());
+    cu->setIRInput(registers.getRef(Registers::IR));
+}
+
+void Core::step() {
+    PerfCounters& counters = cu->getCounters();
+    if (interruptHandler.isAwaitingVector()) {
+        counters.interruptPendingTicks++;
+    }
+
+    {
+        PROFILE_PHASE(Phase::Decode);
+        cu->decode();
+    }
+
+    if (latchVec_PC.isEnabled()) {
+        counters.interruptsTaken++;
+        counters.interruptLatencyTotal += counters.interruptPendingTicks;
+        counters.interruptLatencyMax =
+            std::max(counters.interruptLatencyMax, counters.interruptPendingTicks);
+        counters.interruptPendingTicks = 0;
+    }
+    if (latchMEM_IR.isEnabled() || latchMEM_DR.isEnabled() || latchMEM_TAS.isEnabled()) {
+        counters.memoryReads++;
+    }
+    if (latchDR_MEM.isEnabled() || latchMEM_TAS.isEnabled()) {
+        counters.memoryWrites++;
+    }
+
+    {
+        PROFILE_PHASE(Phase::Latches);
+        latchSPC_PC.propagate();
+        latchVec_PC.propagate();
+
+        latchMEM_IR.propagate();
+        latchMEM_DR.propagate();
+        latchDR_MEM.propagate();
+        latchMEM_TAS.propagate();
+    }
+    {
+        PROFILE_PHASE(Phase::ALU);
+        alu.perform();
+    }
+    {
+        PROFILE_PHASE(Phase::Latches);
+        latchRouter.propagate();
+
+        latchSPC_PC.setEnabled(false);
+        latchVec_PC.setEnabled(false);
+
+        latchMEM_IR.setEnabled(false);
+        latchMEM_DR.setEnabled(false);
+        latchDR_MEM.setEnabled(false);
+        latchMEM_TAS.setEnabled(false);
+        alu.setOperation(ALU::Operation::NOP);
+        alu.setWriteFlags(false);
+        latchRouter.setLatchStates({0, 0, 0, 0, 0, 0, 0});
+    }
+
+    uint32_t stackPointer = registers.get(Registers::SP);
+    if (stackPointer <= stackBase) {
+        counters.maxStackDepth = std::max(counters.maxStackDepth, stackBase - stackPointer);
+    }
+}
+
+Core::Snapshot Core::saveState() const {
+    Snapshot snapshot{};
+    for (size_t reg = 0; reg < Registers::REG_COUNT; reg++) {
+        snapshot.regs.at(reg) = registers.get(static_cast<Registers::RegName>(reg));
+    }
+    snapshot.flags        = *registers.getFlags();
+    snapshot.mux1Selected = mux1.getSelectedIndex();
+    snapshot.mux2Selected = mux2.getSelectedIndex();
+    snapshot.cu           = cu->saveState();
+    snapshot.interrupts   = interruptHandler.saveState();
+    return snapshot;
+}
+
+void Core::restoreState(const Snapshot& snapshot) {
+    for (size_t reg = 0; reg < Registers::REG_COUNT; reg++) {
+        registers.set(static_cast<Registers::RegName>(reg), snapshot.regs.at(reg));
+    }
+    *registers.getFlags() = snapshot.flags;
+    mux1.select(snapshot.mux1Selected);
+    mux2.select(snapshot.mux2Selected);
+    cu->restoreState(snapshot.cu);
+    interruptHandler.restoreState(snapshot.interrupts);
+}
+
+std::string Core::registerDump() {
+    std::ostringstream result;
+    result << std::hex;
+    result << "AC: 0x" << registers.get(Registers::ACC) << "\n";
+    result << "IR: 0x" << registers.get(Registers::IR) << "\n";
+    result << "AR: 0x" << registers.get(Registers::AR) << "\n";
+    result << "DR: 0x" << registers.get(Registers::DR) << "\n";
+    result << "PC: 0x" << registers.get(Registers::IP) << "\n";
+    result << "SP: 0x" << registers.get(Registers::SP) << "\n";
+    result << "XR: 0x" << registers.get(Registers::XR) << "\n";
+
+    FlagsRegister* flags = registers.getFlags().get();
+
+    result << "NZVC: " << flags->N << flags->Z << flags->V << flags->C << "\n";
+    return result.str();
+}
+
+ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
+    if (cfg.cores == 0 || cfg.cores > MAX_CORES) {
+        throw std::runtime_error("cores must be between 1 and " + std::to_string(MAX_CORES));
+    }
+    if (cfg.sync_quantum == 0) {
+        throw std::runtime_error("sync_quantum must be positive");
+    }
 
-    cu.setLog(logChunk);
-    cu.connect(interruptHandler, mux1, mux2, alu, latchRouter, latchMEM_IR, latchMEM_DR,
-               latchDR_MEM);
-    cu.connectFlags(registers.getFlags());
-    cu.setIRInput(registers.getRef(Registers::IR));
+    parseInput();
+    iosim.connectOutput(outputFile);
+
+    for (uint32_t coreId = 0; coreId < cfg.cores; coreId++) {
+        cores.push_back(std::make_unique<Core>(memory, cfg.cpu_model, coreId));
+    }
+    coreTicks.assign(cfg.cores, 0);
+    logFiles.resize(cfg.cores);
+    hashers.resize(cfg.cores);
+
+    // Only core 0 is wired to the I/O device.
+    iosim.connect(cores.front()->getInterruptHandler(), cores.front()->getMemoryPort());
 
     if (!cfg.output_file.empty()) {
         outputFile.open(cfg.output_file, std::ios::out);
     }
 
     if (!cfg.log_file.empty()) {
-        logFile.open(cfg.log_file, std::ios::out);
+        if (cfg.cores == 1) {
+            logFiles.front().open(cfg.log_file, std::ios::out);
+        } else {
+            for (size_t coreId = 0; coreId < cfg.cores; coreId++) {
+                logFiles[coreId].open(cfg.log_file + ".core" + std::to_string(coreId),
+                                      std::ios::out);
+            }
+        }
     }
 
     if (!cfg.binary_repr_file.empty()) {
@@ -82,6 +236,10 @@ ProcessorModel::ProcessorModel(MachineConfig& cfg) : cfg(cfg) {
     if (!cfg.log_hash_file.empty()) {
         logHashFile.open(cfg.log_hash_file, std::ios::out);
     }
+
+    if (!cfg.stats_file.empty()) {
+        statsFile.open(cfg.stats_file, std::ios::out);
+    }
 }
 
 bool ProcessorModel::isNumberArray(const std::string& val) {
@@ -147,8 +305,16 @@ std::vector<int> ProcessorModel::parseTokenStr(const std::string& tokenStr) {
 };
 
 void ProcessorModel::parseInput() {
+    for (const auto& entry : readInputSchedule(cfg)) {
+        iosim.addInput(entry);
+    }
+}
+
+std::vector<IOSimulator::IOScheduleEntry> ProcessorModel::readInputSchedule(
+    const MachineConfig& cfg) {
+    std::vector<IOSimulator::IOScheduleEntry> schedule;
     if (cfg.input_file.empty()) {
-        return;
+        return schedule;
     }
     std::ifstream inputFile(cfg.input_file);
     if (!inputFile.is_open()) {
@@ -173,11 +339,11 @@ void ProcessorModel::parseInput() {
         std::string data = buffer.str();
 
         for (const auto& character : data) {
-            iosim.addInput({currentTick, static_cast<int>(character)});
+            schedule.push_back({currentTick, static_cast<int>(character)});
             currentTick += cfg.schedule_offset;
         }
 
-        iosim.addInput({currentTick, 4});
+        schedule.push_back({currentTick, 4});
     } else if (cfg.input_mode == InputMode::MODE_TOKEN) {
         std::string line;
         while (std::getline(inputFile, line)) {
@@ -195,23 +361,71 @@ void ProcessorModel::parseInput() {
 
             auto values = parseTokenStr(tokenStr);
             for (int val : values) {
-                iosim.addInput({tick, val});
+                schedule.push_back({tick, val});
             }
         }
     }
+
+    return schedule;
 }
 
 void ProcessorModel::process() {
+    run();
+    report();
+}
+
+void ProcessorModel::run() {
+    if (!binaryLoaded) {
+        throw std::runtime_error("Binary not loaded");
+    }
+
+    if (cores.size() == 1) {
+        Core& core = *cores.front();
+        while (!core.isHalted()) {
+            tick(core, tickCount);
+            tickCount++;
+        }
+        coreTicks.front() = tickCount;
+    } else {
+        runParallel();
+    }
+}
+
+// Single-stepping warm-up used before snapshotting; cores advance in lockstep on this thread.
+void ProcessorModel::runUntil(size_t endTick) {
     if (!binaryLoaded) {
         throw std::runtime_error("Binary not loaded");
     }
 
-    while (!cu.isHalted()) {
-        tick();
+    while (tickCount < endTick && !isHalted()) {
+        for (auto& core : cores) {
+            if (!core->isHalted()) {
+                tick(*core, tickCount);
+                coreTicks[core->getId()] = tickCount + 1;
+            } else if (core->getId() == 0) {
+                iosim.check(tickCount);
+            }
+        }
         tickCount++;
     }
+}
 
+bool ProcessorModel::isHalted() const {
+    return std::all_of(cores.begin(), cores.end(),
+                       [](const std::unique_ptr<Core>& core) { return core->isHalted(); });
+}
+
+void ProcessorModel::report() {
     std::cout << "Completed in " << tickCount << " ticks\n";
+    if (cores.size() == 1) {
+        std::cout << cores.front()->getCU().summary(tickCount) << "\n";
+    } else {
+        for (const auto& core : cores) {
+            std::cout << "Core " << core->getId() << ": halted at tick " << coreTicks[core->getId()]
+                      << ", " << core->getCU().summary(coreTicks[core->getId()]) << "\n";
+        }
+    }
+    PROFILE_REPORT(std::cout, tickCount);
 
     if (!cfg.output_file.empty()) {
         outputFile.close();
@@ -219,9 +433,12 @@ void ProcessorModel::process() {
     }
 
     if (!cfg.log_file.empty()) {
-        logFile << memDump();
-        logFile.close();
-        std::cout << "Wrote log to " << cfg.log_file << "\n";
+        logFiles.front() << memDump();
+        for (auto& logFile : logFiles) {
+            logFile.close();
+        }
+        std::cout << "Wrote log to " << cfg.log_file << (cores.size() == 1 ? "" : ".core*")
+                  << "\n";
     }
 
     if (!cfg.binary_repr_file.empty()) {
@@ -230,10 +447,264 @@ void ProcessorModel::process() {
     }
 
     if (!cfg.log_hash_file.empty()) {
-        logHashFile << std::hex << hasher.final();
+        for (size_t coreId = 0; coreId < hashers.size(); coreId++) {
+            logHashFile << (coreId == 0 ? "" : "\n") << std::hex << hashers[coreId].final();
+        }
         logHashFile.close();
         std::cout << "Wrote log hash to " << cfg.log_hash_file << "\n";
     }
+
+    if (!cfg.stats_file.empty()) {
+        writeStats();
+        statsFile.close();
+        std::cout << "Wrote stats to " << cfg.stats_file << "\n";
+    }
+}
+
+void ProcessorModel::writeStats() {
+    statsFile << "{\n";
+    statsFile << "  \"ticks\": " << tickCount << ",\n";
+    statsFile << "  \"io_tokens_in\": " << iosim.deliveredInputs(tickCount) << ",\n";
+    statsFile << "  \"io_tokens_out\": " << iosim.getOutputSchedule().size() << ",\n";
+    statsFile << "  \"cores\": [\n";
+
+    for (const auto& core : cores) {
+        const CU& cu                 = core->getCU();
+        const PerfCounters& counters = cu.getCounters();
+        size_t ticks                 = coreTicks[core->getId()];
+        size_t retired               = cu.getRetiredCount();
+        double cpi                   =
+            retired != 0 ? static_cast<double>(ticks) / static_cast<double>(retired) : 0;
+
+        statsFile << "    {\n";
+        statsFile << "      \"ticks\": " << ticks << ",\n";
+        statsFile << "      \"instructions_retired\": " << retired << ",\n";
+        statsFile << "      \"cpi\": " << std::fixed << std::setprecision(3) << cpi << ",\n";
+        statsFile << "      \"state_ticks\": {\"FetchAR\": " << counters.stateTicks[0]
+                  << ", \"FetchIR\": " << counters.stateTicks[1]
+                  << ", \"Decode\": " << counters.stateTicks[2]
+                  << ", \"IncrementIP\": " << counters.stateTicks[3] << "},\n";
+        statsFile << "      \"pipeline_ticks\": {\"Execute\": " << counters.executeTicks
+                  << ", \"FetchStall\": " << counters.fetchStallTicks
+                  << ", \"InterruptEntry\": " << counters.interruptEntryTicks << "},\n";
+        statsFile << "      \"interrupts_taken\": " << counters.interruptsTaken << ",\n";
+        statsFile << "      \"interrupt_latency_total\": " << counters.interruptLatencyTotal
+                  << ",\n";
+        statsFile << "      \"interrupt_latency_max\": " << counters.interruptLatencyMax << ",\n";
+        statsFile << "      \"memory_reads\": " << counters.memoryReads << ",\n";
+        statsFile << "      \"memory_writes\": " << counters.memoryWrites << ",\n";
+        statsFile << "      \"branches_taken\": " << counters.branchesTaken << ",\n";
+        statsFile << "      \"branches_not_taken\": " << counters.branchesNotTaken << ",\n";
+        statsFile << "      \"max_stack_depth\": " << counters.maxStackDepth << "\n";
+        statsFile << "    }" << (core->getId() + 1 < cores.size() ? "," : "") << "\n";
+    }
+
+    statsFile << "  ]\n";
+    statsFile << "}\n";
+}
+
+ProcessorModel::Snapshot ProcessorModel::saveState() const {
+    if (!binaryLoaded) {
+        throw std::runtime_error("Binary not loaded");
+    }
+
+    Snapshot snapshot{};
+    snapshot.memory    = memory.nonZeroWords();
+    snapshot.coreTicks = coreTicks;
+    snapshot.hashers   = hashers;
+    snapshot.output    = iosim.getOutputSchedule();
+    snapshot.tickCount = tickCount;
+    snapshot.textSize  = textSize;
+    snapshot.dataSize  = dataSize;
+    snapshot.dataStart = dataStart;
+    for (const auto& core : cores) {
+        snapshot.cores.push_back(core->saveState());
+    }
+    return snapshot;
+}
+
+// Restoring is only supported into a model that has not loaded a binary yet, so memory is still
+// all zeroes and only the non-zero words of the snapshot need to be written.
+void ProcessorModel::restoreState(const Snapshot& snapshot) {
+    if (binaryLoaded) {
+        throw std::runtime_error("Snapshot must be restored into a fresh machine");
+    }
+    if (snapshot.cores.size() != cores.size()) {
+        throw std::runtime_error("Snapshot core count doesn't match cores");
+    }
+
+    for (const auto& [address, value] : snapshot.memory) {
+        memory[address] = value;
+    }
+    for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+        cores[coreId]->restoreState(snapshot.cores[coreId]);
+    }
+
+    coreTicks = snapshot.coreTicks;
+    hashers   = snapshot.hashers;
+    iosim.restoreOutput(snapshot.output);
+
+    tickCount    = snapshot.tickCount;
+    textSize     = snapshot.textSize;
+    dataSize     = snapshot.dataSize;
+    dataStart    = snapshot.dataStart;
+    binaryLoaded = true;
+}
+
+void ProcessorModel::captureOutput(std::ostream& stream) {
+    iosim.connectOutput(stream);
+}
+
+// Every core steps its quantum on a host thread of its own, through a MemoryPort that keeps its
+// writes to itself until the barrier; core 0 also polls the I/O device, whose output is held back
+// likewise. The last thread to arrive then finishes the quantum for everybody. When no core wrote
+// a word another core read or wrote, the cores could not have seen each other, so committing the
+// ports in core order gives exactly what stepping them in lockstep would have. Otherwise the
+// quantum is undone and stepped again in lockstep on that thread, which is also done for the
+// quantum in which the last core stops, so that core 0 polls I/O up to the right tick. Either way
+// the results do not depend on sync_quantum or on how the host schedules the threads. After the
+// barrier each thread records its core's log and goes on with the next quantum. A halted core is
+// skipped, except that core 0 keeps polling the I/O device so output written by the other cores
+// is still delivered.
+void ProcessorModel::runParallel() {
+    QuantumBarrier barrier(cores.size());
+    std::vector<CoreRun> runs(cores.size());
+    size_t quantumEnd = 0;
+
+    auto startQuantum = [&] {
+        quantumEnd = tickCount + cfg.sync_quantum;
+        for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+            runs[coreId].start          = cores[coreId]->saveState();
+            runs[coreId].stoppedAtStart = runs[coreId].stopped;
+            cores[coreId]->getMemoryPort().startBuffering();
+        }
+        iosim.holdOutput();
+    };
+
+    auto work = [&](size_t coreId) {
+        for (;;) {
+            stepQuantum(coreId, quantumEnd, runs[coreId]);
+            bool finished = barrier.arriveAndWait([&] {
+                bool done = finishQuantum(quantumEnd, runs);
+                if (!done) {
+                    startQuantum();
+                }
+                return done;
+            });
+            recordLog(coreId, runs[coreId].log);
+            runs[coreId].log.clear();
+            if (finished) {
+                break;
+            }
+        }
+    };
+
+    startQuantum();
+    std::vector<std::thread> threads;
+    threads.reserve(cores.size());
+    for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+        threads.emplace_back(work, coreId);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // The failure lockstep stepping would have hit first: earliest tick, then lowest core.
+    const CoreRun* failed = nullptr;
+    size_t failedTick     = 0;
+    for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+        if (runs[coreId].failure && (failed == nullptr || coreTicks[coreId] < failedTick)) {
+            failed     = &runs[coreId];
+            failedTick = coreTicks[coreId];
+        }
+    }
+    if (failed != nullptr) {
+        std::rethrow_exception(failed->failure);
+    }
+
+    tickCount = *std::max_element(coreTicks.begin(), coreTicks.end());
+    iosim.check(tickCount);
+}
+
+void ProcessorModel::stepRun(size_t coreId, size_t tick, CoreRun& run) {
+    Core& core = *cores[coreId];
+    try {
+        stepCore(core, tick);
+        run.log += core.getLog();
+    } catch (...) {
+        run.failure = std::current_exception();
+        run.stopped = true;
+    }
+    if (run.stopped || core.isHalted()) {
+        run.stopped       = true;
+        coreTicks[coreId] = tick + 1;
+    }
+}
+
+void ProcessorModel::stepQuantum(size_t coreId, size_t quantumEnd, CoreRun& run) {
+    for (size_t tick = tickCount; tick < quantumEnd; tick++) {
+        if (!run.stopped) {
+            stepRun(coreId, tick, run);
+        } else if (coreId == 0) {
+            iosim.check(tick);
+        } else {
+            break;
+        }
+    }
+}
+
+void ProcessorModel::stepLockstep(size_t quantumEnd, std::vector<CoreRun>& runs) {
+    for (; tickCount < quantumEnd && !allStopped(runs); tickCount++) {
+        for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+            if (!runs[coreId].stopped) {
+                stepRun(coreId, tickCount, runs[coreId]);
+            } else if (coreId == 0) {
+                iosim.check(tickCount);
+            }
+        }
+    }
+}
+
+bool ProcessorModel::finishQuantum(size_t quantumEnd, std::vector<CoreRun>& runs) {
+    auto conflict = [this] {
+        for (const auto& core : cores) {
+            for (const auto& other : cores) {
+                if (core != other && core->getMemoryPort().conflictsWith(other->getMemoryPort())) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    if (!allStopped(runs) && !conflict()) {
+        for (auto& core : cores) {
+            core->getMemoryPort().commit();
+        }
+        iosim.commitOutput();
+        tickCount = quantumEnd;
+        return false;
+    }
+
+    for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+        CoreRun& run = runs[coreId];
+        cores[coreId]->getMemoryPort().discard();
+        cores[coreId]->restoreState(run.start);
+        run.log.clear();
+        if (!run.stoppedAtStart) {
+            run.stopped       = false;
+            run.failure       = nullptr;
+            coreTicks[coreId] = 0;
+        }
+    }
+    iosim.discardOutput();
+
+    stepLockstep(quantumEnd, runs);
+    return allStopped(runs);
+}
+
+bool ProcessorModel::allStopped(const std::vector<CoreRun>& runs) {
+    return std::all_of(runs.begin(), runs.end(), [](const CoreRun& run) { return run.stopped; });
 }
 
 uint32_t ProcessorModel::read_uint32(std::ifstream& inFile) {
@@ -293,7 +764,9 @@ void ProcessorModel::loadBinary(const std::string& filename) {
     uint32_t defaultVector = memory[dataStart + 0];
     uint32_t inputVector   = memory[dataStart + 1];
 
-    interruptHandler.setVectorTable(defaultVector, inputVector);
+    for (auto& core : cores) {
+        core->getInterruptHandler().setVectorTable(defaultVector, inputVector);
+    }
 }
 
 std::string ProcessorModel::memDump() {
@@ -317,53 +790,33 @@ std::string ProcessorModel::memDump() {
     return oss.str();
 }
 
-std::string ProcessorModel::registerDump() {
-    std::ostringstream result;
-    result << std::hex;
-    result << "AC: 0x" << registers.get(Registers::ACC) << "\n";
-    result << "IR: 0x" << registers.get(Registers::IR) << "\n";
-    result << "AR: 0x" << registers.get(Registers::AR) << "\n";
-    result << "DR: 0x" << registers.get(Registers::DR) << "\n";
-    result << "PC: 0x" << registers.get(Registers::IP) << "\n";
-    result << "SP: 0x" << registers.get(Registers::SP) << "\n";
-
-    FlagsRegister* flags = registers.getFlags().get();
-
-    result << "NZVC: " << flags->N << flags->Z << flags->V << flags->C << "\n";
-    return result.str();
+void ProcessorModel::tick(Core& core, size_t tick) {
+    stepCore(core, tick);
+    recordLog(core.getId(), core.getLog());
 }
 
-void ProcessorModel::tick() {
-    logChunk = "tick #" + std::to_string(tickCount) + "\n";
+void ProcessorModel::stepCore(Core& core, size_t tick) {
+    std::string& logChunk = core.getLog();
+    logChunk              = "tick #" + std::to_string(tick) + "\n";
 
-    iosim.check(tickCount);
-    cu.decode();
-
-    latchSPC_PC.propagate();
-    latchVec_PC.propagate();
-
-    latchMEM_IR.propagate();
-    latchMEM_DR.propagate();
-    latchDR_MEM.propagate();
-    alu.perform();
-    latchRouter.propagate();
-
-    latchSPC_PC.setEnabled(false);
-    latchVec_PC.setEnabled(false);
+    if (core.getId() == 0) {
+        PROFILE_PHASE(Phase::IOCheck);
+        iosim.check(tick);
+    }
+    core.step();
 
-    latchMEM_IR.setEnabled(false);
-    latchMEM_DR.setEnabled(false);
-    latchDR_MEM.setEnabled(false);
-    alu.setOperation(ALU::Operation::NOP);
-    alu.setWriteFlags(false);
-    latchRouter.setLatchStates({0, 0, 0, 0, 0, 0});
+    PROFILE_PHASE(Phase::RegisterDump);
+    logChunk += core.registerDump() + "\n";
+}
 
-    logChunk += registerDump() + "\n";
+void ProcessorModel::recordLog(size_t coreId, const std::string& log) {
     if (!cfg.log_hash_file.empty()) {
-        hasher.update(logChunk.data(), logChunk.size());
+        PROFILE_PHASE(Phase::Hash);
+        hashers[coreId].update(log.data(), log.size());
     }
     if (!cfg.log_file.empty()) {
-        logFile << logChunk;
+        PROFILE_PHASE(Phase::LogWrite);
+        logFiles[coreId] << log;
     }
 }
 
@@ -397,6 +850,9 @@ void InterruptHandler::step() {
 
 void CU::decode() {
     log("State " + stateStr());
+    if (state != CPUState::Halt) {
+        counters.stateTicks.at(static_cast<size_t>(state))++;
+    }
 
     if ((interruptHandler->shouldInterrupt() || interruptHandler->isEnteringInterrupt()) &&
         state == CPUState::FetchAR) {
@@ -430,6 +886,7 @@ void CU::decode() {
             if (instructionDone) {
                 instructionDone = false;
                 state           = CPUState::IncrementIP;
+                retired++;
             }
 
             break;
@@ -451,6 +908,57 @@ void CU::decode() {
     }
 }
 
+std::string CU::summary(size_t ticks) const {
+    std::ostringstream oss;
+    oss << "Retired " << retired << " instructions";
+    if (retired != 0) {
+        oss << ", CPI " << std::fixed << std::setprecision(2)
+            << static_cast<double>(ticks) / static_cast<double>(retired);
+    }
+    return oss.str();
+}
+
+CU::Snapshot CU::saveState() const {
+    Snapshot snapshot{};
+    snapshot.state           = state;
+    snapshot.microstep       = microstep;
+    snapshot.opcode          = opcode;
+    snapshot.operand         = operand;
+    snapshot.instructionDone = instructionDone;
+    snapshot.halted          = halted;
+    snapshot.retired         = retired;
+    snapshot.counters        = counters;
+    return snapshot;
+}
+
+void CU::restoreState(const Snapshot& snapshot) {
+    state           = snapshot.state;
+    microstep       = snapshot.microstep;
+    opcode          = snapshot.opcode;
+    operand         = snapshot.operand;
+    instructionDone = snapshot.instructionDone;
+    halted          = snapshot.halted;
+    retired         = snapshot.retired;
+    counters        = snapshot.counters;
+}
+
+void CU::branch(bool taken) {
+    mux1->select(2);
+    mux2->select(0);
+
+    if (taken) {
+        latchRouter->setLatchState(latchPC_index, 1);
+        alu->setOperation(ALU::Operation::DEC);
+        counters.branchesTaken++;
+    } else {
+        latchRouter->setLatchStates({0, 0, 0, 0, 0, 0, 0});
+        alu->setOperation(ALU::Operation::NOP);
+        counters.branchesNotTaken++;
+    }
+
+    instructionDone = true;
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void CU::instructionTick() {
     log("Instruction step #" + std::to_string(microstep));
@@ -463,6 +971,11 @@ void CU::instructionTick() {
         case OP_DIV:
         case OP_MUL:
         case OP_REM:
+        case OP_SHL:
+        case OP_SHR:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
             switch (microstep) {
                 case 0:
                     mux1->select(2);
@@ -495,6 +1008,16 @@ void CU::instructionTick() {
                         alu->setOperation(ALU::Operation::MUL);
                     } else if (opcode == OP_REM) {
                         alu->setOperation(ALU::Operation::REM);
+                    } else if (opcode == OP_SHL) {
+                        alu->setOperation(ALU::Operation::SHL);
+                    } else if (opcode == OP_SHR) {
+                        alu->setOperation(ALU::Operation::SHR);
+                    } else if (opcode == OP_AND) {
+                        alu->setOperation(ALU::Operation::AND);
+                    } else if (opcode == OP_OR) {
+                        alu->setOperation(ALU::Operation::OR);
+                    } else if (opcode == OP_XOR) {
+                        alu->setOperation(ALU::Operation::XOR);
                     }
 
                     latchRouter->setLatchState(latchAC_index, 1);
@@ -577,153 +1100,44 @@ void CU::instructionTick() {
             break;
 
         case OP_JZ:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->Z) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->Z);
             break;
 
         case OP_JNZ:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (!flags->Z) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(!flags->Z);
             break;
 
         case OP_JG:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (!flags->Z && flags->N == flags->V) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(!flags->Z && flags->N == flags->V);
             break;
 
         case OP_JGE:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->N == flags->V) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->N == flags->V);
             break;
 
         case OP_JL:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->N != flags->V) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->N != flags->V);
             break;
 
         case OP_JLE:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->Z || flags->N != flags->V) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->Z || flags->N != flags->V);
             break;
 
+        // SUB/CMP set C when no borrow occurred (left >= right unsigned).
         case OP_JA:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (!flags->C && !flags->Z) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->C && !flags->Z);
             break;
 
         case OP_JAE:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (!flags->C) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(flags->C);
             break;
 
         case OP_JB:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->C) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(!flags->C);
             break;
 
         case OP_JBE:
-            mux1->select(2);
-            mux2->select(0);
-
-            if (flags->C || flags->Z) {
-                latchRouter->setLatchState(latchPC_index, 1);
-                alu->setOperation(ALU::Operation::DEC);
-            } else {
-                latchRouter->setLatchStates({0, 0, 0, 0, 0, 0});
-                alu->setOperation(ALU::Operation::NOP);
-            }
-
-            instructionDone = true;
+            branch(!flags->C || flags->Z);
             break;
 
         case OP_PUSH:
@@ -1095,7 +1509,394 @@ void CU::instructionTick() {
             instructionDone = true;
             break;
 
+        case OP_TAS:
+            switch (microstep) {
+                case 0:
+                    mux1->select(2);
+                    mux2->select(0);
+
+                    alu->setOperation(ALU::Operation::NOP);
+
+                    latchRouter->setLatchState(latchAR_index, 1);
+
+                    microstep++;
+                    break;
+                case 1:
+                    latchMEM_TAS->setEnabled(true);
+                    microstep++;
+                    break;
+                case 2:
+                    mux1->select(0);
+                    mux2->select(2);
+
+                    alu->setOperation(ALU::Operation::NOP);
+                    alu->setWriteFlags(true);
+
+                    latchRouter->setLatchState(latchAC_index, 1);
+
+                    microstep       = 0;
+                    instructionDone = true;
+                    break;
+            }
+            break;
+
+        // Stack-relative forms: the operand is a word offset from SP, so `lds 1` reads the
+        // last word pushed.
+        case OP_LDS:
+            switch (microstep) {
+                case 0:
+                    mux1->select(2);
+                    mux2->select(3);
+
+                    alu->setOperation(ALU::Operation::ADD);
+
+                    latchRouter->setLatchState(latchAR_index, 1);
+
+                    microstep++;
+                    break;
+                case 1:
+                    latchMEM_DR->setEnabled(true);
+                    microstep++;
+                    break;
+                case 2:
+                    latchMEM_DR->setEnabled(false);
+
+                    mux1->select(0);
+                    mux2->select(2);
+
+                    alu->setOperation(ALU::Operation::NOP);
+                    alu->setWriteFlags(true);
+
+                    latchRouter->setLatchState(latchAC_index, 1);
+
+                    microstep       = 0;
+                    instructionDone = true;
+                    break;
+            }
+            break;
+
+        case OP_STS:
+            switch (microstep) {
+                case 0:
+                    mux1->select(2);
+                    mux2->select(3);
+
+                    alu->setOperation(ALU::Operation::ADD);
+
+                    latchRouter->setLatchState(latchAR_index, 1);
+
+                    microstep++;
+                    break;
+                case 1:
+                    mux1->select(1);
+                    mux2->select(0);
+
+                    alu->setOperation(ALU::Operation::NOP);
+
+                    latchRouter->setLatchState(latchDR_index, 1);
+
+                    microstep++;
+                    break;
+                case 2:
+                    latchDR_MEM->setEnabled(true);
+                    microstep       = 0;
+                    instructionDone = true;
+                    break;
+            }
+            break;
+
+        // SP += operand, sign-extended from 24 bits so one instruction both reserves and drops
+        // stack words. Flags are left alone.
+        case OP_ADSP:
+            if ((operand & MSB_MASK_24) != 0) {
+                operand |= ~FULL_MASK_24;
+            }
+
+            mux1->select(2);
+            mux2->select(3);
+
+            alu->setOperation(ALU::Operation::ADD);
+
+            latchRouter->setLatchState(latchSP_index, 1);
+
+            instructionDone = true;
+            break;
+
+        case OP_TAX:
+            mux1->select(1);
+            mux2->select(0);
+
+            alu->setOperation(ALU::Operation::NOP);
+
+            latchRouter->setLatchState(latchXR_index, 1);
+
+            instructionDone = true;
+            break;
+
+        // Indexed forms: the operand holds an array pointer and AC the element index, so the
+        // element sits at MEM[operand] + 1 + AC, past the length word.
+        case OP_LDX:
+        case OP_STX:
+            switch (microstep) {
+                case 0:
+                    mux1->select(2);
+                    mux2->select(0);
+
+                    alu->setOperation(ALU::Operation::NOP);
+
+                    latchRouter->setLatchState(latchAR_index, 1);
+
+                    microstep++;
+                    break;
+                case 1:
+                    latchMEM_DR->setEnabled(true);
+                    microstep++;
+                    break;
+                case 2:
+                    latchMEM_DR->setEnabled(false);
+
+                    mux1->select(1);
+                    mux2->select(2);
+
+                    alu->setOperation(ALU::Operation::INC);
+
+                    latchRouter->setLatchState(latchAR_index, 1);
+
+                    microstep++;
+                    break;
+                case 3:
+                    if (opcode == OP_LDX) {
+                        latchMEM_DR->setEnabled(true);
+                    } else {
+                        mux1->select(4);
+                        mux2->select(0);
+
+                        alu->setOperation(ALU::Operation::NOP);
+
+                        latchRouter->setLatchState(latchDR_index, 1);
+                    }
+                    microstep++;
+                    break;
+                case 4:
+                    if (opcode == OP_LDX) {
+                        latchMEM_DR->setEnabled(false);
+
+                        mux1->select(0);
+                        mux2->select(2);
+
+                        alu->setOperation(ALU::Operation::NOP);
+                        alu->setWriteFlags(true);
+
+                        latchRouter->setLatchState(latchAC_index, 1);
+                    } else {
+                        latchDR_MEM->setEnabled(true);
+                    }
+                    microstep       = 0;
+                    instructionDone = true;
+                    break;
+            }
+            break;
+
         default:
             throw std::runtime_error("Unknown opcode");
     }
-}
\ No newline at end of file
+}
+// clang-format off
+PipelinedCU::StepUse PipelinedCU::firstStepUse(uint8_t code) {
+    switch (static_cast<Opcode>(code)) {
+        case OP_ADD: case OP_SUB: case OP_DIV: case OP_MUL: case OP_REM:
+        case OP_SHL: case OP_SHR: case OP_AND: case OP_OR:  case OP_XOR:
+        case OP_CMP: case OP_LD:  case OP_LDA: case OP_ST:  case OP_STA:
+        case OP_TAS: case OP_LDX: case OP_STX:
+            return {0, RES_AR | RES_ALU};
+        case OP_TAX:
+            return {RES_ACC, RES_XR | RES_ALU};
+        case OP_LDS: case OP_STS:
+            return {RES_SP, RES_AR | RES_ALU};
+        case OP_ADSP:
+            return {RES_SP, RES_SP | RES_ALU};
+        case OP_INC: case OP_DEC: case OP_NOT:
+            return {RES_ACC, RES_ACC | RES_FLAGS | RES_ALU};
+        case OP_CLA:
+            return {0, RES_ACC | RES_ALU};
+        case OP_JMP:
+            return {0, RES_IP | RES_ALU};
+        case OP_JZ: case OP_JNZ: case OP_JG: case OP_JGE: case OP_JL:
+        case OP_JLE: case OP_JA: case OP_JAE: case OP_JB: case OP_JBE:
+            return {RES_FLAGS, RES_IP | RES_ALU};
+        case OP_PUSH: case OP_CALL:
+            return {RES_SP, RES_AR | RES_ALU};
+        case OP_POP: case OP_RET:
+            return {RES_SP, RES_SP | RES_ALU};
+        case OP_LDI:
+            return {0, RES_ACC | RES_FLAGS | RES_ALU};
+        case OP_EI: case OP_DI:
+            return {0, RES_IE};
+        case OP_IRET:
+            return {0, RES_IP | RES_ALU};
+        case OP_HALT:
+            return {0, 0};
+        default:
+            return {0xFFFF, 0xFFFF};
+    }
+}
+
+PipelinedCU::StepUse PipelinedCU::lastStepUse(uint8_t code) {
+    switch (static_cast<Opcode>(code)) {
+        case OP_ADD: case OP_SUB: case OP_DIV: case OP_MUL: case OP_REM:
+        case OP_SHL: case OP_SHR: case OP_AND: case OP_OR:  case OP_XOR:
+            return {RES_ACC | RES_DR, RES_ACC | RES_FLAGS | RES_ALU};
+        case OP_CMP:
+            return {RES_ACC | RES_DR, RES_FLAGS | RES_ALU};
+        case OP_PUSH:
+            return {RES_SP, RES_SP | RES_ALU};
+        case OP_POP:
+            return {RES_DR, RES_ACC | RES_ALU};
+        case OP_LD: case OP_LDA: case OP_TAS: case OP_LDS: case OP_LDX:
+            return {RES_DR, RES_ACC | RES_FLAGS | RES_ALU};
+        case OP_ST: case OP_STA: case OP_STS: case OP_STX:
+            return {RES_AR | RES_DR, RES_MEM};
+        case OP_CALL:
+            return {0, RES_IP | RES_ALU};
+        case OP_RET:
+            return {RES_DR, RES_IP | RES_ALU};
+        default:
+            return firstStepUse(code);
+    }
+}
+// clang-format on
+
+// The retiring instruction's last microstep and the next instruction's first microstep share a
+// tick only when they touch disjoint state. Write-after-read is harmless: memory latches
+// propagate before the ALU router in ProcessorModel::tick(), so `st` still stores through the
+// old AR while the next instruction loads a new address into it.
+bool PipelinedCU::hasHazard(uint8_t retiring, uint8_t next) {
+    StepUse last  = lastStepUse(retiring);
+    StepUse first = firstStepUse(next);
+
+    if ((last.writes & RES_IP) != 0) {
+        return true;
+    }
+    return (last.writes & (first.reads | first.writes)) != 0;
+}
+
+void PipelinedCU::prefetch(uint32_t address) {
+    prefetchValid = address < MEM_SIZE;
+    prefetchAddr  = address;
+    prefetchWord  = prefetchValid ? fetchMemory->load(address) : 0;
+    if (prefetchValid) {
+        counters.memoryReads++;
+    }
+}
+
+bool PipelinedCU::issue() {
+    uint32_t address = *ipRef;
+
+    if (!prefetchValid || prefetchAddr != address) {
+        log("IF refetch " + std::to_string(address));
+        prefetch(address);
+        flushes++;
+        return false;
+    }
+
+    *irRef  = prefetchWord;
+    opcode  = ((*IR) >> BITS_24) & FULL_MASK_8;
+    operand = (*IR) & FULL_MASK_24;
+    busy    = true;
+
+    log("ID " + opcodeStr(opcode));
+    prefetch(address + 1);
+    return true;
+}
+
+bool PipelinedCU::execute() {
+    instructionTick();
+
+    bool storing = latchDR_MEM->isEnabled() || latchMEM_TAS->isEnabled();
+    if (storing && prefetchValid && *arRef == prefetchAddr) {
+        prefetchValid = false;
+    }
+
+    if (!instructionDone) {
+        return false;
+    }
+
+    instructionDone = false;
+    busy            = false;
+    ipReady         = false;
+    retired++;
+    return true;
+}
+
+void PipelinedCU::decode() {
+    if (halted) {
+        return;
+    }
+
+    if (!busy) {
+        if (!ipReady) {
+            (*ipRef)++;
+            ipReady = true;
+        }
+
+        if (interruptHandler->shouldInterrupt() || interruptHandler->isEnteringInterrupt()) {
+            log("Interrupt");
+            counters.interruptEntryTicks++;
+            prefetchValid = false;
+            mux1->select(3);
+            mux2->select(0);
+            interruptHandler->step();
+            return;
+        }
+
+        if (!issue()) {
+            counters.fetchStallTicks++;
+            return;
+        }
+    }
+
+    counters.executeTicks++;
+    uint8_t retiring = opcode;
+    if (!execute() || halted || interruptHandler->shouldInterrupt()) {
+        return;
+    }
+
+    uint8_t next = (prefetchWord >> BITS_24) & FULL_MASK_8;
+    if (!prefetchValid || prefetchAddr != *ipRef + 1 || hasHazard(retiring, next)) {
+        return;
+    }
+
+    (*ipRef)++;
+    ipReady = true;
+    issue();
+    dualIssues++;
+    execute();
+}
+
+std::string PipelinedCU::summary(size_t ticks) const {
+    return CU::summary(ticks) + ", " + std::to_string(flushes) + " refetches, " +
+           std::to_string(dualIssues) + " dual-issued";
+}
+
+CU::Snapshot PipelinedCU::saveState() const {
+    Snapshot snapshot      = CU::saveState();
+    snapshot.busy          = busy;
+    snapshot.ipReady       = ipReady;
+    snapshot.prefetchValid = prefetchValid;
+    snapshot.prefetchAddr  = prefetchAddr;
+    snapshot.prefetchWord  = prefetchWord;
+    snapshot.flushes       = flushes;
+    snapshot.dualIssues    = dualIssues;
+    return snapshot;
+}
+
+void PipelinedCU::restoreState(const Snapshot& snapshot) {
+    CU::restoreState(snapshot);
+    busy          = snapshot.busy;
+    ipReady       = snapshot.ipReady;
+    prefetchValid = snapshot.prefetchValid;
+    prefetchAddr  = snapshot.prefetchAddr;
+    prefetchWord  = snapshot.prefetchWord;
+    flushes       = snapshot.flushes;
+    dualIssues    = snapshot.dualIssues;
+}
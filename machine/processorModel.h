@@ -1,22 +1,31 @@
 #ifndef _PROCESSOR_MODEL_H
 #define _PROCESSOR_MODEL_H
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "configParser.hpp"
+#include "phaseProfiler.hpp"
 
 constexpr size_t MEM_SIZE       = 1 << 24;
 constexpr uint32_t FULL_MASK    = 0xFFFFFFFF;
 constexpr uint32_t MSB_MASK     = 0x80000000;
 constexpr uint32_t FULL_MASK_24 = 0xFFFFFF;
+constexpr uint32_t MSB_MASK_24  = 0x800000;
 constexpr uint32_t FULL_MASK_8  = 0xFF;
 
 constexpr uint32_t MSB_INDEX = 31;
@@ -31,6 +40,10 @@ constexpr uint8_t latchDR_index  = 2;
 constexpr uint8_t latchPC_index  = 3;
 constexpr uint8_t latchSP_index  = 4;
 constexpr uint8_t latchSPC_index = 5;
+constexpr uint8_t latchXR_index  = 6;
+
+constexpr size_t MAX_CORES          = 64;
+constexpr uint32_t CORE_STACK_WORDS = 0x10000;
 
 class Memory {
 public:
@@ -72,6 +85,17 @@ public:
         return at(address);
     }
 
+    // Non-zero words only: a fresh Memory is all zeroes, so this is enough to recreate it.
+    [[nodiscard]] std::vector<std::pair<uint32_t, uint32_t>> nonZeroWords() const {
+        std::vector<std::pair<uint32_t, uint32_t>> words;
+        for (size_t address = 0; address < data.size(); address++) {
+            if (data[address] != 0) {
+                words.emplace_back(address, data[address]);
+            }
+        }
+        return words;
+    }
+
     std::function<uint32_t&()> makeGetterAtRef(const size_t& addressRef) {
         return [this, &addressRef]() -> uint32_t& { return this->at(addressRef); };
     }
@@ -84,6 +108,80 @@ private:
     std::vector<uint32_t> data;
 };
 
+// A core's access to the shared Memory. By default accesses go straight through. While
+// buffering, writes stay in the port and reads see the memory as it was when buffering started
+// plus the port's own writes; the port remembers which words it touched so a parallel quantum
+// can tell whether cores could have seen each other's writes.
+class MemoryPort {
+public:
+    explicit MemoryPort(Memory& memory) : memory(memory) {
+    }
+
+    // The word to read. While buffering, a copy that stays valid until the next load.
+    [[nodiscard]] uint32_t& load(size_t address) {
+        if (!buffering) {
+            return memory.at(address);
+        }
+        auto written = writes.find(address);
+        if (written != writes.end()) {
+            return written->second;
+        }
+        loaded = memory.at(address);
+        reads.insert(address);
+        return loaded;
+    }
+
+    // The word to write into.
+    [[nodiscard]] uint32_t& store(size_t address) {
+        if (!buffering) {
+            return memory.at(address);
+        }
+        return writes.try_emplace(address, memory.at(address)).first->second;
+    }
+
+    // Stores 1 into the word and returns its previous value, in one step of the core. This is
+    // the only read-modify-write the memory offers, so cores can build locks on top of it.
+    uint32_t testAndSet(size_t address) {
+        uint32_t previous = load(address);
+        store(address)    = 1;
+        return previous;
+    }
+
+    void startBuffering() {
+        buffering = true;
+    }
+
+    // Writes the buffered words into the memory and goes back to direct access.
+    void commit() {
+        for (const auto& [address, value] : writes) {
+            memory.at(address) = value;
+        }
+        discard();
+    }
+
+    // Drops the buffered words and goes back to direct access.
+    void discard() {
+        writes.clear();
+        reads.clear();
+        buffering = false;
+    }
+
+    // Whether this port wrote a word the other port read or wrote.
+    [[nodiscard]] bool conflictsWith(const MemoryPort& other) const {
+        return std::any_of(writes.begin(), writes.end(), [&other](const auto& write) {
+            return other.reads.count(write.first) != 0 || other.writes.count(write.first) != 0;
+        });
+    }
+
+private:
+    Memory& memory;
+
+    bool buffering  = false;
+    uint32_t loaded = 0;
+    std::unordered_map<size_t, uint32_t> writes;
+    std::unordered_set<size_t> reads;
+};
+
 struct FlagsRegister {
     bool N = false;
     bool Z = false;
@@ -224,13 +322,16 @@ public:
             case Operation::XOR:
                 value = left ^ right;
                 break;
+            // C is the last bit shifted out. Shifting by the word width or more clears the word
+            // (the host shift would be undefined), and shifting by 0 moves nothing out.
             case Operation::SHL:
-                value = left << right;
-                CFlag = ((left >> (WORD_BITS - right)) & 1U) != 0U;
+                value = right < WORD_BITS ? left << right : 0;
+                CFlag = right != 0 && right <= WORD_BITS &&
+                        ((left >> (WORD_BITS - right)) & 1U) != 0U;
                 break;
             case Operation::SHR:
-                value = left >> right;
-                CFlag = ((left >> (right - 1)) & 1U) != 0U;
+                value = right < WORD_BITS ? left >> right : 0;
+                CFlag = right != 0 && right <= WORD_BITS && ((left >> (right - 1)) & 1U) != 0U;
                 break;
             case Operation::NOP:
                 value = left + right;
@@ -291,6 +392,10 @@ public:
         selectedIndex = index;
     }
 
+    [[nodiscard]] size_t getSelectedIndex() const {
+        return selectedIndex;
+    }
+
     [[nodiscard]] uint32_t& getSelected() const {
         return inputs[selectedIndex].get();
     }
@@ -311,7 +416,7 @@ public:
         reset();
     }
 
-    enum RegName : uint8_t { ACC, IR, AR, DR, IP, SP, REG_COUNT };
+    enum RegName : uint8_t { ACC, IR, AR, DR, IP, SP, XR, REG_COUNT };
 
     void reset() {
         regs.fill(0);
@@ -378,6 +483,10 @@ public:
         this->enabled = enabled;
     }
 
+    [[nodiscard]] bool isEnabled() const {
+        return enabled;
+    }
+
     void propagate() {
         if (enabled) {
             targetGetter() = sourceGetter();
@@ -479,8 +588,39 @@ public:
         return intState == InterruptState::Executing;
     }
 
+    // An IRQ has been raised but the handler's vector has not been loaded into IP yet.
+    [[nodiscard]] bool isAwaitingVector() const {
+        return irq != IRQType::NONE && intState != InterruptState::Restoring;
+    }
+
     void step();
 
+    enum class InterruptState : uint8_t { SavingPC, Executing, Restoring };
+
+    struct Snapshot {
+        IRQType irq;
+        bool ie;
+        bool ipc;
+        uint32_t defaultVec;
+        uint32_t inputVec;
+        uint32_t SPC;
+        InterruptState intState;
+    };
+
+    [[nodiscard]] Snapshot saveState() const {
+        return {irq, ie, ipc, defaultVec, inputVec, SPC, intState};
+    }
+
+    void restoreState(const Snapshot& snapshot) {
+        irq        = snapshot.irq;
+        ie         = snapshot.ie;
+        ipc        = snapshot.ipc;
+        defaultVec = snapshot.defaultVec;
+        inputVec   = snapshot.inputVec;
+        SPC        = snapshot.SPC;
+        intState   = snapshot.intState;
+    }
+
 private:
     IRQType irq = IRQType::NONE;
     bool ie     = false;
@@ -497,7 +637,6 @@ private:
     Latch* latchVec_PC  = nullptr;
     uint32_t SPC        = 0;
 
-    enum class InterruptState : uint8_t { SavingPC, Executing, Restoring };
     InterruptState intState = InterruptState::SavingPC;
 };
 
@@ -505,12 +644,12 @@ class IOSimulator {
 public:
     IOSimulator() = default;
 
-    void connect(InterruptHandler& interruptHandler, Memory& memory) {
+    void connect(InterruptHandler& interruptHandler, MemoryPort& memory) {
         this->interruptHandler = &interruptHandler;
         this->memory           = &memory;
     }
 
-    void connectOutput(std::ofstream& outputFile) {
+    void connectOutput(std::ostream& outputFile) {
         this->outputFile = &outputFile;
     }
 
@@ -523,6 +662,44 @@ public:
         inputSchedule.push_back(entry);
     }
 
+    [[nodiscard]] size_t deliveredInputs(size_t beforeTick) const {
+        return std::count_if(inputSchedule.begin(), inputSchedule.end(),
+                             [beforeTick](const IOScheduleEntry& entry) {
+                                 return entry.tick < beforeTick;
+                             });
+    }
+
+    [[nodiscard]] const std::vector<IOScheduleEntry>& getOutputSchedule() const {
+        return outputSchedule;
+    }
+
+    // Replays output produced before a snapshot into the currently connected stream.
+    void restoreOutput(const std::vector<IOScheduleEntry>& schedule) {
+        outputSchedule = schedule;
+        for (const auto& entry : schedule) {
+            output(static_cast<char>(entry.token));
+        }
+    }
+
+    // Output produced from now on is only scheduled; it reaches the stream on commitOutput(), or
+    // is dropped again by discardOutput().
+    void holdOutput() {
+        heldFrom = outputSchedule.size();
+        holding  = true;
+    }
+
+    void commitOutput() {
+        for (size_t i = heldFrom; i < outputSchedule.size(); i++) {
+            output(static_cast<char>(outputSchedule[i].token));
+        }
+        holding = false;
+    }
+
+    void discardOutput() {
+        outputSchedule.resize(heldFrom);
+        holding = false;
+    }
+
     void output(const std::string& data) {
         if (outputFile != nullptr) {
             (*outputFile) << data;
@@ -539,15 +716,17 @@ public:
         for (const auto& entry : inputSchedule) {
             if (entry.tick == tick) {
                 interruptHandler->setIRQ(InterruptHandler::IRQType::IO_INPUT);
-                memory->write(input_address, entry.token);
+                memory->store(input_address) = entry.token;
             }
         }
 
-        if ((*memory)[output_address] != 0x0) {
-            uint32_t token = (*memory).at(output_address);
+        uint32_t token = memory->load(output_address);
+        if (token != 0x0) {
             outputSchedule.push_back({tick, static_cast<char>(token)});
-            output(static_cast<char>(token));
-            memory->write(output_address, 0);
+            if (!holding) {
+                output(static_cast<char>(token));
+            }
+            memory->store(output_address) = 0;
         }
     }
 
@@ -575,24 +754,55 @@ public:
 
 private:
     InterruptHandler* interruptHandler = nullptr;
-    Memory* memory                     = nullptr;
+    MemoryPort* memory                 = nullptr;
 
     std::vector<IOScheduleEntry> inputSchedule;
     std::vector<IOScheduleEntry> outputSchedule;
+    bool holding    = false;
+    size_t heldFrom = 0;
 
     static constexpr size_t input_address  = 0x10;
     static constexpr size_t output_address = 0x11;
 
-    std::ofstream* outputFile = nullptr;
+    std::ostream* outputFile = nullptr;
+};
+
+// Hardware-style event counters of one core. stateTicks follows CU::CPUState order and is only
+// kept by the multicycle CU; the pipelined CU overlaps fetch with execution, so it splits its
+// ticks by what the pipeline did instead.
+struct PerfCounters {
+    std::array<size_t, 4> stateTicks{};
+
+    size_t executeTicks        = 0;  // an instruction in EX
+    size_t fetchStallTicks     = 0;  // waiting for a refetch after a redirect
+    size_t interruptEntryTicks = 0;
+
+    size_t interruptsTaken       = 0;
+    size_t interruptLatencyTotal = 0;
+    size_t interruptLatencyMax   = 0;
+    size_t interruptPendingTicks = 0;
+
+    size_t memoryReads      = 0;
+    size_t memoryWrites     = 0;
+    size_t branchesTaken    = 0;
+    size_t branchesNotTaken = 0;
+    uint32_t maxStackDepth  = 0;
 };
 
 class CU {
 public:
-    CU() = default;
+    CU()          = default;
+    virtual ~CU() = default;
+
+    CU(const CU&)            = delete;
+    CU& operator=(const CU&) = delete;
+
+    CU(CU&&)            = delete;
+    CU& operator=(CU&&) = delete;
 
     void connect(InterruptHandler& interruptHandler, MUX& mux1, MUX& mux2, ALU& alu,
                  LatchRouter& latchRouter, Latch& latchMEM_IR, Latch& latchMEM_DR,
-                 Latch& latchDR_MEM) {
+                 Latch& latchDR_MEM, Latch& latchMEM_TAS) {
         this->interruptHandler = &interruptHandler;
         this->mux1             = &mux1;
         this->mux2             = &mux2;
@@ -601,6 +811,7 @@ public:
         this->latchMEM_IR      = &latchMEM_IR;
         this->latchMEM_DR      = &latchMEM_DR;
         this->latchDR_MEM      = &latchDR_MEM;
+        this->latchMEM_TAS     = &latchMEM_TAS;
 
         this->mux1->replaceInput(2, operand);
     }
@@ -621,7 +832,21 @@ public:
         return halted;
     }
 
-    void decode();
+    [[nodiscard]] size_t getRetiredCount() const {
+        return retired;
+    }
+
+    [[nodiscard]] const PerfCounters& getCounters() const {
+        return counters;
+    }
+
+    PerfCounters& getCounters() {
+        return counters;
+    }
+
+    [[nodiscard]] virtual std::string summary(size_t ticks) const;
+
+    virtual void decode();
 
     // clang-format off
     enum Opcode : uint8_t {
@@ -658,7 +883,19 @@ public:
         OP_EI   = 0b011111,
         OP_DI   = 0b100000,
         OP_IRET = 0b100001,
-        OP_HALT = 0b100010
+        OP_HALT = 0b100010,
+        OP_TAS  = 0b100011,
+        OP_LDS  = 0b100100,
+        OP_STS  = 0b100101,
+        OP_ADSP = 0b100110,
+        OP_SHL  = 0b100111,
+        OP_SHR  = 0b101000,
+        OP_AND  = 0b101001,
+        OP_OR   = 0b101010,
+        OP_XOR  = 0b101011,
+        OP_TAX  = 0b101100,
+        OP_LDX  = 0b101101,
+        OP_STX  = 0b101110
     };
 
     static std::string opcodeStr (uint8_t code) {
@@ -698,6 +935,18 @@ public:
             case OP_DI:   return "di";
             case OP_IRET: return "iret";
             case OP_HALT: return "halt";
+            case OP_TAS:  return "tas";
+            case OP_LDS:  return "lds";
+            case OP_STS:  return "sts";
+            case OP_ADSP: return "adsp";
+            case OP_SHL:  return "shl";
+            case OP_SHR:  return "shr";
+            case OP_AND:  return "and";
+            case OP_OR:   return "or";
+            case OP_XOR:  return "xor";
+            case OP_TAX:  return "tax";
+            case OP_LDX:  return "ldx";
+            case OP_STX:  return "stx";
             default:      return "unknown"; 
         }
     }
@@ -717,6 +966,7 @@ public:
             case OP_DI:
             case OP_IRET:
             case OP_HALT:
+            case OP_TAX:
                 return false;
 
             default:
@@ -724,7 +974,38 @@ public:
         }
     }
 
-private:
+    // Decode ticks of each opcode in instructionTick(); 0 for codes it rejects.
+    // clang-format off
+    static uint32_t microsteps(uint8_t code) {
+        switch (static_cast<Opcode>(code)) {
+            case OP_ADD: case OP_SUB: case OP_DIV: case OP_MUL: case OP_REM:
+            case OP_SHL: case OP_SHR: case OP_AND: case OP_OR:  case OP_XOR:
+            case OP_CMP: case OP_LD:  case OP_ST:  case OP_TAS: case OP_LDS:
+            case OP_STS:
+                return 3;
+            case OP_PUSH: case OP_POP: case OP_RET:
+                return 4;
+            case OP_LDA: case OP_STA: case OP_LDX: case OP_STX: case OP_CALL:
+                return 5;
+            case OP_INC: case OP_DEC: case OP_NOT: case OP_CLA: case OP_JMP:
+            case OP_JZ:  case OP_JNZ: case OP_JG:  case OP_JGE: case OP_JL:
+            case OP_JLE: case OP_JA:  case OP_JAE: case OP_JB:  case OP_JBE:
+            case OP_LDI: case OP_EI:  case OP_DI:  case OP_IRET: case OP_HALT:
+            case OP_ADSP: case OP_TAX:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+    // clang-format on
+
+    // Ticks of one instruction on the multicycle CU: FetchAR, FetchIR, the microsteps and
+    // IncrementIP, which halt never reaches. Taken and untaken jumps cost the same.
+    static uint32_t instructionTicks(uint8_t code) {
+        return 2 + microsteps(code) + (code == OP_HALT ? 0 : 1);
+    }
+
+protected:
     InterruptHandler* interruptHandler = nullptr;
 
     MUX* mux1                = nullptr;
@@ -734,6 +1015,7 @@ private:
     Latch* latchMEM_IR       = nullptr;
     Latch* latchMEM_DR       = nullptr;
     Latch* latchDR_MEM       = nullptr;
+    Latch* latchMEM_TAS      = nullptr;
 
     const uint32_t* IR = nullptr;
     std::weak_ptr<FlagsRegister> flagsWeakPtr;
@@ -761,13 +1043,17 @@ private:
 
     bool instructionDone = false;
     void instructionTick();
+    void branch(bool taken);
 
     size_t microstep = 0;
 
     uint8_t opcode   = 0;
     uint32_t operand = 0;
 
-    bool halted = false;
+    bool halted    = false;
+    size_t retired = 0;
+
+    PerfCounters counters;
 
     std::string* logChunk = nullptr;
     void log(const std::string& line) {
@@ -775,6 +1061,98 @@ private:
             (*logChunk) += line + "\n";
         }
     }
+
+public:
+    // Control state between two ticks. The trailing fields belong to PipelinedCU.
+    struct Snapshot {
+        CPUState state;
+        size_t microstep;
+        uint8_t opcode;
+        uint32_t operand;
+        bool instructionDone;
+        bool halted;
+        size_t retired;
+        PerfCounters counters;
+
+        bool busy;
+        bool ipReady;
+        bool prefetchValid;
+        uint32_t prefetchAddr;
+        uint32_t prefetchWord;
+        size_t flushes;
+        size_t dualIssues;
+    };
+
+    [[nodiscard]] virtual Snapshot saveState() const;
+    virtual void restoreState(const Snapshot& snapshot);
+};
+
+// Three-stage (IF / ID / EX) control unit. Instruction fetch goes through a dedicated read port
+// and overlaps with execution of the previous instruction, so FetchAR/FetchIR/IncrementIP
+// disappear from the critical path. EX runs the same microcode as CU. Fall-through is always
+// predicted; a redirected IP (taken jump, call, ret, iret, interrupt) flushes the prefetched
+// word. When the last microstep of an instruction leaves the ALU free, the first microstep of
+// the next one is issued in the same tick if the hazard check allows it.
+class PipelinedCU : public CU {
+public:
+    PipelinedCU() = default;
+
+    void connectFetchPort(MemoryPort& memory, uint32_t& IPreg, uint32_t& IRreg,
+                          const uint32_t& ARreg) {
+        this->fetchMemory = &memory;
+        this->ipRef       = &IPreg;
+        this->irRef       = &IRreg;
+        this->arRef       = &ARreg;
+    }
+
+    [[nodiscard]] std::string summary(size_t ticks) const override;
+
+    void decode() override;
+
+    [[nodiscard]] Snapshot saveState() const override;
+    void restoreState(const Snapshot& snapshot) override;
+
+private:
+    enum Resource : uint16_t {
+        RES_ACC   = 1U << 0U,
+        RES_AR    = 1U << 1U,
+        RES_DR    = 1U << 2U,
+        RES_SP    = 1U << 3U,
+        RES_IP    = 1U << 4U,
+        RES_FLAGS = 1U << 5U,
+        RES_MEM   = 1U << 6U,
+        RES_IE    = 1U << 7U,
+        RES_ALU   = 1U << 8U,
+        RES_XR    = 1U << 9U
+    };
+
+    struct StepUse {
+        uint16_t reads;
+        uint16_t writes;
+    };
+
+    static StepUse firstStepUse(uint8_t code);
+    static StepUse lastStepUse(uint8_t code);
+    static bool hasHazard(uint8_t retiring, uint8_t next);
+
+    void prefetch(uint32_t address);
+    bool issue();
+    bool execute();
+
+    MemoryPort* fetchMemory = nullptr;
+    uint32_t* ipRef         = nullptr;
+    uint32_t* irRef         = nullptr;
+    const uint32_t* arRef   = nullptr;
+
+    bool busy    = false;
+    bool ipReady = true;
+
+    bool prefetchValid    = false;
+    uint32_t prefetchAddr = 0;
+    uint32_t prefetchWord = 0;
+
+    size_t flushes    = 0;
+    size_t dualIssues = 0;
 };
 
 class IncrementalFNV1a {
@@ -801,13 +1179,155 @@ private:
     uint64_t hash_;
 };
 
+// One processor: registers, ALU, muxes, latches, control unit and interrupt handler. Cores only
+// share the Memory they are attached to, each through a MemoryPort of its own.
+class Core {
+public:
+    Core(Memory& memory, CpuModel model, uint32_t coreId);
+
+    struct Snapshot {
+        std::array<uint32_t, Registers::REG_COUNT> regs;
+        FlagsRegister flags;
+        size_t mux1Selected;
+        size_t mux2Selected;
+        CU::Snapshot cu;
+        InterruptHandler::Snapshot interrupts;
+    };
+
+    Core(const Core&)            = delete;
+    Core& operator=(const Core&) = delete;
+
+    Core(Core&&)            = delete;
+    Core& operator=(Core&&) = delete;
+
+    ~Core() = default;
+
+    void step();
+
+    [[nodiscard]] bool isHalted() const {
+        return cu->isHalted();
+    }
+
+    [[nodiscard]] uint32_t getId() const {
+        return id;
+    }
+
+    [[nodiscard]] const CU& getCU() const {
+        return *cu;
+    }
+
+    InterruptHandler& getInterruptHandler() {
+        return interruptHandler;
+    }
+
+    MemoryPort& getMemoryPort() {
+        return memory;
+    }
+
+    std::string& getLog() {
+        return logChunk;
+    }
+
+    std::string registerDump();
+
+    [[nodiscard]] Snapshot saveState() const;
+    void restoreState(const Snapshot& snapshot);
+
+private:
+    MemoryPort memory;
+    uint32_t id;
+
+    uint32_t zero      = 0;
+    uint32_t tasValue  = 0;
+    uint32_t stackBase = FULL_MASK_24;
+
+    Registers registers;
+    ALU alu;
+    MUX mux1, mux2;
+
+    Latch latchALU_DR, latchALU_AR, latchALU_SP, latchALU_AC, latchALU_PC, latchALU_SPC,
+        latchALU_XR;
+    LatchRouter latchRouter;
+    Latch latchMEM_IR, latchMEM_DR, latchDR_MEM, latchMEM_TAS;
+    Latch latchSPC_PC;
+    Latch latchVec_PC;
+
+    std::unique_ptr<CU> cu;
+    InterruptHandler interruptHandler;
+
+    std::string logChunk;
+};
+
+// Reusable barrier for the per-quantum rendezvous of the core threads. The last thread to arrive
+// runs `finished` once for everybody while the others wait, then releases them with its result.
+class QuantumBarrier {
+public:
+    explicit QuantumBarrier(size_t count) : count(count) {
+    }
+
+    template <typename Predicate>
+    bool arriveAndWait(Predicate finished) {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t arrivedGeneration = generation;
+
+        if (++arrived == count) {
+            arrived = 0;
+            done    = finished();
+            generation++;
+            released.notify_all();
+            return done;
+        }
+
+        released.wait(lock, [&] { return generation != arrivedGeneration; });
+        return done;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t count;
+    size_t arrived    = 0;
+    size_t generation = 0;
+    bool done         = false;
+};
+
 class ProcessorModel {
 public:
     ProcessorModel(MachineConfig& cfg);
 
+    // Complete machine state at a tick boundary.
+    struct Snapshot {
+        std::vector<std::pair<uint32_t, uint32_t>> memory;
+        std::vector<Core::Snapshot> cores;
+        std::vector<size_t> coreTicks;
+        std::vector<IncrementalFNV1a> hashers;
+        std::vector<IOSimulator::IOScheduleEntry> output;
+        size_t tickCount;
+        size_t textSize;
+        size_t dataSize;
+        size_t dataStart;
+    };
+
     void loadBinary(const std::string& filename);
     void process();
 
+    void run();
+    void runUntil(size_t endTick);
+
+    [[nodiscard]] Snapshot saveState() const;
+    void restoreState(const Snapshot& snapshot);
+
+    void captureOutput(std::ostream& stream);
+
+    [[nodiscard]] size_t getTickCount() const {
+        return tickCount;
+    }
+
+    [[nodiscard]] bool isHalted() const;
+
+    static std::vector<IOSimulator::IOScheduleEntry> readInputSchedule(const MachineConfig& cfg);
+    static uint32_t read_uint32(std::ifstream& inFile);
+
 private:
     MachineConfig cfg;
 
@@ -816,48 +1336,60 @@ private:
     size_t dataSize     = 0;
     uint32_t entryPoint = 0;
 
-    uint32_t zero    = 0;
     size_t tickCount = 0;
 
     bool halted       = false;
     bool binaryLoaded = false;
 
     Memory memory;
-    Registers registers;
-    ALU alu;
-    MUX mux1, mux2;
-
-    Latch latchALU_DR, latchALU_AR, latchALU_SP, latchALU_AC, latchALU_PC, latchALU_SPC;
-    LatchRouter latchRouter;
-    Latch latchMEM_IR, latchMEM_DR, latchDR_MEM;
-    Latch latchSPC_PC;
-    Latch latchVec_PC;
-
-    CU cu;
-    InterruptHandler interruptHandler;
+    std::vector<std::unique_ptr<Core>> cores;
+    std::vector<size_t> coreTicks;
 
     IOSimulator iosim;
 
-    void tick();
+    void tick(Core& core, size_t tick);
+    // One tick of the core, leaving its log chunk in Core::getLog().
+    void stepCore(Core& core, size_t tick);
+    // Hashes and writes out a stretch of the core's log, as configured.
+    void recordLog(size_t coreId, const std::string& log);
+
+    // Where a core stands in a parallel run.
+    struct CoreRun {
+        Core::Snapshot start;  // the core at the start of the quantum
+        bool stoppedAtStart = false;
+        bool stopped        = false;
+        std::exception_ptr failure;
+        std::string log;  // of the quantum
+    };
+
+    void runParallel();
+    // One tick of a core that has not stopped; a failure or a halt stops it.
+    void stepRun(size_t coreId, size_t tick, CoreRun& run);
+    // Steps one core from tickCount to the end of the quantum, through its buffering port.
+    void stepQuantum(size_t coreId, size_t quantumEnd, CoreRun& run);
+    // Steps every core from tickCount to the end of the quantum, in core order within a tick.
+    void stepLockstep(size_t quantumEnd, std::vector<CoreRun>& runs);
+    // Commits the quantum the cores stepped apart, or runs it again in lockstep. Returns whether
+    // every core has stopped.
+    bool finishQuantum(size_t quantumEnd, std::vector<CoreRun>& runs);
+    static bool allStopped(const std::vector<CoreRun>& runs);
+    void report();
+    void writeStats();
 
     std::string memDump();
-    std::string registerDump();
 
     static bool isNumberArray(const std::string& val);
     static std::vector<int> parseStreamLine(const std::string& line);
     static std::vector<int> parseTokenStr(const std::string& tokenStr);
     void parseInput();
 
-    static uint32_t read_uint32(std::ifstream& inFile);
-
-    std::string logChunk;
-
-    std::ofstream logFile;
     std::ofstream outputFile;
     std::ofstream binaryReprFile;
     std::ofstream logHashFile;
+    std::ofstream statsFile;
 
-    IncrementalFNV1a hasher;
+    std::vector<std::ofstream> logFiles;
+    std::vector<IncrementalFNV1a> hashers;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,182 @@
+#include "sweep.h"
+
+#include <atomic>
+
+constexpr size_t OUTPUT_COLUMN_WIDTH = 32;
+
+Sweep::Sweep(const MachineConfig& baseConfig, std::string binaryFile)
+    : baseConfig(baseConfig), binaryFile(std::move(binaryFile)) {
+}
+
+// One variant per line, as whitespace separated key=value pairs applied on top of the base
+// config. Only the input keys may change, everything else has to match the shared snapshot.
+void Sweep::loadVariants(const std::string& filename) {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        throw std::runtime_error("Failed to open sweep file: " + filename);
+    }
+
+    std::string line;
+    while (std::getline(inFile, line)) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        Variant variant{line, baseConfig};
+        std::istringstream iss(line);
+        std::string entry;
+        while (iss >> entry) {
+            size_t equals = entry.find('=');
+            if (equals == std::string::npos) {
+                throw std::runtime_error("Invalid sweep entry: " + entry);
+            }
+
+            std::string key   = entry.substr(0, equals);
+            std::string value = unquote(entry.substr(equals + 1));
+            if (key != "input_file" && key != "input_mode" && key != "schedule_start" &&
+                key != "schedule_offset") {
+                throw std::runtime_error("Sweep can't vary " + key);
+            }
+            applyConfigKey(variant.cfg, key, value);
+        }
+
+        variants.push_back(std::move(variant));
+    }
+
+    if (variants.empty()) {
+        throw std::runtime_error("Sweep file has no variants: " + filename);
+    }
+}
+
+MachineConfig Sweep::quiet(MachineConfig cfg) {
+    cfg.output_file.clear();
+    cfg.log_file.clear();
+    cfg.binary_repr_file.clear();
+    cfg.log_hash_file.clear();
+    cfg.stats_file.clear();
+    return cfg;
+}
+
+// The base config runs alongside the variants, from the same snapshot: its output is what a
+// variant has to reproduce to count as stable.
+void Sweep::run(size_t jobs) {
+    std::vector<const MachineConfig*> configs;
+    for (const auto& variant : variants) {
+        configs.push_back(&variant.cfg);
+    }
+    configs.push_back(&baseConfig);
+
+    size_t warmTicks = SIZE_MAX;
+    for (const MachineConfig* cfg : configs) {
+        for (const auto& entry : ProcessorModel::readInputSchedule(*cfg)) {
+            warmTicks = std::min(warmTicks, entry.tick);
+        }
+    }
+
+    MachineConfig warmConfig = quiet(baseConfig);
+    warmConfig.input_file.clear();
+
+    ProcessorModel warm(warmConfig);
+    warm.loadBinary(binaryFile);
+    warm.runUntil(warmTicks);
+    const ProcessorModel::Snapshot snapshot = warm.saveState();
+    warmTicks                               = snapshot.tickCount;
+
+    results.assign(configs.size(), Result{});
+    std::atomic<size_t> next{0};
+
+    auto worker = [&]() {
+        for (size_t index = next++; index < configs.size(); index = next++) {
+            Result& result = results[index];
+            try {
+                MachineConfig cfg = quiet(*configs[index]);
+                std::ostringstream output;
+
+                ProcessorModel model(cfg);
+                model.captureOutput(output);
+                model.restoreState(snapshot);
+                model.run();
+
+                result.ticks  = model.getTickCount();
+                result.output = output.str();
+            } catch (const std::exception& ex) {
+                result.error = ex.what();
+            }
+        }
+    };
+
+    jobs = std::max<size_t>(1, std::min(jobs, configs.size()));
+    std::vector<std::thread> pool;
+    pool.reserve(jobs);
+    for (size_t i = 0; i < jobs; i++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    printTable(warmTicks);
+}
+
+std::string Sweep::escape(const std::string& text) {
+    std::string result;
+    for (char character : text) {
+        if (character == '\n') {
+            result += "\\n";
+        } else if (character == '\t') {
+            result += "\\t";
+        } else if (character == '"') {
+            result += "\\\"";
+        } else {
+            result += character;
+        }
+    }
+
+    if (result.size() > OUTPUT_COLUMN_WIDTH) {
+        result = result.substr(0, OUTPUT_COLUMN_WIDTH - 3) + "...";
+    }
+    return "\"" + result + "\"";
+}
+
+// A schedule that delivers input faster than the program reads it drops words, and such a
+// variant may well finish first; only variants with the base config's output can be fastest.
+void Sweep::printTable(size_t warmTicks) const {
+    const Result& reference = results.back();
+    std::cout << "Warm-up: " << warmTicks << " ticks shared by " << variants.size()
+              << " variants\n";
+    if (reference.error.empty()) {
+        std::cout << "Base config output: " << escape(reference.output) << "\n";
+    } else {
+        std::cout << "Base config failed: " << reference.error << "\n";
+    }
+    std::cout << std::left << std::setw(4) << "#" << std::setw(12) << "ticks" << std::setw(8)
+              << "stable" << std::setw(OUTPUT_COLUMN_WIDTH + 4) << "output"
+              << "variant\n";
+
+    size_t fastest = variants.size();
+    for (size_t index = 0; index < variants.size(); index++) {
+        const Result& result = results[index];
+
+        std::cout << std::left << std::setw(4) << index;
+        if (result.error.empty()) {
+            bool stable = reference.error.empty() && result.output == reference.output;
+            std::cout << std::setw(12) << result.ticks << std::setw(8) << (stable ? "yes" : "no")
+                      << std::setw(OUTPUT_COLUMN_WIDTH + 4) << escape(result.output);
+            if (stable && (fastest == variants.size() || result.ticks < results[fastest].ticks)) {
+                fastest = index;
+            }
+        } else {
+            std::cout << std::setw(12) << "-" << std::setw(8) << "-"
+                      << std::setw(OUTPUT_COLUMN_WIDTH + 4) << ("error: " + result.error);
+        }
+        std::cout << variants[index].description << "\n";
+    }
+
+    if (fastest != variants.size()) {
+        std::cout << "Fastest stable: #" << fastest << " (" << results[fastest].ticks
+                  << " ticks)\n";
+    } else {
+        std::cout << "No variant reproduces the base config output\n";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _SWEEP_H
+#define _SWEEP_H
+
+#include <string>
+#include <vector>
+
+#include "configParser.hpp"
+#include "processorModel.h"
+
+// Runs one binary under many input schedules. Every tick before the earliest input event is the
+// same for all variants, so it is simulated once; the resulting snapshot is then restored into a
+// fresh machine per variant on a pool of host threads.
+class Sweep {
+public:
+    Sweep(const MachineConfig& baseConfig, std::string binaryFile);
+
+    void loadVariants(const std::string& filename);
+    void run(size_t jobs);
+
+private:
+    struct Variant {
+        std::string description;
+        MachineConfig cfg;
+    };
+
+    struct Result {
+        size_t ticks = 0;
+        std::string output;
+        std::string error;
+    };
+
+    MachineConfig baseConfig;
+    std::string binaryFile;
+
+    std::vector<Variant> variants;
+    // One per variant, then the base config's.
+    std::vector<Result> results;
+
+    static MachineConfig quiet(MachineConfig cfg);
+    static std::string escape(const std::string& text);
+
+    void printTable(size_t warmTicks) const;
+};
+
+#endif
@@ -48,6 +48,7 @@ protected:
         fs::path inputFile   = caseDir / "input.txt";
         fs::path programFile = caseDir / "program.txt";
         fs::path binaryFile  = caseDir / "program.bin";
+        fs::path flagsFile   = caseDir / "flags.txt";
 
         fs::path outputFile = caseDir / "output.txt";
         fs::path reprFile   = caseDir / "repr.txt";
@@ -57,7 +58,15 @@ protected:
         fs::path expectedReprFile   = expectedDir / "repr.txt";
         fs::path expectedHashFile   = expectedDir / "hash.txt";
 
-        runCommand(std::string(TRANSLATOR_PATH) + " " + programFile.string() + " " +
+        // Translator flags the case needs, on one line.
+        std::string flags;
+        if (fs::exists(flagsFile)) {
+            std::istringstream firstLine(readFile(flagsFile));
+            std::getline(firstLine, flags);
+            flags += " ";
+        }
+
+        runCommand(std::string(TRANSLATOR_PATH) + " " + flags + programFile.string() + " " +
                    binaryFile.string());
         runCommandInDir(
             std::string(MACHINE_PATH) + " " + configFile.string() + " " + binaryFile.string(),
@@ -82,6 +91,163 @@ protected:
     }
 };
 
+// With several cores the log is split into one file per core, next to where a single log would
+// go; core 0's ends with the memory dump.
+TEST(MulticoreTest, WritesOneLogPerCore) {
+    fs::path caseDir = fs::path(TEST_CASES_DIR) / "basics" / "multicore";
+    fs::path workDir = fs::temp_directory_path() / "golden_multicore_logs";
+    fs::remove_all(workDir);
+    fs::create_directories(workDir);
+
+    std::ofstream config(workDir / "config.cfg");
+    config << readFile(caseDir / "config.cfg") << "\nlog_file: log.txt\n";
+    config.close();
+
+    runCommand(std::string(TRANSLATOR_PATH) + " --asm " + (caseDir / "program.txt").string() +
+               " " + (workDir / "program.bin").string());
+    runCommandInDir(std::string(MACHINE_PATH) + " config.cfg program.bin", workDir);
+
+    EXPECT_FALSE(fs::exists(workDir / "log.txt"));
+    for (const char* core : {"core0", "core1"}) {
+        std::string log = readFile(workDir / ("log.txt." + std::string(core)));
+        EXPECT_EQ(log.rfind("tick #0\n", 0), 0U) << core;
+    }
+    EXPECT_NE(readFile(workDir / "log.txt.core0").find("MEMDUMP:"), std::string::npos);
+    EXPECT_EQ(readFile(workDir / "log.txt.core1").find("MEMDUMP:"), std::string::npos);
+
+    fs::remove_all(workDir);
+}
+
+// The cat case under two input schedules: both echo the whole input, the closer spaced one
+// sooner.
+TEST(SweepTest, PrintsOneRowPerVariant) {
+    fs::path caseDir = fs::path(TEST_CASES_DIR) / "basics" / "cat";
+    fs::path workDir = fs::temp_directory_path() / "golden_sweep";
+    fs::remove_all(workDir);
+    fs::create_directories(workDir);
+
+    fs::copy_file(caseDir / "config.cfg", workDir / "config.cfg");
+    fs::copy_file(caseDir / "input.txt", workDir / "input.txt");
+    std::ofstream(workDir / "variants.txt") << "schedule_offset=200\nschedule_offset=400\n";
+
+    runCommand(std::string(TRANSLATOR_PATH) + " " + (caseDir / "program.txt").string() + " " +
+               (workDir / "program.bin").string() + " > /dev/null");
+    runCommandInDir(std::string(MACHINE_PATH) +
+                        " config.cfg program.bin --sweep variants.txt --jobs 2 > table.txt",
+                    workDir);
+
+    std::string table = readFile(workDir / "table.txt");
+    EXPECT_NE(table.find("Warm-up: 1900 ticks shared by 2 variants\n"), std::string::npos) << table;
+    EXPECT_NE(table.find("Base config output: \"cat cat cat cat\"\n"), std::string::npos) << table;
+
+    std::istringstream rows(table);
+    std::string line;
+    size_t stableRows = 0;
+    while (std::getline(rows, line)) {
+        if (line.find(" yes ") != std::string::npos &&
+            line.find("\"cat cat cat cat\"") != std::string::npos) {
+            stableRows++;
+        }
+    }
+    EXPECT_EQ(stableRows, 2U) << table;
+    EXPECT_NE(table.find("schedule_offset=200\n"), std::string::npos) << table;
+    EXPECT_NE(table.find("schedule_offset=400\n"), std::string::npos) << table;
+    EXPECT_NE(table.find("Fastest stable: #0 ("), std::string::npos) << table;
+
+    fs::remove_all(workDir);
+}
+
+// Runs the hello case with the extra config lines and returns what the machine prints.
+std::string runHello(const std::string& extraConfig, const fs::path& workDir) {
+    fs::path caseDir = fs::path(TEST_CASES_DIR) / "basics" / "hello";
+    fs::remove_all(workDir);
+    fs::create_directories(workDir);
+
+    std::ofstream(workDir / "config.cfg") << "output_file: output.txt\n" << extraConfig;
+    runCommand(std::string(TRANSLATOR_PATH) + " " + (caseDir / "program.txt").string() + " " +
+               (workDir / "program.bin").string() + " > /dev/null");
+    runCommandInDir(std::string(MACHINE_PATH) + " config.cfg program.bin > stdout.txt", workDir);
+    return readFile(workDir / "stdout.txt");
+}
+
+TEST(StatsTest, CountsTheHelloRun) {
+    fs::path workDir = fs::temp_directory_path() / "golden_stats";
+    runHello("stats_file: stats.json\n", workDir);
+
+    std::string stats = readFile(workDir / "stats.json");
+    for (const char* counter :
+         {"\"ticks\": 778,", "\"io_tokens_out\": 14,", "\"instructions_retired\": 135,",
+          "\"memory_reads\": 208,", "\"memory_writes\": 45,", "\"branches_taken\": 13,",
+          "\"max_stack_depth\": 1\n"}) {
+        EXPECT_NE(stats.find(counter), std::string::npos) << counter << "\n" << stats;
+    }
+    EXPECT_NE(stats.find("\"state_ticks\": {\"FetchAR\": 135, \"FetchIR\": 135, \"Decode\": 374, "
+                         "\"IncrementIP\": 134}"),
+              std::string::npos)
+        << stats;
+
+    fs::remove_all(workDir);
+}
+
+// The report only exists in a machine built with MACHINE_PROFILE.
+TEST(ProfilerTest, ReportsPhasesOnlyWhenBuiltIn) {
+    fs::path workDir    = fs::temp_directory_path() / "golden_profile";
+    std::string printed = runHello("", workDir);
+
+#ifdef MACHINE_PROFILE
+    EXPECT_NE(printed.find("Phase profile (host time, 778 ticks):\n"), std::string::npos)
+        << printed;
+    for (const char* phase : {"cu.decode", "latches", "alu.perform", "total"}) {
+        EXPECT_NE(printed.find("  " + std::string(phase) + " "), std::string::npos)
+            << phase << "\n" << printed;
+    }
+#else
+    EXPECT_EQ(printed.find("Phase profile"), std::string::npos) << printed;
+#endif
+    EXPECT_EQ(readFile(workDir / "output.txt"), "Hello, world!\n");
+
+    fs::remove_all(workDir);
+}
+
+// Runs the static estimator on the hello case, with the loop bounds given if there are any, and
+// returns what it prints.
+std::string estimateHello(const std::string& loopBounds) {
+    fs::path caseDir = fs::path(TEST_CASES_DIR) / "basics" / "hello";
+    fs::path workDir = fs::temp_directory_path() / "golden_cost_estimate";
+    fs::remove_all(workDir);
+    fs::create_directories(workDir);
+
+    std::ofstream(workDir / "config.cfg") << "cost_file: cost.txt\n";
+    std::string command = std::string(MACHINE_PATH) + " config.cfg program.bin --estimate";
+    if (!loopBounds.empty()) {
+        std::ofstream(workDir / "bounds.txt") << loopBounds << "\n";
+        command += " --loop-bounds bounds.txt";
+    }
+
+    runCommand(std::string(TRANSLATOR_PATH) + " " + (caseDir / "program.txt").string() + " " +
+               (workDir / "program.bin").string() + " > /dev/null");
+    runCommandInDir(command + " > summary.txt", workDir);
+
+    std::string summary = readFile(workDir / "summary.txt");
+    EXPECT_TRUE(fs::exists(workDir / "cost.txt"));
+    fs::remove_all(workDir);
+    return summary;
+}
+
+// The string loop runs 14 times for "Hello, world!", which makes the estimate exact: the
+// simulated run also takes 778 ticks.
+TEST(CostEstimatorTest, BoundedLoopGivesWorstCase) {
+    std::string summary = estimateHello("40 14");
+    EXPECT_NE(summary.find("Worst case from entry: 778 ticks\n"), std::string::npos) << summary;
+    EXPECT_EQ(summary.find("Loops without a bound"), std::string::npos) << summary;
+}
+
+TEST(CostEstimatorTest, LoopWithoutBoundIsUnbounded) {
+    std::string summary = estimateHello("");
+    EXPECT_NE(summary.find("Worst case from entry: unbounded\n"), std::string::npos) << summary;
+    EXPECT_NE(summary.find("Loops without a bound: 0040\n"), std::string::npos) << summary;
+}
+
 class BasicTests : public GoldenTestRunner {};
 class ControlFlowTests : public GoldenTestRunner {};
 class FunctionTests : public GoldenTestRunner {};
@@ -109,22 +275,34 @@ INSTANTIATE_TEST_SUITE_P(Basics, BasicTests, ::testing::Values(
     "hello_user_name",
     "cat",
     "array",
+    "array_length",
     "arithmetic",
-    "double_precision"
+    "bitwise",
+    "double_precision",
+    "constant_fold",
+    "multicore"
 ));
 
 INSTANTIATE_TEST_SUITE_P(ControlFlow, ControlFlowTests, ::testing::Values(
     "while_break",
-    "nested_while"
+    "nested_while",
+    "loop_conditions"
 ));
 
 INSTANTIATE_TEST_SUITE_P(Function, FunctionTests, ::testing::Values(
     "recursion",
-    "overload"
+    "overload",
+    "bool_result",
+    "frames",
+    "tail_calls",
+    "inlining",
+    "ssa"
 ));
 
 INSTANTIATE_TEST_SUITE_P(Algo, AlgoTests, ::testing::Values(
     "sort",
+    "sort_pipelined",
+    "quicksort",
     "palindrome"
 ));
 // clang-format on
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "ASTVisitor.hpp"
+#include "arena.hpp"
+#include "lexer.h"
+#include "types.hpp"
 
 enum class ASTNodeType : uint8_t {
     VarDecl,
@@ -40,6 +45,52 @@ enum class ASTNodeType : uint8_t {
     Return
 };
 
+enum class Operator : uint8_t {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Rem,
+    ShiftLeft,
+    ShiftRight,
+    BitAnd,
+    BitOr,
+    BitXor,
+
+    Equal,
+    NotEqual,
+    Greater,
+    GreaterEqual,
+    Less,
+    LessEqual,
+
+    And,
+    Or,
+    Not,
+};
+
+inline std::string_view operatorName(Operator opr) {
+    // clang-format off
+    constexpr std::array<std::string_view, 19> NAMES = {
+        "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^",
+        "==", "!=", ">", ">=", "<", "<=",
+        "&&", "||", "!",
+    };
+    // clang-format on
+    return NAMES.at(static_cast<size_t>(opr));
+}
+
+// Operators on int/uint values, including the bitwise ones.
+inline bool isArithmetic(Operator opr) {
+    return opr >= Operator::Add && opr <= Operator::BitXor;
+}
+
+inline bool isComparison(Operator opr) {
+    return opr >= Operator::Equal && opr <= Operator::LessEqual;
+}
+
+// Nodes live in the translation unit's arena and are never destroyed one by one, so they hold
+// plain pointers to their children and views of interned names.
 struct ASTNode {
     ASTNodeType nodeType;
 
@@ -48,8 +99,6 @@ struct ASTNode {
 
     virtual void accept(ASTVisitor& visitor) = 0;
 
-    virtual ~ASTNode() = default;
-
     ASTNode(const ASTNode&)            = delete;
     ASTNode& operator=(const ASTNode&) = delete;
 
@@ -57,23 +106,27 @@ struct ASTNode {
     ASTNode& operator=(ASTNode&&) = delete;
 };
 
+using NodeList = ArenaList<ASTNode*>;
+
 struct ExpressionNode : ASTNode {
-    std::string resolvedType;
+    TypeId resolvedType = TypeId::None;
 
     ExpressionNode(ASTNodeType nodeType) : ASTNode(nodeType) {
     }
 };
 
 struct VarDeclNode : ASTNode {
-    std::string type;
-    std::string name;
-    std::unique_ptr<ASTNode> value;
+    TypeId type;
+    SymbolId symbol;
+    std::string_view name;
+    ASTNode* value;
 
-    VarDeclNode(std::string type, std::string name, std::unique_ptr<ASTNode> value)
+    VarDeclNode(TypeId type, SymbolId symbol, std::string_view name, ASTNode* value)
         : ASTNode(ASTNodeType::VarDecl),
-          type(std::move(type)),
-          name(std::move(name)),
-          value(std::move(value)) {
+          type(type),
+          symbol(symbol),
+          name(name),
+          value(value) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -104,10 +157,10 @@ struct CharLiteralNode : ExpressionNode {
 };
 
 struct StringLiteralNode : ExpressionNode {
-    std::string value;
+    std::string_view value;
 
-    StringLiteralNode(std::string value)
-        : ExpressionNode(ASTNodeType::StringLiteral), value(std::move(value)) {
+    StringLiteralNode(std::string_view value)
+        : ExpressionNode(ASTNodeType::StringLiteral), value(value) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -136,10 +189,10 @@ struct VoidLiteralNode : ExpressionNode {
 };
 
 struct IntArrayLiteralNode : ExpressionNode {
-    std::vector<std::unique_ptr<ASTNode>> values;
+    NodeList values;
 
-    IntArrayLiteralNode(std::vector<std::unique_ptr<ASTNode>> values)
-        : ExpressionNode(ASTNodeType::IntArrayLiteral), values(std::move(values)) {
+    IntArrayLiteralNode(NodeList values)
+        : ExpressionNode(ASTNodeType::IntArrayLiteral), values(values) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -148,13 +201,11 @@ struct IntArrayLiteralNode : ExpressionNode {
 };
 
 struct ArrayGetNode : ExpressionNode {
-    std::unique_ptr<ASTNode> object;
-    std::unique_ptr<ASTNode> index;
+    ASTNode* object;
+    ASTNode* index;
 
-    ArrayGetNode(std::unique_ptr<ASTNode> object, std::unique_ptr<ASTNode> index)
-        : ExpressionNode(ASTNodeType::ArrayGet),
-          object(std::move(object)),
-          index(std::move(index)) {
+    ArrayGetNode(ASTNode* object, ASTNode* index)
+        : ExpressionNode(ASTNodeType::ArrayGet), object(object), index(index) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -163,16 +214,18 @@ struct ArrayGetNode : ExpressionNode {
 };
 
 struct MethodCallNode : ExpressionNode {
-    std::unique_ptr<ASTNode> object;
-    std::string methodName;
-    std::vector<std::unique_ptr<ASTNode>> arguments;
+    ASTNode* object;
+    SymbolId method;
+    std::string_view methodName;
+    NodeList arguments;
 
-    MethodCallNode(std::unique_ptr<ASTNode> object, std::string methodName,
-                   std::vector<std::unique_ptr<ASTNode>> arguments)
+    MethodCallNode(ASTNode* object, SymbolId method, std::string_view methodName,
+                   NodeList arguments)
         : ExpressionNode(ASTNodeType::MethodCall),
-          object(std::move(object)),
-          methodName(std::move(methodName)),
-          arguments(std::move(arguments)) {
+          object(object),
+          method(method),
+          methodName(methodName),
+          arguments(arguments) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -181,10 +234,11 @@ struct MethodCallNode : ExpressionNode {
 };
 
 struct IdentifierNode : ExpressionNode {
-    std::string name;
+    SymbolId symbol;
+    std::string_view name;
 
-    IdentifierNode(std::string name)
-        : ExpressionNode(ASTNodeType::Identifier), name(std::move(name)) {
+    IdentifierNode(SymbolId symbol, std::string_view name)
+        : ExpressionNode(ASTNodeType::Identifier), symbol(symbol), name(name) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -193,11 +247,11 @@ struct IdentifierNode : ExpressionNode {
 };
 
 struct AssignNode : ASTNode {
-    std::unique_ptr<ASTNode> var1;
-    std::unique_ptr<ASTNode> var2;
+    ASTNode* var1;
+    ASTNode* var2;
 
-    AssignNode(std::unique_ptr<ASTNode> var1, std::unique_ptr<ASTNode> var2)
-        : ASTNode(ASTNodeType::Assignment), var1(std::move(var1)), var2(std::move(var2)) {
+    AssignNode(ASTNode* var1, ASTNode* var2)
+        : ASTNode(ASTNodeType::Assignment), var1(var1), var2(var2) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -206,16 +260,12 @@ struct AssignNode : ASTNode {
 };
 
 struct BinaryOpNode : ExpressionNode {
-    std::string op;
-    std::unique_ptr<ASTNode> left;
-    std::unique_ptr<ASTNode> right;
+    Operator op;
+    ASTNode* left;
+    ASTNode* right;
 
-    BinaryOpNode(std::string operation, std::unique_ptr<ASTNode> left,
-                 std::unique_ptr<ASTNode> right)
-        : ExpressionNode(ASTNodeType::BinaryOp),
-          op(std::move(operation)),
-          left(std::move(left)),
-          right(std::move(right)) {
+    BinaryOpNode(Operator operation, ASTNode* left, ASTNode* right)
+        : ExpressionNode(ASTNodeType::BinaryOp), op(operation), left(left), right(right) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -224,13 +274,11 @@ struct BinaryOpNode : ExpressionNode {
 };
 
 struct UnaryOpNode : ExpressionNode {
-    std::string op;
-    std::unique_ptr<ASTNode> operand;
+    Operator op;
+    ASTNode* operand;
 
-    UnaryOpNode(std::string operation, std::unique_ptr<ASTNode> operand)
-        : ExpressionNode(ASTNodeType::UnaryOp),
-          op(std::move(operation)),
-          operand(std::move(operand)) {
+    UnaryOpNode(Operator operation, ASTNode* operand)
+        : ExpressionNode(ASTNodeType::UnaryOp), op(operation), operand(operand) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -239,16 +287,15 @@ struct UnaryOpNode : ExpressionNode {
 };
 
 struct IfNode : ASTNode {
-    std::unique_ptr<ASTNode> condition;
-    std::unique_ptr<ASTNode> thenBranch;
-    std::unique_ptr<ASTNode> elseBranch = nullptr;
+    ASTNode* condition;
+    ASTNode* thenBranch;
+    ASTNode* elseBranch = nullptr;
 
-    IfNode(std::unique_ptr<ASTNode> condition, std::unique_ptr<ASTNode> thenBranch,
-           std::unique_ptr<ASTNode> elseBranch = nullptr)
+    IfNode(ASTNode* condition, ASTNode* thenBranch, ASTNode* elseBranch = nullptr)
         : ASTNode(ASTNodeType::If),
-          condition(std::move(condition)),
-          thenBranch(std::move(thenBranch)),
-          elseBranch(std::move(elseBranch)) {
+          condition(condition),
+          thenBranch(thenBranch),
+          elseBranch(elseBranch) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -257,11 +304,11 @@ struct IfNode : ASTNode {
 };
 
 struct WhileNode : ASTNode {
-    std::unique_ptr<ASTNode> condition;
-    std::unique_ptr<ASTNode> body;
+    ASTNode* condition;
+    ASTNode* body;
 
-    WhileNode(std::unique_ptr<ASTNode> condition, std::unique_ptr<ASTNode> body)
-        : ASTNode(ASTNodeType::While), condition(std::move(condition)), body(std::move(body)) {
+    WhileNode(ASTNode* condition, ASTNode* body)
+        : ASTNode(ASTNodeType::While), condition(condition), body(body) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -279,16 +326,9 @@ struct BreakNode : ASTNode {
 };
 
 struct BlockNode : ASTNode {
-    std::vector<std::unique_ptr<ASTNode>> children;
+    NodeList children;
 
-    void addChild(std::unique_ptr<ASTNode> child) {
-        if (child == nullptr) {
-            return;
-        }
-        children.push_back(std::move(child));
-    }
-
-    BlockNode() : ASTNode(ASTNodeType::Block) {
+    BlockNode(NodeList children) : ASTNode(ASTNodeType::Block), children(children) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -297,11 +337,12 @@ struct BlockNode : ASTNode {
 };
 
 struct ParameterNode : ASTNode {
-    std::string name;
-    std::string type;
+    SymbolId symbol;
+    std::string_view name;
+    TypeId type;
 
-    ParameterNode(std::string name, std::string type)
-        : ASTNode(ASTNodeType::Parameter), name(std::move(name)), type(std::move(type)) {
+    ParameterNode(SymbolId symbol, std::string_view name, TypeId type)
+        : ASTNode(ASTNodeType::Parameter), symbol(symbol), name(name), type(type) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -310,18 +351,20 @@ struct ParameterNode : ASTNode {
 };
 
 struct FunctionNode : ASTNode {
-    std::string returnType;
-    std::string name;
-    std::vector<std::unique_ptr<ASTNode>> parameters;
-    std::unique_ptr<ASTNode> body;
-
-    FunctionNode(std::string returnType, std::string name,
-                 std::vector<std::unique_ptr<ASTNode>> parameters, std::unique_ptr<ASTNode> body)
+    TypeId returnType;
+    SymbolId symbol;
+    std::string_view name;
+    NodeList parameters;
+    ASTNode* body;
+
+    FunctionNode(TypeId returnType, SymbolId symbol, std::string_view name,
+                 NodeList parameters, ASTNode* body)
         : ASTNode(ASTNodeType::Function),
-          returnType(std::move(returnType)),
-          name(std::move(name)),
-          parameters(std::move(parameters)),
-          body(std::move(body)) {
+          returnType(returnType),
+          symbol(symbol),
+          name(name),
+          parameters(parameters),
+          body(body) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -330,13 +373,15 @@ struct FunctionNode : ASTNode {
 };
 
 struct FunctionCallNode : ExpressionNode {
-    std::string name;
-    std::vector<std::unique_ptr<ASTNode>> parameters;
+    SymbolId symbol;
+    std::string_view name;
+    NodeList parameters;
 
-    FunctionCallNode(std::string name, std::vector<std::unique_ptr<ASTNode>> parameters)
+    FunctionCallNode(SymbolId symbol, std::string_view name, NodeList parameters)
         : ExpressionNode(ASTNodeType::FunctionCall),
-          name(std::move(name)),
-          parameters(std::move(parameters)) {
+          symbol(symbol),
+          name(name),
+          parameters(parameters) {
     }
 
     void accept(ASTVisitor& visitor) override {
@@ -345,13 +390,32 @@ struct FunctionCallNode : ExpressionNode {
 };
 
 struct ReturnNode : ASTNode {
-    std::unique_ptr<ASTNode> returnValue;
+    ASTNode* returnValue;
 
-    ReturnNode(std::unique_ptr<ASTNode> returnValue)
-        : ASTNode(ASTNodeType::Return), returnValue(std::move(returnValue)) {
+    ReturnNode(ASTNode* returnValue) : ASTNode(ASTNodeType::Return), returnValue(returnValue) {
     }
 
     void accept(ASTVisitor& visitor) override {
         visitor.visit(*this);
     }
-};
\ No newline at end of file
+};
+
+// Names the language gives a meaning of its own. Every tree interns them first, so the passes can
+// key their built-in tables by these ids.
+constexpr SymbolId SYMBOL_IN   = 0;
+constexpr SymbolId SYMBOL_OUT  = 1;
+constexpr SymbolId SYMBOL_SIZE = 2;
+
+// Everything one translation unit owns. Names held by nodes view the interner's storage, never
+// the source text, so the tree outlives the buffer it was parsed from.
+struct AST {
+    AST() {
+        symbols.intern("in");
+        symbols.intern("out");
+        symbols.intern("size");
+    }
+
+    Arena arena;
+    Interner symbols;
+    BlockNode* root = nullptr;
+};
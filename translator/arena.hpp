@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Contiguous, arena-owned run of T. Trivially destructible, so it can live inside arena objects.
+template <typename T>
+class ArenaList {
+public:
+    ArenaList() = default;
+    ArenaList(T* items, size_t count) : items(items), count(count) {
+    }
+
+    [[nodiscard]] T* begin() const {
+        return items;
+    }
+    [[nodiscard]] T* end() const {
+        return items + count;
+    }
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+    T& operator[](size_t index) const {
+        return items[index];
+    }
+
+private:
+    T* items     = nullptr;
+    size_t count = 0;
+};
+
+// Bump allocator for everything one translation unit builds. Memory is handed out from large
+// blocks and released all at once when the arena dies; destructors never run, so only trivially
+// destructible types may be placed here.
+class Arena {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    Arena() = default;
+
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&&)            = default;
+    Arena& operator=(Arena&&) = default;
+
+    ~Arena() = default;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are released without running destructors");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    ArenaList<T> makeList(const T* items, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "arena lists are copied bytewise");
+        if (count == 0) {
+            return {};
+        }
+        auto* copy = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::memcpy(copy, items, sizeof(T) * count);
+        return {copy, count};
+    }
+
+    std::string_view copyString(std::string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        auto* copy = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(copy, text.data(), text.size());
+        return {copy, text.size()};
+    }
+
+    [[nodiscard]] size_t bytesUsed() const {
+        return used;
+    }
+
+private:
+    void* allocate(size_t size, size_t align) {
+        auto address = reinterpret_cast<uintptr_t>(cursor);  // NOLINT
+        size_t shift = (align - address % align) % align;
+
+        if (cursor == nullptr || shift + size > remaining) {
+            size_t blockSize = std::max(BLOCK_SIZE, size + align);
+            blocks.emplace_back(new std::byte[blockSize]);  // NOLINT
+            cursor    = blocks.back().get();
+            remaining = blockSize;
+
+            address = reinterpret_cast<uintptr_t>(cursor);  // NOLINT
+            shift   = (align - address % align) % align;
+        }
+
+        void* result = cursor + shift;
+        cursor += shift + size;
+        remaining -= shift + size;
+        used += size;
+        return result;
+    }
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;  // NOLINT
+    std::byte* cursor = nullptr;
+    size_t remaining  = 0;
+    size_t used       = 0;
+};
@@ -0,0 +1,392 @@
+#include "asmIR.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::string_view WHITESPACE     = " \t\r\n";
+constexpr std::string_view ORG_DIRECTIVE  = ".org";
+constexpr std::string_view ZERO_DIRECTIVE = ".zero";
+
+constexpr int BINARY  = 2;
+constexpr int DECIMAL = 10;
+constexpr int HEX     = 16;
+
+enum class Section : uint8_t { None, Text, Data };
+
+std::string_view trim(std::string_view text) {
+    size_t start = text.find_first_not_of(WHITESPACE);
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(WHITESPACE);
+    return text.substr(start, end - start + 1);
+}
+
+// Comments run from ';' to the end of the line, unless the ';' is inside a string.
+std::string_view stripComment(std::string_view line) {
+    bool inString = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] == '"') {
+            inString = !inString;
+        } else if (line[i] == '\\' && inString) {
+            i++;
+        } else if (line[i] == ';' && !inString) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// Decimal (optionally negative), 0x hex or 0b binary; nullopt for anything else.
+std::optional<long> parseNumber(std::string_view text) {
+    int base = DECIMAL;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = HEX;
+        text.remove_prefix(2);
+    } else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+        base = BINARY;
+        text.remove_prefix(2);
+    } else if (text.empty() || (text[0] != '-' && (text[0] < '0' || text[0] > '9'))) {
+        return std::nullopt;
+    }
+    if (base != DECIMAL && (text.empty() || text[0] == '-')) {
+        return std::nullopt;
+    }
+
+    long value      = 0;
+    const char* end = text.data() + text.size();
+    auto [ptr, ec]  = std::from_chars(text.data(), end, value, base);
+    if (ptr != end) {
+        return std::nullopt;
+    }
+    if (ec == std::errc::result_out_of_range) {
+        throw std::runtime_error("Number out of range: " + std::string(text));
+    }
+    return value;
+}
+
+Operand parseValue(std::string_view text, AsmProgram& program) {
+    if (std::optional<long> number = parseNumber(text)) {
+        return Operand::immediate(static_cast<uint32_t>(*number));
+    }
+    return Operand::label(program.label(text));
+}
+
+// Index of the quote closing the string that opens text, or npos.
+size_t closingQuote(std::string_view text) {
+    for (size_t i = 1; i < text.size(); i++) {
+        if (text[i] == '\\') {
+            i++;
+        } else if (text[i] == '"') {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// A label with no value marks the address of whatever follows it. Otherwise the value is a
+// comma-separated list of numbers, labels and strings, each string giving a word per character.
+std::vector<Operand> parseDataValue(std::string_view text, AsmProgram& program) {
+    if (text.empty()) {
+        return {};
+    }
+
+    if (startsWith(text, ZERO_DIRECTIVE)) {
+        std::optional<long> count = parseNumber(trim(text.substr(ZERO_DIRECTIVE.size())));
+        if (!count || *count <= 0) {
+            throw std::runtime_error("Invalid .zero count: " + std::string(text));
+        }
+        return std::vector<Operand>(*count, Operand::immediate(0));
+    }
+
+    std::vector<Operand> words;
+    while (true) {
+        text = trim(text);
+        if (!text.empty() && text.front() == '"') {
+            size_t close = closingQuote(text);
+            if (close == std::string_view::npos) {
+                throw std::runtime_error("Unterminated string: " + std::string(text));
+            }
+            std::vector<Operand> chars = decodeString(text.substr(1, close - 1));
+            words.insert(words.end(), chars.begin(), chars.end());
+
+            text.remove_prefix(close + 1);
+            text = trim(text);
+            if (text.empty()) {
+                return words;
+            }
+            if (text.front() != ',') {
+                throw std::runtime_error("Unknown data value: " + std::string(text));
+            }
+            text.remove_prefix(1);
+            continue;
+        }
+
+        size_t comma          = text.find(',');
+        std::string_view item = trim(text.substr(0, comma));
+        if (item.empty()) {
+            throw std::runtime_error("Unknown data value: " + std::string(text));
+        }
+        words.push_back(parseValue(item, program));
+
+        if (comma == std::string_view::npos) {
+            return words;
+        }
+        text.remove_prefix(comma + 1);
+    }
+}
+
+bool isPrintable(uint32_t value) {
+    return (value >= ' ' && value <= '~') || value == '\n' || value == '\t';
+}
+
+// Strings are stored as their length followed by one word per character; such runs read back
+// best as a count and a string literal.
+bool looksLikeString(const std::vector<Operand>& words) {
+    if (words.size() < 2 || words[0].kind != Operand::Kind::Immediate ||
+        words[0].value != words.size() - 1) {
+        return false;
+    }
+    return std::all_of(words.begin() + 1, words.end(), [](const Operand& word) {
+        return word.kind == Operand::Kind::Immediate && isPrintable(word.value);
+    });
+}
+
+void printString(std::ostream& out, const std::vector<Operand>& words) {
+    out << words[0].value << ", \"";
+    for (size_t i = 1; i < words.size(); i++) {
+        char character = static_cast<char>(words[i].value);
+        switch (character) {
+            case '\n':
+                out << "\\n";
+                break;
+            case '\t':
+                out << "\\t";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            case '"':
+                out << "\\\"";
+                break;
+            default:
+                out << character;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+std::vector<Operand> decodeString(std::string_view text) {
+    std::vector<Operand> words;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        char character = text[i];
+
+        if (character == '\\') {
+            if (i + 1 >= text.size()) {
+                throw std::runtime_error("Invalid escape sequence in string: " + std::string(text));
+            }
+            ++i;
+            switch (text[i]) {
+                case '0':
+                    character = '\0';
+                    break;
+                case 'n':
+                    character = '\n';
+                    break;
+                case 't':
+                    character = '\t';
+                    break;
+                case '\\':
+                    character = '\\';
+                    break;
+                case '"':
+                    character = '"';
+                    break;
+                default:
+                    throw std::runtime_error("Unsupported escape sequence: \\" +
+                                             std::string(1, text[i]));
+            }
+        }
+
+        words.push_back(Operand::immediate(static_cast<uint8_t>(character)));
+    }
+
+    return words;
+}
+
+std::optional<Opcode> findOpcode(std::string_view name) {
+    uint32_t key = packMnemonic(name);
+    if (key == 0) {
+        return std::nullopt;
+    }
+
+    for (uint32_t slot = mnemonicSlot(key);; slot = (slot + 1) % MNEMONIC_SLOTS.size()) {
+        uint8_t entry = MNEMONIC_SLOTS[slot];
+        if (entry == 0) {
+            return std::nullopt;
+        }
+        if (packMnemonic(MNEMONICS[entry - 1].name) == key) {
+            return MNEMONICS[entry - 1].opcode;
+        }
+    }
+}
+
+Operand AsmProgram::constant(uint32_t value) {
+    auto known = constants.find(value);
+    if (known != constants.end()) {
+        return Operand::label(known->second);
+    }
+
+    // The name may be in use already, by the runtime's data or by a reference yet to be defined.
+    LabelId name = label("const_" + std::to_string(value));
+    if (std::none_of(data.begin(), data.end(), [name](const DataItem& item) {
+            return item.label == name;
+        })) {
+        data.push_back({name, {Operand::immediate(value)}});
+    }
+    constants.emplace(value, name);
+    return Operand::label(name);
+}
+
+void AsmProgram::print(std::ostream& out) const {
+    auto printOperand = [&](const Operand& operand) {
+        if (operand.kind == Operand::Kind::Label) {
+            out << labelName(operand.value);
+        } else {
+            out << operand.value;
+        }
+    };
+
+    out << ".data\n";
+    for (const DataItem& item : data) {
+        out << "  " << labelName(item.label) << ":";
+        if (!item.words.empty()) {
+            out << " ";
+        }
+
+        bool allZero = std::all_of(item.words.begin(), item.words.end(), [](const Operand& word) {
+            return word.kind == Operand::Kind::Immediate && word.value == 0;
+        });
+
+        if (item.words.size() > 1 && allZero) {
+            out << ".zero " << item.words.size();
+        } else if (looksLikeString(item.words)) {
+            printString(out, item.words);
+        } else {
+            for (size_t i = 0; i < item.words.size(); i++) {
+                out << (i == 0 ? "" : ", ");
+                printOperand(item.words[i]);
+            }
+        }
+        out << "\n";
+    }
+
+    out << "\n.text\n";
+    out << ".org 0x" << std::hex << textOrigin << std::dec << "\n";
+    for (const TextItem& item : text) {
+        if (item.kind == TextItem::Kind::Label) {
+            out << labelName(item.operand.value) << ":\n";
+            continue;
+        }
+
+        out << "  " << mnemonicName(item.opcode);
+        if (item.opcode == Opcode::Adsp && item.operand.kind == Operand::Kind::Immediate) {
+            // Signed: negative values reserve stack words.
+            out << " " << static_cast<int32_t>(item.operand.value);
+        } else if (item.operand.kind != Operand::Kind::None) {
+            out << " ";
+            printOperand(item.operand);
+        }
+        out << "\n";
+    }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void parseAssembly(std::string_view source, AsmProgram& program) {
+    Section current = Section::None;
+
+    bool hasCode = std::any_of(program.text.begin(), program.text.end(), [](const auto& item) {
+        return item.kind == TextItem::Kind::Instruction;
+    });
+
+    while (!source.empty()) {
+        size_t newline        = source.find('\n');
+        std::string_view line = trim(stripComment(source.substr(0, newline)));
+        source.remove_prefix(newline == std::string_view::npos ? source.size() : newline + 1);
+
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line == ".text") {
+            current = Section::Text;
+            continue;
+        }
+        if (line == ".data") {
+            current = Section::Data;
+            continue;
+        }
+        if (current == Section::None) {
+            throw std::runtime_error("Line outside of .text and .data: " + std::string(line));
+        }
+
+        if (startsWith(line, ORG_DIRECTIVE)) {
+            std::string_view addrStr    = trim(line.substr(ORG_DIRECTIVE.size()));
+            std::optional<long> address = parseNumber(addrStr);
+            if (!address) {
+                throw std::runtime_error(".org must have numeric address: " + std::string(addrStr));
+            }
+            if (current != Section::Text || hasCode) {
+                throw std::runtime_error(".org is only allowed before the first instruction");
+            }
+            program.textOrigin = static_cast<uint32_t>(*address);
+            continue;
+        }
+
+        if (current == Section::Text) {
+            if (line.back() == ':') {
+                std::string_view label = trim(line.substr(0, line.size() - 1));
+                program.text.push_back(TextItem::labelAt(program.label(label)));
+                continue;
+            }
+
+            size_t split                = line.find_first_of(WHITESPACE);
+            std::string_view mnemonic   = line.substr(0, split);
+            std::string_view rest       =
+                split == std::string_view::npos ? "" : trim(line.substr(split));
+            std::string_view operandStr = rest.substr(0, rest.find_first_of(WHITESPACE));
+
+            std::optional<Opcode> opcode = findOpcode(mnemonic);
+            if (!opcode) {
+                throw std::runtime_error("Unknown opcode: " + std::string(mnemonic));
+            }
+
+            Operand operand;
+            if (!operandStr.empty()) {
+                operand = parseValue(operandStr, program);
+            }
+            program.text.push_back(TextItem::instruction(*opcode, operand));
+            hasCode = true;
+        } else {
+            size_t colonPos = line.find(':');
+            if (colonPos == std::string_view::npos) {
+                throw std::runtime_error("Invalid data entry: " + std::string(line));
+            }
+
+            std::string_view label    = trim(line.substr(0, colonPos));
+            std::string_view valueStr = trim(line.substr(colonPos + 1));
+
+            program.data.push_back({program.label(label), parseDataValue(valueStr, program)});
+        }
+    }
+}
@@ -0,0 +1,267 @@
+#ifndef _ASM_IR_H
+#define _ASM_IR_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lexer.h"
+
+// Machine opcodes; the value is the instruction's top byte.
+enum class Opcode : uint8_t {
+    Add = 0b000001,
+    Sub,
+    Div,
+    Mul,
+    Rem,
+    Inc,
+    Dec,
+    Not,
+    Cla,
+    Jmp,
+    Cmp,
+    Jz,
+    Jnz,
+    Jg,
+    Jge,
+    Jl,
+    Jle,
+    Ja,
+    Jae,
+    Jb,
+    Jbe,
+    Push,
+    Pop,
+    Ld,
+    Lda,
+    Ldi,
+    St,
+    Sta,
+    Call,
+    Ret,
+    Ei,
+    Di,
+    Iret,
+    Halt,
+    Tas,
+    Lds,
+    Sts,
+    Adsp,
+    Shl,
+    Shr,
+    And,
+    Or,
+    Xor,
+    Tax,
+    Ldx,
+    Stx,
+};
+
+struct Mnemonic {
+    std::string_view name;
+    Opcode opcode;
+};
+
+// clang-format off
+// Ordered by opcode value, starting at Opcode::Add.
+constexpr std::array<Mnemonic, 46> MNEMONICS = {{
+    {"add",  Opcode::Add},  {"sub",  Opcode::Sub},  {"div",  Opcode::Div},  {"mul",  Opcode::Mul},
+    {"rem",  Opcode::Rem},  {"inc",  Opcode::Inc},  {"dec",  Opcode::Dec},  {"not",  Opcode::Not},
+    {"cla",  Opcode::Cla},  {"jmp",  Opcode::Jmp},  {"cmp",  Opcode::Cmp},  {"jz",   Opcode::Jz},
+    {"jnz",  Opcode::Jnz},  {"jg",   Opcode::Jg},   {"jge",  Opcode::Jge},  {"jl",   Opcode::Jl},
+    {"jle",  Opcode::Jle},  {"ja",   Opcode::Ja},   {"jae",  Opcode::Jae},  {"jb",   Opcode::Jb},
+    {"jbe",  Opcode::Jbe},  {"push", Opcode::Push}, {"pop",  Opcode::Pop},  {"ld",   Opcode::Ld},
+    {"lda",  Opcode::Lda},  {"ldi",  Opcode::Ldi},  {"st",   Opcode::St},   {"sta",  Opcode::Sta},
+    {"call", Opcode::Call}, {"ret",  Opcode::Ret},  {"ei",   Opcode::Ei},   {"di",   Opcode::Di},
+    {"iret", Opcode::Iret}, {"halt", Opcode::Halt}, {"tas",  Opcode::Tas},  {"lds",  Opcode::Lds},
+    {"sts",  Opcode::Sts},  {"adsp", Opcode::Adsp}, {"shl",  Opcode::Shl},  {"shr",  Opcode::Shr},
+    {"and",  Opcode::And},  {"or",   Opcode::Or},   {"xor",  Opcode::Xor},  {"tax",  Opcode::Tax},
+    {"ldx",  Opcode::Ldx},  {"stx",  Opcode::Stx},
+}};
+// clang-format on
+
+constexpr std::string_view mnemonicName(Opcode opcode) {
+    return MNEMONICS[static_cast<size_t>(opcode) - static_cast<size_t>(Opcode::Add)].name;
+}
+
+constexpr bool isConditionalJump(Opcode opcode) {
+    return opcode >= Opcode::Jz && opcode <= Opcode::Jbe;
+}
+
+// Conditional jump taken exactly when the given one is not.
+constexpr Opcode invertedJump(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::Jz:
+            return Opcode::Jnz;
+        case Opcode::Jnz:
+            return Opcode::Jz;
+        case Opcode::Jg:
+            return Opcode::Jle;
+        case Opcode::Jle:
+            return Opcode::Jg;
+        case Opcode::Jge:
+            return Opcode::Jl;
+        case Opcode::Jl:
+            return Opcode::Jge;
+        case Opcode::Ja:
+            return Opcode::Jbe;
+        case Opcode::Jbe:
+            return Opcode::Ja;
+        case Opcode::Jae:
+            return Opcode::Jb;
+        case Opcode::Jb:
+            return Opcode::Jae;
+        default:
+            return opcode;
+    }
+}
+
+// Arithmetic, cmp and the loads set NZVC from their result; stores, stack moves and control
+// transfers leave the flags alone.
+constexpr bool writesFlags(Opcode opcode) {
+    return (opcode >= Opcode::Add && opcode <= Opcode::Not) ||
+           (opcode >= Opcode::Shl && opcode <= Opcode::Xor) || opcode == Opcode::Cmp ||
+           opcode == Opcode::Ld || opcode == Opcode::Lda || opcode == Opcode::Ldi ||
+           opcode == Opcode::Lds || opcode == Opcode::Ldx || opcode == Opcode::Tas;
+}
+
+// Mnemonics are one to four letters, so a lower-cased name packs into one word; 0 if the name
+// cannot be a mnemonic.
+constexpr uint32_t packMnemonic(std::string_view name) {
+    constexpr size_t MAX_LENGTH = 4;
+    if (name.empty() || name.size() > MAX_LENGTH) {
+        return 0;
+    }
+
+    uint32_t key = 0;
+    for (size_t i = 0; i < name.size(); i++) {
+        char character = name[i];
+        if (character >= 'A' && character <= 'Z') {
+            character = static_cast<char>(character - 'A' + 'a');
+        }
+        if (character < 'a' || character > 'z') {
+            return 0;
+        }
+        key |= static_cast<uint32_t>(character) << (8 * i);
+    }
+    return key;
+}
+
+constexpr uint32_t mnemonicSlot(uint32_t key) {
+    constexpr uint32_t FIBONACCI = 0x9E3779B9U;
+    constexpr uint32_t SLOT_BITS = 6;
+    return (key * FIBONACCI) >> (32 - SLOT_BITS);
+}
+
+// Open-addressed index into MNEMONICS (entry + 1, 0 for empty), built at compile time.
+constexpr std::array<uint8_t, 64> MNEMONIC_SLOTS = [] {
+    std::array<uint8_t, 64> slots{};
+    for (size_t entry = 0; entry < MNEMONICS.size(); entry++) {
+        uint32_t slot = mnemonicSlot(packMnemonic(MNEMONICS[entry].name));
+        while (slots[slot] != 0) {
+            slot = (slot + 1) % slots.size();
+        }
+        slots[slot] = static_cast<uint8_t>(entry + 1);
+    }
+    return slots;
+}();
+
+// Case-insensitive.
+std::optional<Opcode> findOpcode(std::string_view name);
+
+using LabelId = SymbolId;
+
+// Immediate value or reference to a label, resolved to the label's address when assembled.
+struct Operand {
+    enum class Kind : uint8_t { None, Immediate, Label };
+
+    Kind kind      = Kind::None;
+    uint32_t value = 0;  // the immediate, or the LabelId
+
+    static Operand immediate(uint32_t value) {
+        return {Kind::Immediate, value};
+    }
+    static Operand label(LabelId label) {
+        return {Kind::Label, label};
+    }
+};
+
+// One entry of the text section: a label bound to the next instruction, or an instruction.
+struct TextItem {
+    enum class Kind : uint8_t { Label, Instruction };
+
+    Kind kind;
+    Opcode opcode;
+    Operand operand;
+
+    static TextItem labelAt(LabelId label) {
+        return {Kind::Label, Opcode::Halt, Operand::label(label)};
+    }
+    static TextItem instruction(Opcode opcode, Operand operand = {}) {
+        return {Kind::Instruction, opcode, operand};
+    }
+};
+
+// Labelled run of data words.
+struct DataItem {
+    LabelId label;
+    std::vector<Operand> words;
+};
+
+// Assembly-level program shared by the code generator, the text assembler and the binarizer.
+// Text is laid out from textOrigin and data right after it; every label is defined at most once,
+// in either section.
+class AsmProgram {
+public:
+    AsmProgram() = default;
+
+    AsmProgram(const AsmProgram&)            = delete;
+    AsmProgram& operator=(const AsmProgram&) = delete;
+
+    AsmProgram(AsmProgram&&)            = default;
+    AsmProgram& operator=(AsmProgram&&) = default;
+
+    ~AsmProgram() = default;
+
+    LabelId label(std::string_view name) {
+        return labels.intern(name);
+    }
+    [[nodiscard]] LabelId findLabel(std::string_view name) const {
+        return labels.find(name);
+    }
+    [[nodiscard]] const std::string& labelName(LabelId label) const {
+        return labels.name(label);
+    }
+    [[nodiscard]] size_t labelCount() const {
+        return labels.size();
+    }
+
+    // Data word const_N holding value, added on first use unless the data already defines it,
+    // and shared by every later one, including the runtime's own.
+    Operand constant(uint32_t value);
+
+    // Text form that parseAssembly reads back into an equivalent program.
+    void print(std::ostream& out) const;
+
+    uint32_t textOrigin = 1;
+    std::vector<TextItem> text;
+    std::vector<DataItem> data;
+
+private:
+    Interner labels;
+    std::unordered_map<uint32_t, LabelId> constants;  // const_N words known to be defined
+};
+
+// One word per character of a string body written with the assembler's escapes
+// (\0 \n \t \\ \").
+std::vector<Operand> decodeString(std::string_view text);
+
+// Appends the assembly source to the program.
+void parseAssembly(std::string_view source, AsmProgram& program);
+
+#endif
@@ -1,71 +1,478 @@
 #include "codeGenerator.h"
 
-std::string CodeGenerator::generateCode(ASTNode* root) {
+#include <unordered_set>
+
+#include "ssaBuilder.h"
+#include "ssaLowering.h"
+
+namespace {
+
+// Comparisons, && / || and ! lower to jumps on their own; any other boolean is computed and tested.
+bool branchesOnCondition(ASTNode* node) {
+    if (node->nodeType == ASTNodeType::BinaryOp) {
+        Operator opr = dynamic_cast<BinaryOpNode*>(node)->op;
+        return isComparison(opr) || opr == Operator::And || opr == Operator::Or;
+    }
+    return node->nodeType == ASTNodeType::UnaryOp &&
+           dynamic_cast<UnaryOpNode*>(node)->op == Operator::Not;
+}
+
+// ALU instruction computing a binary operator's value; && and || work on 0/1 operands, and
+// comparisons only set the flags.
+Opcode aluOpcode(Operator opr) {
+    switch (opr) {
+        case Operator::Add:
+        case Operator::Or:
+            return Opcode::Add;
+        case Operator::Sub:
+            return Opcode::Sub;
+        case Operator::Mul:
+        case Operator::And:
+            return Opcode::Mul;
+        case Operator::Div:
+            return Opcode::Div;
+        case Operator::Rem:
+            return Opcode::Rem;
+        case Operator::ShiftLeft:
+            return Opcode::Shl;
+        case Operator::ShiftRight:
+            return Opcode::Shr;
+        case Operator::BitAnd:
+            return Opcode::And;
+        case Operator::BitOr:
+            return Opcode::Or;
+        case Operator::BitXor:
+            return Opcode::Xor;
+        default:
+            return Opcode::Cmp;
+    }
+}
+
+// Taken after `cmp`/`sub left, right` when the comparison holds.
+Opcode comparisonJump(Operator opr, bool isUnsigned) {
+    switch (opr) {
+        case Operator::Equal:
+            return Opcode::Jz;
+        case Operator::NotEqual:
+            return Opcode::Jnz;
+        case Operator::Greater:
+            return isUnsigned ? Opcode::Ja : Opcode::Jg;
+        case Operator::GreaterEqual:
+            return isUnsigned ? Opcode::Jae : Opcode::Jge;
+        case Operator::Less:
+            return isUnsigned ? Opcode::Jb : Opcode::Jl;
+        default:
+            return isUnsigned ? Opcode::Jbe : Opcode::Jle;
+    }
+}
+
+// k when node is the literal 2^k.
+std::optional<uint32_t> powerOfTwoExponent(ASTNode* node) {
+    if (node->nodeType != ASTNodeType::NumberLiteral) {
+        return std::nullopt;
+    }
+    auto value = static_cast<uint32_t>(dynamic_cast<NumberLiteralNode*>(node)->number);
+    if (value == 0 || (value & (value - 1)) != 0) {
+        return std::nullopt;
+    }
+    uint32_t exponent = 0;
+    while (value > 1) {
+        value >>= 1;
+        ++exponent;
+    }
+    return exponent;
+}
+
+bool isCommutative(Operator opr) {
+    return opr == Operator::Add || opr == Operator::Mul || opr == Operator::And ||
+           opr == Operator::Or || opr == Operator::Equal || opr == Operator::NotEqual ||
+           opr == Operator::BitAnd || opr == Operator::BitOr || opr == Operator::BitXor;
+}
+
+// Calls may write any variable, read input or print, so nothing is moved across them.
+bool hasSideEffects(ASTNode* node) {
+    switch (node->nodeType) {
+        case ASTNodeType::FunctionCall:
+            return true;
+        case ASTNodeType::BinaryOp: {
+            auto* binaryOp = dynamic_cast<BinaryOpNode*>(node);
+            return hasSideEffects(binaryOp->left) || hasSideEffects(binaryOp->right);
+        }
+        case ASTNodeType::UnaryOp:
+            return hasSideEffects(dynamic_cast<UnaryOpNode*>(node)->operand);
+        case ASTNodeType::ArrayGet: {
+            auto* arrayGet = dynamic_cast<ArrayGetNode*>(node);
+            return hasSideEffects(arrayGet->object) || hasSideEffects(arrayGet->index);
+        }
+        default:
+            return false;
+    }
+}
+
+// Any overload of the name counts.
+// An empty name matches a call to any function.
+bool callsFunction(ASTNode* node, std::string_view name) {
+    if (node == nullptr) {
+        return false;
+    }
+
+    auto anyCalls = [name](const NodeList& list) {
+        return std::any_of(list.begin(), list.end(),
+                           [name](ASTNode* child) { return callsFunction(child, name); });
+    };
+
+    switch (node->nodeType) {
+        case ASTNodeType::FunctionCall: {
+            auto* call = dynamic_cast<FunctionCallNode*>(node);
+            return name.empty() || call->name == name || anyCalls(call->parameters);
+        }
+        case ASTNodeType::MethodCall: {
+            auto* call = dynamic_cast<MethodCallNode*>(node);
+            return callsFunction(call->object, name) || anyCalls(call->arguments);
+        }
+        case ASTNodeType::BinaryOp: {
+            auto* binaryOp = dynamic_cast<BinaryOpNode*>(node);
+            return callsFunction(binaryOp->left, name) || callsFunction(binaryOp->right, name);
+        }
+        case ASTNodeType::UnaryOp:
+            return callsFunction(dynamic_cast<UnaryOpNode*>(node)->operand, name);
+        case ASTNodeType::ArrayGet: {
+            auto* arrayGet = dynamic_cast<ArrayGetNode*>(node);
+            return callsFunction(arrayGet->object, name) || callsFunction(arrayGet->index, name);
+        }
+        case ASTNodeType::VarDecl:
+            return callsFunction(dynamic_cast<VarDeclNode*>(node)->value, name);
+        case ASTNodeType::Assignment: {
+            auto* assign = dynamic_cast<AssignNode*>(node);
+            return callsFunction(assign->var1, name) || callsFunction(assign->var2, name);
+        }
+        case ASTNodeType::If: {
+            auto* ifNode = dynamic_cast<IfNode*>(node);
+            return callsFunction(ifNode->condition, name) ||
+                   callsFunction(ifNode->thenBranch, name) ||
+                   callsFunction(ifNode->elseBranch, name);
+        }
+        case ASTNodeType::While: {
+            auto* whileNode = dynamic_cast<WhileNode*>(node);
+            return callsFunction(whileNode->condition, name) ||
+                   callsFunction(whileNode->body, name);
+        }
+        case ASTNodeType::Block:
+            return anyCalls(dynamic_cast<BlockNode*>(node)->children);
+        case ASTNodeType::Return:
+            return callsFunction(dynamic_cast<ReturnNode*>(node)->returnValue, name);
+        default:
+            return false;
+    }
+}
+
+// Whether evaluating the expression may read the variable called name.
+bool readsVariable(ASTNode* node, std::string_view name) {
+    if (node == nullptr) {
+        return false;
+    }
+
+    auto anyReads = [name](const NodeList& list) {
+        return std::any_of(list.begin(), list.end(),
+                           [name](ASTNode* child) { return readsVariable(child, name); });
+    };
+
+    switch (node->nodeType) {
+        case ASTNodeType::Identifier:
+            return dynamic_cast<IdentifierNode*>(node)->name == name;
+        case ASTNodeType::FunctionCall:
+            return anyReads(dynamic_cast<FunctionCallNode*>(node)->parameters);
+        case ASTNodeType::MethodCall: {
+            auto* call = dynamic_cast<MethodCallNode*>(node);
+            return readsVariable(call->object, name) || anyReads(call->arguments);
+        }
+        case ASTNodeType::BinaryOp: {
+            auto* binaryOp = dynamic_cast<BinaryOpNode*>(node);
+            return readsVariable(binaryOp->left, name) || readsVariable(binaryOp->right, name);
+        }
+        case ASTNodeType::UnaryOp:
+            return readsVariable(dynamic_cast<UnaryOpNode*>(node)->operand, name);
+        case ASTNodeType::ArrayGet: {
+            auto* arrayGet = dynamic_cast<ArrayGetNode*>(node);
+            return readsVariable(arrayGet->object, name) || readsVariable(arrayGet->index, name);
+        }
+        default:
+            return false;
+    }
+}
+
+// Every variable name the subtree mentions.
+void collectNames(ASTNode* node, std::unordered_set<std::string>& names) {
+    if (node == nullptr) {
+        return;
+    }
+
+    auto collectAll = [&names](const NodeList& list) {
+        for (ASTNode* child : list) {
+            collectNames(child, names);
+        }
+    };
+
+    switch (node->nodeType) {
+        case ASTNodeType::Identifier:
+            names.emplace(dynamic_cast<IdentifierNode*>(node)->name);
+            break;
+        case ASTNodeType::VarDecl: {
+            auto* varDecl = dynamic_cast<VarDeclNode*>(node);
+            names.emplace(varDecl->name);
+            collectNames(varDecl->value, names);
+            break;
+        }
+        case ASTNodeType::FunctionCall:
+            collectAll(dynamic_cast<FunctionCallNode*>(node)->parameters);
+            break;
+        case ASTNodeType::MethodCall: {
+            auto* call = dynamic_cast<MethodCallNode*>(node);
+            collectNames(call->object, names);
+            collectAll(call->arguments);
+            break;
+        }
+        case ASTNodeType::BinaryOp: {
+            auto* binaryOp = dynamic_cast<BinaryOpNode*>(node);
+            collectNames(binaryOp->left, names);
+            collectNames(binaryOp->right, names);
+            break;
+        }
+        case ASTNodeType::UnaryOp:
+            collectNames(dynamic_cast<UnaryOpNode*>(node)->operand, names);
+            break;
+        case ASTNodeType::ArrayGet: {
+            auto* arrayGet = dynamic_cast<ArrayGetNode*>(node);
+            collectNames(arrayGet->object, names);
+            collectNames(arrayGet->index, names);
+            break;
+        }
+        case ASTNodeType::Assignment: {
+            auto* assign = dynamic_cast<AssignNode*>(node);
+            collectNames(assign->var1, names);
+            collectNames(assign->var2, names);
+            break;
+        }
+        case ASTNodeType::If: {
+            auto* ifNode = dynamic_cast<IfNode*>(node);
+            collectNames(ifNode->condition, names);
+            collectNames(ifNode->thenBranch, names);
+            collectNames(ifNode->elseBranch, names);
+            break;
+        }
+        case ASTNodeType::While: {
+            auto* whileNode = dynamic_cast<WhileNode*>(node);
+            collectNames(whileNode->condition, names);
+            collectNames(whileNode->body, names);
+            break;
+        }
+        case ASTNodeType::Block:
+            collectAll(dynamic_cast<BlockNode*>(node)->children);
+            break;
+        case ASTNodeType::Return:
+            collectNames(dynamic_cast<ReturnNode*>(node)->returnValue, names);
+            break;
+        default:
+            break;
+    }
+}
+
+}  // namespace
+
+AsmProgram CodeGenerator::generateCode(ASTNode* root) {
     if (root == nullptr || root->nodeType != ASTNodeType::Block) {
         throw std::runtime_error("Root node must be block");
     }
 
-    dataSection.clear();
+    program = AsmProgram();
+    loadRuntime();
+
     codeSection.clear();
     funcSection.clear();
     variables.clear();
     functionLabels.clear();
     functions.clear();
+    ssaBodies.clear();
+
+    section = &codeSection;
 
     labelCounter = 0;
     strCounter   = 0;
     arrCounter   = 0;
 
-    emitCodeLabel("_start");
-    root->accept(*this);
-    emitCode("halt");
+    if (ssaPasses != nullptr) {
+        generateSsa(*dynamic_cast<BlockNode*>(root));
+    } else {
+        emitCodeLabel("_start");
+        root->accept(*this);
+        emitCode(Opcode::Halt);
+    }
+
+    if (peephole != nullptr) {
+        peephole->optimize(funcSection, program);
+        peephole->optimize(codeSection, program);
+    }
+
+    program.text.insert(program.text.end(), funcSection.begin(), funcSection.end());
+    program.text.insert(program.text.end(), codeSection.begin(), codeSection.end());
+    linkRuntime();
 
-    return assembleCode();
+    return std::move(program);
 }
 
-void CodeGenerator::visit(VarDeclNode& node) {
-    std::string varLabel = getVarLabel(node.name);
+// Statements and functions are taken in order, so a function sees exactly the globals declared
+// before it, as with the direct translation. The main program keeps a variable in its var_ cell
+// only when some function mentions the name; every other variable lives in SSA values.
+void CodeGenerator::generateSsa(BlockNode& root) {
+    std::unordered_set<std::string> functionNames;
+    for (ASTNode* child : root.children) {
+        if (child->nodeType == ASTNodeType::Function) {
+            collectNames(dynamic_cast<FunctionNode*>(child)->body, functionNames);
+        }
+    }
 
-    if (node.type == "int[]") {
-        emitData(varLabel + ": 0");
-        variables[varLabel] = node.type;
+    auto calleeLabel = [this](FunctionCallNode& call) -> const std::string& {
+        return findFunction(call)->label;
+    };
+    SsaBuilder builder(program, strCounter, arrCounter, calleeLabel);
+    std::vector<ASTNode*> statements;
+    for (ASTNode* child : root.children) {
+        if (child->nodeType != ASTNodeType::Function) {
+            declareGlobals(child);
+            statements.push_back(child);
+            continue;
+        }
+
+        auto* node = dynamic_cast<FunctionNode*>(child);
+        if (callsFunction(node->body, node->name)) {
+            node->accept(*this);
+            continue;
+        }
+
+        FunctionData funcData = describeFunction(*node);
+        functions[node->symbol].push_back(funcData);
+        auto isGlobal = [this](std::string_view name) {
+            return variables.count("var_" + std::string(name)) != 0;
+        };
+        size_t begin = funcSection.size();
+        generateSsaFunction(builder.buildFunction(*node, funcData.label, isGlobal), funcSection);
+
+        auto size = std::count_if(funcSection.begin() + static_cast<long>(begin), funcSection.end(),
+                                  [](const TextItem& item) {
+                                      return item.kind == TextItem::Kind::Instruction;
+                                  });
+        if (static_cast<size_t>(size) > inlineLimit) {
+            ssaBodies.erase(funcData.label);
+            continue;
+        }
+        funcSection.resize(begin);
+        makeInlineable(*node);
+    }
+
+    auto isShared = [&functionNames](std::string_view name) {
+        return functionNames.count(std::string(name)) != 0;
+    };
+    generateSsaFunction(builder.buildProgram(statements, isShared), codeSection);
+}
+
+void CodeGenerator::generateSsaFunction(SsaFunction function, std::vector<TextItem>& out) {
+    inlineCalls(function, [this](const std::string& label) -> const SsaFunction* {
+        auto body = ssaBodies.find(label);
+        return body != ssaBodies.end() ? &body->second : nullptr;
+    });
+    ssaPasses->run(function);
+    if (ssaDump != nullptr) {
+        function.print(*ssaDump);
+        *ssaDump << "\n";
+    }
+    // Lowering rewrites the function, and the caller only learns afterwards whether the copy
+    // is worth keeping for inlining.
+    if (function.name != "_start") {
+        ssaBodies.insert_or_assign(function.name, function);
+    }
+    SsaLowering(program).lower(function, out);
+}
+
+void CodeGenerator::declareGlobals(ASTNode* node) {
+    if (node == nullptr) {
+        return;
+    }
+
+    switch (node->nodeType) {
+        case ASTNodeType::VarDecl: {
+            auto* varDecl        = dynamic_cast<VarDeclNode*>(node);
+            std::string varLabel = "var_" + std::string(varDecl->name);
+            if (variables.count(varLabel) == 0) {
+                emitData(varLabel, {Operand::immediate(0)});
+                variables[varLabel] = varDecl->type;
+            }
+            break;
+        }
+        case ASTNodeType::Block:
+            for (ASTNode* child : dynamic_cast<BlockNode*>(node)->children) {
+                declareGlobals(child);
+            }
+            break;
+        case ASTNodeType::If: {
+            auto* ifNode = dynamic_cast<IfNode*>(node);
+            declareGlobals(ifNode->thenBranch);
+            declareGlobals(ifNode->elseBranch);
+            break;
+        }
+        case ASTNodeType::While:
+            declareGlobals(dynamic_cast<WhileNode*>(node)->body);
+            break;
+        default:
+            break;
+    }
+}
 
+void CodeGenerator::visit(VarDeclNode& node) {
+    if (std::optional<FrameSlot> slot = frameSlot(node.name)) {
         node.value->accept(*this);
+        emitCode(Opcode::Sts, Operand::immediate(slot->offset));
+        return;
+    }
 
-        emitCode("st " + varLabel);
-    } else {
-        emitData(varLabel + ": 0");
+    std::string varLabel = getVarLabel(node.name);
+
+    // An inlined body declares its locals again at every call site.
+    if (variables.count(varLabel) == 0) {
+        emitData(varLabel, {Operand::immediate(0)});
         variables[varLabel] = node.type;
-        node.value->accept(*this);
-        emitCode("st " + varLabel);
     }
+
+    node.value->accept(*this);
+    emitCode(Opcode::St, varLabel);
 }
 
 void CodeGenerator::visit(NumberLiteralNode& node) {
-    if (node.number > FULL_MASK_24) {
-        std::string constLabel = "const_" + std::to_string(node.number);
-        emitData(constLabel + ": " + std::to_string(node.number));
-        emitCode("ld " + constLabel);
+    // ldi takes a 24-bit operand, so wider and negative values are loaded from the data section.
+    auto bits = static_cast<uint32_t>(node.number);
+    if (bits > FULL_MASK_24) {
+        emitCode(Opcode::Ld, program.constant(bits));
     } else {
-        emitCode("ldi " + std::to_string(node.number));
+        emitCode(Opcode::Ldi, Operand::immediate(node.number));
     }
 }
 
 void CodeGenerator::visit(CharLiteralNode& node) {
     int char_code = static_cast<int>(node.value);
 
-    emitCode("ldi " + std::to_string(char_code));
+    emitCode(Opcode::Ldi, Operand::immediate(char_code));
 }
 
 void CodeGenerator::visit(StringLiteralNode& node) {
     std::string strLabel = "str_" + std::to_string(strCounter++);
 
-    emitData(strLabel + ": \"" + node.value + "\\0\"");
-    emitCode("ldi " + strLabel);
+    std::vector<Operand> chars = decodeString(node.value);
+    chars.insert(chars.begin(), Operand::immediate(chars.size()));
+    emitData(strLabel, std::move(chars));
+    emitCode(Opcode::Ldi, strLabel);
 }
 
 void CodeGenerator::visit(BooleanLiteralNode& node) {
-    emitCode("ldi " + std::to_string(node.value ? 1 : 0));
+    emitCode(Opcode::Ldi, Operand::immediate(node.value ? 1 : 0));
 }
 
 void CodeGenerator::visit(VoidLiteralNode& node) {
@@ -74,26 +481,65 @@ void CodeGenerator::visit(VoidLiteralNode& node) {
 void CodeGenerator::visit(IntArrayLiteralNode& node) {
     std::string arrLabel = "arr_" + std::to_string(arrCounter++);
 
-    std::string dataLine = arrLabel + ": ";
-    for (size_t i = 0; i < node.values.size(); i++) {
-        auto* numberNode = dynamic_cast<NumberLiteralNode*>(node.values[i].get());
-        dataLine += std::to_string(numberNode->number) + (i == node.values.size() - 1 ? "" : ", ");
+    // Length first, like arrays read from input: size() is one load.
+    std::vector<Operand> values = {Operand::immediate(node.values.size())};
+    for (ASTNode* value : node.values) {
+        auto* numberNode = dynamic_cast<NumberLiteralNode*>(value);
+        values.push_back(Operand::immediate(static_cast<uint32_t>(numberNode->number)));
     }
-    emitData(dataLine);
+    emitData(arrLabel, std::move(values));
 
-    emitCode("ldi " + arrLabel);
+    emitCode(Opcode::Ldi, arrLabel);
 }
 
 void CodeGenerator::visit(ArrayGetNode& node) {
+    if (isIndexable(node)) {
+        Operand array = emitIndexBase(node);
+        node.index->accept(*this);
+        emitCode(Opcode::Ldx, array);
+        return;
+    }
+
+    emitElementAddress(node);
+    emitCode(Opcode::St, "temp_right");
+    emitCode(Opcode::Lda, "temp_right");
+}
+
+// ldx/stx take the array through a word holding its pointer: the variable itself, or temp_right
+// for a frame slot. The index is computed after that word would have been read, so it must not
+// be able to reassign it, and with temp_right it must be a plain load.
+bool CodeGenerator::isIndexable(ArrayGetNode& node) {
+    if (node.object->nodeType != ASTNodeType::Identifier || hasSideEffects(node.index)) {
+        return false;
+    }
+    if (!frameSlot(dynamic_cast<IdentifierNode*>(node.object)->name)) {
+        return true;
+    }
+    return memoryOperand(node.index) ||
+           (node.index->nodeType == ASTNodeType::Identifier &&
+            frameSlot(dynamic_cast<IdentifierNode*>(node.index)->name));
+}
+
+Operand CodeGenerator::emitIndexBase(ArrayGetNode& node) {
+    if (std::optional<Operand> array = memoryOperand(node.object)) {
+        return *array;
+    }
     node.object->accept(*this);
-    emitCode("push");
-    node.index->accept(*this);
+    emitCode(Opcode::St, "temp_right");
+    return Operand::label(program.label("temp_right"));
+}
 
-    emitCode("st temp_right");
-    emitCode("pop");
-    emitCode("add temp_right");
-    emitCode("st temp_right");
-    emitCode("lda temp_right");
+// Elements follow the length word, so element i is at object + 1 + i.
+void CodeGenerator::emitElementAddress(ArrayGetNode& node) {
+    if (node.index->nodeType == ASTNodeType::NumberLiteral) {
+        auto index = static_cast<uint32_t>(dynamic_cast<NumberLiteralNode*>(node.index)->number);
+        node.object->accept(*this);
+        emitCode(Opcode::Add, program.constant(index + 1));
+        return;
+    }
+
+    emitOperation(Opcode::Add, node.object, node.index, true);
+    emitCode(Opcode::Inc);
 }
 
 void CodeGenerator::visit(MethodCallNode& node) {
@@ -101,184 +547,159 @@ void CodeGenerator::visit(MethodCallNode& node) {
         throw std::runtime_error("method call on complex expressions not supported");
     }
 
-    auto* objIdentifier = dynamic_cast<IdentifierNode*>(node.object.get());
-
-    std::string varLabel = getVarLabel(objIdentifier->name);
-
-    if (node.methodName == "size") {
+    // Arrays and strings start with their length.
+    if (node.method == SYMBOL_SIZE) {
+        if (std::optional<Operand> object = memoryOperand(node.object)) {
+            emitCode(Opcode::Lda, *object);
+            return;
+        }
         node.object->accept(*this);
-
-        emitCode("call arr_size");
+        emitCode(Opcode::St, "temp_right");
+        emitCode(Opcode::Lda, "temp_right");
     }
 }
 
 void CodeGenerator::visit(IdentifierNode& node) {
+    if (std::optional<FrameSlot> slot = frameSlot(node.name)) {
+        emitCode(Opcode::Lds, Operand::immediate(slot->offset));
+        return;
+    }
+
     std::string varLabel = getVarLabel(node.name);
-    std::string varType  = variables.at(varLabel);
+    TypeId varType       = variables.at(varLabel);
 
-    if (varType == "int[]") {
-        emitCode("ld " + varLabel);
+    if (varType == TypeId::IntArray) {
+        emitCode(Opcode::Ld, varLabel);
     } else {
-        emitCode("ld " + varLabel);
+        emitCode(Opcode::Ld, varLabel);
     }
 }
 
 void CodeGenerator::visit(AssignNode& node) {
-    node.var2->accept(*this);
-
-    ASTNode* lhs = node.var1.get();
+    ASTNode* lhs = node.var1;
 
     if (lhs->nodeType == ASTNodeType::Identifier) {
-        auto* identifier     = dynamic_cast<IdentifierNode*>(lhs);
+        node.var2->accept(*this);
+
+        auto* identifier = dynamic_cast<IdentifierNode*>(lhs);
+        if (std::optional<FrameSlot> slot = frameSlot(identifier->name)) {
+            emitCode(Opcode::Sts, Operand::immediate(slot->offset));
+            return;
+        }
+
         std::string varLabel = getVarLabel(identifier->name);
-        emitCode("st " + varLabel);
+        emitCode(Opcode::St, varLabel);
     } else if (lhs->nodeType == ASTNodeType::ArrayGet) {
         auto* arrayGet = dynamic_cast<ArrayGetNode*>(lhs);
-        emitCode("push");
+
+        // The value waits in XR while the pointer and index are loaded; neither touches XR.
+        if (isIndexable(*arrayGet)) {
+            node.var2->accept(*this);
+            emitCode(Opcode::Tax);
+            Operand array = emitIndexBase(*arrayGet);
+            arrayGet->index->accept(*this);
+            emitCode(Opcode::Stx, array);
+            return;
+        }
+
+        // A value in memory is loaded after the address instead of waiting on the stack.
+        std::optional<Operand> value = memoryOperand(node.var2);
+        if (value && !hasSideEffects(lhs)) {
+            emitElementAddress(*arrayGet);
+            emitCode(Opcode::St, "temp_right");
+            emitCode(Opcode::Ld, *value);
+            emitCode(Opcode::Sta, "temp_right");
+            return;
+        }
+
+        node.var2->accept(*this);
+        emitCode(Opcode::Push);
 
         arrayGet->index->accept(*this);
-        emitCode("st temp_right");
+        emitCode(Opcode::St, "temp_right");
 
         arrayGet->object->accept(*this);
-        emitCode("add temp_right");
-        emitCode("st temp_right");
+        emitCode(Opcode::Add, "temp_right");
+        emitCode(Opcode::Inc);
+        emitCode(Opcode::St, "temp_right");
 
-        emitCode("pop");
-        emitCode("sta temp_right");
+        emitCode(Opcode::Pop);
+        emitCode(Opcode::Sta, "temp_right");
     }
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void CodeGenerator::visit(BinaryOpNode& node) {
-    const std::string& opr = node.op;
-    bool isLogicalOp = (opr == ">" || opr == "<" || opr == ">=" || opr == "<=" || opr == "==" ||
-                        opr == "!=" || opr == "&&" || opr == "||");
+    Operator opr     = node.op;
+    bool isLogicalOp = isComparison(opr) || opr == Operator::And || opr == Operator::Or;
 
-    std::string leftType  = dynamic_cast<ExpressionNode*>(node.left.get())->resolvedType;
-    std::string rightType = dynamic_cast<ExpressionNode*>(node.right.get())->resolvedType;
+    TypeId leftType  = dynamic_cast<ExpressionNode*>(node.left)->resolvedType;
+    TypeId rightType = dynamic_cast<ExpressionNode*>(node.right)->resolvedType;
+
+    bool isUnsignedCmp = leftType == TypeId::Uint || rightType == TypeId::Uint;
 
     if (isLogicalOp && !currentTrueLabel.empty() && !currentFalseLabel.empty()) {
-        if (opr == "&&") {
+        // The right side's code follows the left side's, so the left side falls through into it.
+        if (opr == Operator::And) {
             std::string rightSideLabel = getNewLabel();
-            visitWithLabels(node.left.get(), rightSideLabel, currentFalseLabel);
+            visitWithLabels(node.left, rightSideLabel, currentFalseLabel, rightSideLabel);
 
             emitCodeLabel(rightSideLabel);
-            visitWithLabels(node.right.get(), currentTrueLabel, currentFalseLabel);
+            visitWithLabels(node.right, currentTrueLabel, currentFalseLabel, currentNextLabel);
 
             return;
         }
 
-        if (opr == "||") {
+        if (opr == Operator::Or) {
             std::string rightSideLabel = getNewLabel();
-            visitWithLabels(node.left.get(), currentTrueLabel, rightSideLabel);
+            visitWithLabels(node.left, currentTrueLabel, rightSideLabel, rightSideLabel);
 
             emitCodeLabel(rightSideLabel);
-            visitWithLabels(node.right.get(), currentTrueLabel, currentFalseLabel);
+            visitWithLabels(node.right, currentTrueLabel, currentFalseLabel, currentNextLabel);
 
             return;
         }
 
-        node.left->accept(*this);
-        emitCode("push");
-
-        node.right->accept(*this);
-        emitCode("st temp_right");
-        emitCode("pop");
-        emitCode("sub temp_right");
-
-        if (opr == "==") {
-            emitCode("jz " + currentTrueLabel);
-        } else if (opr == "!=") {
-            emitCode("jnz " + currentTrueLabel);
-        } else if (opr == ">") {
-            emitCode("jg " + currentTrueLabel);
-        } else if (opr == ">=") {
-            emitCode("jge " + currentTrueLabel);
-        } else if (opr == "<") {
-            emitCode("jl " + currentTrueLabel);
-        } else if (opr == "<=") {
-            emitCode("jle " + currentTrueLabel);
-        }
-
-        emitCode("jmp " + currentFalseLabel);
+        // Operands are plain values; only this comparison branches.
+        std::string trueLabel  = std::move(currentTrueLabel);
+        std::string falseLabel = std::move(currentFalseLabel);
+        std::string nextLabel  = std::move(currentNextLabel);
+        currentTrueLabel.clear();
+        currentFalseLabel.clear();
+        currentNextLabel.clear();
+
+        emitOperation(Opcode::Sub, node.left, node.right, isCommutative(opr));
+        emitBranch(comparisonJump(opr, isUnsignedCmp), trueLabel, falseLabel, nextLabel);
+
+        currentTrueLabel  = std::move(trueLabel);
+        currentFalseLabel = std::move(falseLabel);
+        currentNextLabel  = std::move(nextLabel);
+    } else if (emitStrengthReduced(node)) {
+        return;
     } else {
-        node.left->accept(*this);
-        emitCode("push");
-
-        node.right->accept(*this);
-        emitCode("st temp_right");
-        emitCode("pop");
-
-        if (opr == "+") {
-            emitCode("add temp_right");
-        } else if (opr == "-") {
-            emitCode("sub temp_right");
-        } else if (opr == "*") {
-            emitCode("mul temp_right");
-        } else if (opr == "/") {
-            emitCode("div temp_right");
-        } else if (opr == "%") {
-            emitCode("rem temp_right");
-        }
-
-        else if (opr == "&&") {
-            emitCode("mul temp_right");
-        } else if (opr == "||") {
-            emitCode("add temp_right");
+        emitOperation(aluOpcode(opr), node.left, node.right, isCommutative(opr));
 
+        if (opr == Operator::Or) {
             std::string falseLabel = getNewLabel();
             std::string endLabel   = getNewLabel();
 
-            emitCode("jz " + falseLabel);
-            emitCode("ldi 1");
-            emitCode("jmp " + endLabel);
+            emitCode(Opcode::Jz, falseLabel);
+            emitCode(Opcode::Ldi, Operand::immediate(1));
+            emitCode(Opcode::Jmp, endLabel);
             emitCodeLabel(falseLabel);
-            emitCode("ldi 0");
+            emitCode(Opcode::Ldi, Operand::immediate(0));
             emitCodeLabel(endLabel);
-        } else if (opr == ">" || opr == "<" || opr == ">=" || opr == "<=" || opr == "==" ||
-                   opr == "!=") {
-            emitCode("cmp temp_right");
-
-            bool isUnsignedCmp = (leftType == "uint" || rightType == "uint");
-
+        } else if (isComparison(opr)) {
             std::string trueLabel = getNewLabel();
             std::string endLabel  = getNewLabel();
 
-            if (isUnsignedCmp) {
-                if (opr == "==") {
-                    emitCode("jz " + trueLabel);
-                } else if (opr == "!=") {
-                    emitCode("jnz " + trueLabel);
-                } else if (opr == ">") {
-                    emitCode("ja " + trueLabel);
-                } else if (opr == ">=") {
-                    emitCode("jae " + trueLabel);
-                } else if (opr == "<") {
-                    emitCode("jb " + trueLabel);
-                } else if (opr == "<=") {
-                    emitCode("jbe " + trueLabel);
-                }
-            } else {
-                if (opr == "==") {
-                    emitCode("jz " + trueLabel);
-                } else if (opr == "!=") {
-                    emitCode("jnz " + trueLabel);
-                } else if (opr == ">") {
-                    emitCode("jg " + trueLabel);
-                } else if (opr == ">=") {
-                    emitCode("jge " + trueLabel);
-                } else if (opr == "<") {
-                    emitCode("jl " + trueLabel);
-                } else if (opr == "<=") {
-                    emitCode("jle " + trueLabel);
-                }
-            }
+            emitCode(comparisonJump(opr, isUnsignedCmp), trueLabel);
 
-            emitCode("ldi 0");
-            emitCode("jmp " + endLabel);
+            emitCode(Opcode::Ldi, Operand::immediate(0));
+            emitCode(Opcode::Jmp, endLabel);
 
             emitCodeLabel(trueLabel);
-            emitCode("ldi 1");
+            emitCode(Opcode::Ldi, Operand::immediate(1));
 
             emitCodeLabel(endLabel);
         }
@@ -286,29 +707,29 @@ void CodeGenerator::visit(BinaryOpNode& node) {
 }
 
 void CodeGenerator::visit(UnaryOpNode& node) {
-    const std::string& opr = node.op;
+    Operator opr = node.op;
 
-    if (opr == "!" && !currentTrueLabel.empty() && !currentFalseLabel.empty()) {
-        visitWithLabels(node.operand.get(), currentFalseLabel, currentTrueLabel);
+    if (opr == Operator::Not && !currentTrueLabel.empty() && !currentFalseLabel.empty()) {
+        visitWithLabels(node.operand, currentFalseLabel, currentTrueLabel, currentNextLabel);
         return;
     }
 
     node.operand->accept(*this);
 
-    if (opr == "-") {
-        emitCode("not");
-        emitCode("inc");
-    } else if (opr == "!") {
+    if (opr == Operator::Sub) {
+        emitCode(Opcode::Not);
+        emitCode(Opcode::Inc);
+    } else if (opr == Operator::Not) {
         std::string trueLabel = getNewLabel();
         std::string endLabel  = getNewLabel();
 
-        emitCode("jz " + trueLabel);
+        emitCode(Opcode::Jz, trueLabel);
 
-        emitCode("ldi 0");
-        emitCode("jmp " + endLabel);
+        emitCode(Opcode::Ldi, Operand::immediate(0));
+        emitCode(Opcode::Jmp, endLabel);
 
         emitCodeLabel(trueLabel);
-        emitCode("ldi 1");
+        emitCode(Opcode::Ldi, Operand::immediate(1));
 
         emitCodeLabel(endLabel);
     }
@@ -319,24 +740,13 @@ void CodeGenerator::visit(IfNode& node) {
     std::string elseLabel = node.elseBranch != nullptr ? getNewLabel() : "";
     std::string endLabel  = getNewLabel();
 
-    this->currentTrueLabel  = thenLabel;
-    this->currentFalseLabel = node.elseBranch != nullptr ? elseLabel : endLabel;
-
-    node.condition->accept(*this);
-
-    auto* condNode = node.condition.get();
-    if (condNode->nodeType != ASTNodeType::BinaryOp && condNode->nodeType != ASTNodeType::UnaryOp) {
-        emitCode("jnz " + this->currentTrueLabel);
-        emitCode("jmp " + this->currentFalseLabel);
-    }
-
-    this->currentTrueLabel  = "";
-    this->currentFalseLabel = "";
+    visitWithLabels(node.condition, thenLabel, node.elseBranch != nullptr ? elseLabel : endLabel,
+                    thenLabel);
 
     emitCodeLabel(thenLabel);
     node.thenBranch->accept(*this);
     if (node.elseBranch != nullptr) {
-        emitCode("jmp " + endLabel);
+        emitCode(Opcode::Jmp, endLabel);
         emitCodeLabel(elseLabel);
         node.elseBranch->accept(*this);
     }
@@ -344,34 +754,27 @@ void CodeGenerator::visit(IfNode& node) {
     emitCodeLabel(endLabel);
 }
 
+// Rotated: the condition is tested once on entry and then at the bottom of the body, so an
+// iteration runs a single conditional branch back to the top.
 void CodeGenerator::visit(WhileNode& node) {
-    std::string startLabel = getNewLabel();
-    std::string bodyLabel  = getNewLabel();
-    std::string endLabel   = getNewLabel();
+    std::string bodyLabel = getNewLabel();
+    std::string endLabel  = getNewLabel();
 
     breakLabels.push_back(endLabel);
 
-    emitCodeLabel(startLabel);
-
-    this->currentTrueLabel  = bodyLabel;
-    this->currentFalseLabel = endLabel;
-
-    node.condition->accept(*this);
-
-    this->currentTrueLabel  = "";
-    this->currentFalseLabel = "";
+    visitWithLabels(node.condition, bodyLabel, endLabel, bodyLabel);
 
     emitCodeLabel(bodyLabel);
     node.body->accept(*this);
 
-    emitCode("jmp " + startLabel);
+    visitWithLabels(node.condition, bodyLabel, endLabel, endLabel);
     emitCodeLabel(endLabel);
 
     breakLabels.pop_back();
 }
 
 void CodeGenerator::visit(BreakNode& node) {
-    emitCode("jmp " + breakLabels.back());
+    emitCode(Opcode::Jmp, breakLabels.back());
 }
 
 void CodeGenerator::visit(BlockNode& node) {
@@ -385,239 +788,499 @@ void CodeGenerator::visit(ParameterNode& node) {
 }
 
 void CodeGenerator::visit(FunctionNode& node) {
-    std::vector<std::string> paramTypes(node.parameters.size());
-    for (size_t i = 0; i < node.parameters.size(); i++) {
-        paramTypes[i] = dynamic_cast<ParameterNode*>(node.parameters[i].get())->type;
+    FunctionData funcData = describeFunction(node);
+
+    // Functions are declared before use, so only a function that calls itself can be re-entered.
+    // Other functions keep their locals in static storage, where they can be instruction
+    // operands.
+    if (callsFunction(node.body, node.name)) {
+        collectLocals(node.body, funcData);
+        funcData.bodyLabel = getNewLabel();
     }
 
-    std::string mangledLabel = mangleFunctionName(node.name, paramTypes);
+    functions[node.symbol].push_back(funcData);
 
-    FunctionData funcData;
-    funcData.name       = node.name;
-    funcData.label      = mangledLabel;
-    funcData.returnType = node.returnType;
-    funcData.params.resize(node.parameters.size());
+    auto previousFunction  = currentFunction;
+    uint32_t previousDepth = frameDepth;
+    currentFunction        = std::make_shared<FunctionData>(funcData);
+    frameDepth             = 0;
+    section                = &funcSection;
+    size_t begin           = funcSection.size();
 
-    for (size_t i = 0; i < node.parameters.size(); i++) {
-        auto* paramNode    = dynamic_cast<ParameterNode*>(node.parameters[i].get());
-        funcData.params[i] = {paramNode->type, paramNode->name};
+    section->push_back(TextItem::labelAt(funcData.labelId));
 
-        std::string argLabel = "arg_" + mangledLabel + "_" + paramNode->name;
-        emitData(argLabel + ": 0");
-        variables[argLabel] = paramNode->type;
+    if (!funcData.locals.empty()) {
+        auto size = static_cast<uint32_t>(funcData.locals.size());
+        emitCode(Opcode::Adsp, Operand::immediate(-size));
+        frameDepth = size;
+    }
+    if (!funcData.bodyLabel.empty()) {
+        emitCodeLabel(funcData.bodyLabel);
     }
 
-    functions[node.name].push_back(funcData);
-
-    auto previousFunction = currentFunction;
-    currentFunction       = std::make_shared<FunctionData>(funcData);
-
-    emitCodeLabel(mangledLabel);
+    auto* body    = dynamic_cast<BlockNode*>(node.body);
+    ASTNode* last = body != nullptr && !body->children.empty()
+                        ? body->children[body->children.size() - 1]
+                        : nullptr;
 
-    emitCode("pop");
-    emitCode("st temp_ret_addr");
+    if (node.returnType == TypeId::Void && isTailCall(last)) {
+        for (size_t i = 0; i + 1 < body->children.size(); i++) {
+            body->children[i]->accept(*this);
+        }
+        emitTailCall(*dynamic_cast<FunctionCallNode*>(last));
+    } else {
+        node.body->accept(*this);
 
-    for (int i = (int)currentFunction->params.size() - 1; i >= 0; i--) {
-        const auto& param    = currentFunction->params[i];
-        std::string argLabel = "arg_" + currentFunction->label + "_" + param.second;
-        emitCode("pop");
-        emitCode("st " + argLabel);
+        // A void function may end without a return statement.
+        if (last == nullptr || last->nodeType != ASTNodeType::Return) {
+            emitEpilogue();
+        }
     }
 
-    node.body->accept(*this);
-
-    emitCode("");
-
-    // TODO: return is a must
     currentFunction = previousFunction;
+    frameDepth      = previousDepth;
+    section         = currentFunction ? &funcSection : &codeSection;
+
+    // Functions are declared before use, so a function small enough to inline is expanded at
+    // every call site and its own code is never reached.
+    auto size = std::count_if(funcSection.begin() + static_cast<long>(begin), funcSection.end(),
+                              [](const TextItem& item) {
+                                  return item.kind == TextItem::Kind::Instruction;
+                              });
+    if (funcData.bodyLabel.empty() && body != nullptr && static_cast<size_t>(size) <= inlineLimit) {
+        funcSection.resize(begin);
+        makeInlineable(node);
+    }
+}
+
+void CodeGenerator::makeInlineable(FunctionNode& node) {
+    FunctionData& function = functions[node.symbol].back();
+    function.inlineBody    = &node;
+    for (const auto& [type, name] : function.params) {
+        emitData(argumentLabel(function, name), {Operand::immediate(0)});
+        variables[argumentLabel(function, name)] = type;
+    }
 }
 
 void CodeGenerator::visit(FunctionCallNode& node) {
-    if (reservedFunctions.count(node.name) != 0U) {
+    if (reservedFunctions.count(node.symbol) != 0U) {
         processReservedFunctionCall(node);
+    } else if (const FunctionData* callee = inlineCandidate(node)) {
+        emitInlineCall(node, *callee);
     } else {
         processRegularFunctionCall(node);
     }
 }
 
 void CodeGenerator::visit(ReturnNode& node) {
+    if (currentFunction && !currentFunction->returnLabel.empty()) {
+        if (node.returnValue != nullptr) {
+            node.returnValue->accept(*this);
+        }
+        emitCode(Opcode::Jmp, currentFunction->returnLabel);
+        currentFunction->returnJumped = true;
+        return;
+    }
+
+    if (isTailCall(node.returnValue)) {
+        emitTailCall(*dynamic_cast<FunctionCallNode*>(node.returnValue));
+        return;
+    }
+
     if (node.returnValue != nullptr) {
         node.returnValue->accept(*this);
     }
 
-    emitCode("st temp_right");
-    emitCode("ld temp_ret_addr");
-    emitCode("push");
-    emitCode("ld temp_right");
-    emitCode("ret");
+    emitEpilogue();
+}
+
+// Drops the frame down to the return address, keeping the result in the accumulator.
+void CodeGenerator::emitEpilogue() {
+    if (frameDepth != 0) {
+        emitCode(Opcode::Adsp, Operand::immediate(frameDepth));
+    }
+    emitCode(Opcode::Ret);
+}
+
+bool CodeGenerator::isTailCall(ASTNode* node) {
+    if (!currentFunction || node == nullptr || node->nodeType != ASTNodeType::FunctionCall) {
+        return false;
+    }
+
+    auto* call = dynamic_cast<FunctionCallNode*>(node);
+    return reservedFunctions.count(call->symbol) == 0 &&
+           call->parameters.size() <= currentFunction->params.size() &&
+           inlineCandidate(*call) == nullptr;
+}
+
+// Argument i replaces the parameter count - i slots above the return address. An argument goes
+// straight to its slot unless a later argument still reads the parameter held there; those wait
+// on the stack and are popped into place once every argument is evaluated.
+void CodeGenerator::emitTailCall(FunctionCallNode& node) {
+    const FunctionData* callee = findFunction(node);
+
+    const auto& params = currentFunction->params;
+    size_t count       = node.parameters.size();
+    size_t shift       = params.size() - count;
+    auto slot          = [&](size_t i) { return frameDepth + 1 + count - i; };
+
+    std::vector<size_t> deferred;
+    for (size_t i = 0; i < count; i++) {
+        ASTNode* argument          = node.parameters[i];
+        const std::string& current = params[shift + i].second;
+
+        auto* identifier = dynamic_cast<IdentifierNode*>(argument);
+        if (identifier != nullptr && identifier->name == current && shift == 0) {
+            continue;
+        }
+
+        argument->accept(*this);
+        auto readsCurrent = [&](ASTNode* later) { return readsVariable(later, current); };
+        if (std::any_of(node.parameters.begin() + i + 1, node.parameters.end(), readsCurrent)) {
+            emitCode(Opcode::Push);
+            deferred.push_back(i);
+        } else {
+            emitCode(Opcode::Sts, Operand::immediate(slot(i)));
+        }
+    }
+    for (auto it = deferred.rbegin(); it != deferred.rend(); ++it) {
+        emitCode(Opcode::Pop);
+        emitCode(Opcode::Sts, Operand::immediate(slot(*it)));
+    }
+
+    // A call to this function becomes a loop that keeps the frame's locals reserved.
+    if (callee->labelId == currentFunction->labelId) {
+        emitCode(Opcode::Jmp, currentFunction->bodyLabel);
+        return;
+    }
+    if (frameDepth != 0) {
+        emitCode(Opcode::Adsp, Operand::immediate(frameDepth));
+    }
+    emitCode(Opcode::Jmp, Operand::label(callee->labelId));
+}
+
+const CodeGenerator::FunctionData* CodeGenerator::inlineCandidate(FunctionCallNode& node) {
+    const FunctionData* callee = findFunction(node);
+    return callee != nullptr && callee->inlineBody != nullptr ? callee : nullptr;
+}
+
+std::string CodeGenerator::argumentLabel(const FunctionData& function, const std::string& name) {
+    return "arg_" + function.label + "_" + name;
+}
+
+// The cells are shared by every expansion of the callee, so an argument waits on the stack while
+// a later argument still makes a call: that call may expand the same callee.
+void CodeGenerator::emitInlineCall(FunctionCallNode& node, const FunctionData& callee) {
+    std::vector<size_t> deferred;
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+        node.parameters[i]->accept(*this);
+
+        auto makesCall = [](ASTNode* later) { return callsFunction(later, ""); };
+        if (std::any_of(node.parameters.begin() + static_cast<long>(i) + 1, node.parameters.end(),
+                        makesCall)) {
+            emitCode(Opcode::Push);
+            deferred.push_back(i);
+        } else {
+            emitCode(Opcode::St, argumentLabel(callee, callee.params[i].second));
+        }
+    }
+    for (auto it = deferred.rbegin(); it != deferred.rend(); ++it) {
+        emitCode(Opcode::Pop);
+        emitCode(Opcode::St, argumentLabel(callee, callee.params[*it].second));
+    }
+
+    auto expansion         = std::make_shared<FunctionData>(callee);
+    expansion->returnLabel = getNewLabel();
+
+    auto previousFunction = currentFunction;
+    currentFunction       = expansion;
+
+    // A return that ends the body falls through to the code after the call.
+    const NodeList& body = dynamic_cast<BlockNode*>(callee.inlineBody->body)->children;
+    for (size_t i = 0; i < body.size(); i++) {
+        auto* returnNode = dynamic_cast<ReturnNode*>(body[i]);
+        if (i + 1 == body.size() && returnNode != nullptr) {
+            if (returnNode->returnValue != nullptr) {
+                returnNode->returnValue->accept(*this);
+            }
+        } else {
+            body[i]->accept(*this);
+        }
+    }
+
+    currentFunction = previousFunction;
+    if (expansion->returnJumped) {
+        emitCodeLabel(expansion->returnLabel);
+    }
+}
+
+// Multiplying by 2^k is a left shift for either signedness; div and rem are unsigned on this
+// machine, so dividing by 2^k is a logical right shift and the remainder is the low k bits.
+bool CodeGenerator::emitStrengthReduced(BinaryOpNode& node) {
+    ASTNode* value                   = node.left;
+    std::optional<uint32_t> exponent = powerOfTwoExponent(node.right);
+    if (!exponent && node.op == Operator::Mul) {
+        value    = node.right;
+        exponent = powerOfTwoExponent(node.left);
+    }
+    if (!exponent) {
+        return false;
+    }
+
+    switch (node.op) {
+        case Operator::Mul:
+            value->accept(*this);
+            emitCode(Opcode::Shl, program.constant(*exponent));
+            return true;
+        case Operator::Div:
+            value->accept(*this);
+            emitCode(Opcode::Shr, program.constant(*exponent));
+            return true;
+        case Operator::Rem:
+            value->accept(*this);
+            emitCode(Opcode::And, program.constant((1u << *exponent) - 1));
+            return true;
+        default:
+            return false;
+    }
 }
 
-void CodeGenerator::visitWithLabels(ASTNode* node, const std::string& trueL,
-                                    const std::string& falseL) {
-    std::string oldTrue  = currentTrueLabel;
-    std::string oldFalse = currentFalseLabel;
+void CodeGenerator::emitOperation(Opcode opcode, ASTNode* left, ASTNode* right, bool commutative) {
+    if (std::optional<Operand> operand = memoryOperand(right)) {
+        left->accept(*this);
+        emitCode(opcode, *operand);
+        return;
+    }
+
+    // Reading the left side after the right one is only safe when the right side cannot write it.
+    std::optional<Operand> operand = memoryOperand(left);
+    if (operand && !hasSideEffects(right)) {
+        right->accept(*this);
+        if (commutative) {
+            emitCode(opcode, *operand);
+        } else {
+            emitCode(Opcode::St, "temp_right");
+            emitCode(Opcode::Ld, *operand);
+            emitCode(opcode, "temp_right");
+        }
+        return;
+    }
+
+    // A frame variable on the left is as cheap to load last.
+    if (left->nodeType == ASTNodeType::Identifier &&
+        frameSlot(dynamic_cast<IdentifierNode*>(left)->name) && !hasSideEffects(right)) {
+        right->accept(*this);
+        emitCode(Opcode::St, "temp_right");
+        left->accept(*this);
+        emitCode(opcode, "temp_right");
+        return;
+    }
+
+    left->accept(*this);
+    emitCode(Opcode::Push);
+    right->accept(*this);
+    emitCode(Opcode::St, "temp_right");
+    emitCode(Opcode::Pop);
+    emitCode(opcode, "temp_right");
+}
 
-    currentTrueLabel  = trueL;
-    currentFalseLabel = falseL;
+std::optional<Operand> CodeGenerator::memoryOperand(ASTNode* node) {
+    switch (node->nodeType) {
+        case ASTNodeType::Identifier: {
+            std::string_view name = dynamic_cast<IdentifierNode*>(node)->name;
+            if (frameSlot(name)) {
+                return std::nullopt;
+            }
+            return Operand::label(program.label(getVarLabel(name)));
+        }
+        case ASTNodeType::NumberLiteral:
+            return program.constant(
+                static_cast<uint32_t>(dynamic_cast<NumberLiteralNode*>(node)->number));
+        case ASTNodeType::CharLiteral: {
+            // The same word ldi would load for it.
+            int value = dynamic_cast<CharLiteralNode*>(node)->value;
+            return program.constant(static_cast<uint32_t>(value) & FULL_MASK_24);
+        }
+        case ASTNodeType::BooleanLiteral:
+            return program.constant(dynamic_cast<BooleanLiteralNode*>(node)->value ? 1 : 0);
+        default:
+            return std::nullopt;
+    }
+}
 
-    node->accept(*this);
+// The labels are taken by value: callers pass the current ones, possibly swapped.
+void CodeGenerator::visitWithLabels(ASTNode* node, std::string trueL, std::string falseL,
+                                    std::string nextL) {
+    std::string oldTrue  = std::move(currentTrueLabel);
+    std::string oldFalse = std::move(currentFalseLabel);
+    std::string oldNext  = std::move(currentNextLabel);
+
+    if (node->nodeType == ASTNodeType::BooleanLiteral) {
+        const std::string& target = dynamic_cast<BooleanLiteralNode*>(node)->value ? trueL : falseL;
+        if (target != nextL) {
+            emitCode(Opcode::Jmp, target);
+        }
+    } else if (branchesOnCondition(node)) {
+        currentTrueLabel  = std::move(trueL);
+        currentFalseLabel = std::move(falseL);
+        currentNextLabel  = std::move(nextL);
+        node->accept(*this);
+    } else {
+        currentTrueLabel.clear();
+        currentFalseLabel.clear();
+        currentNextLabel.clear();
+        node->accept(*this);
+        emitBranch(Opcode::Jnz, trueL, falseL, nextL);
+    }
 
-    currentTrueLabel  = oldTrue;
-    currentFalseLabel = oldFalse;
+    currentTrueLabel  = std::move(oldTrue);
+    currentFalseLabel = std::move(oldFalse);
+    currentNextLabel  = std::move(oldNext);
+}
+
+void CodeGenerator::emitBranch(Opcode jump, const std::string& trueL, const std::string& falseL,
+                               const std::string& nextL) {
+    if (nextL == trueL) {
+        emitCode(invertedJump(jump), falseL);
+        return;
+    }
+    emitCode(jump, trueL);
+    if (nextL != falseL) {
+        emitCode(Opcode::Jmp, falseL);
+    }
 }
 
 void CodeGenerator::processReservedFunctionCall(FunctionCallNode& node) {
-    std::vector<std::string> argTypes(node.parameters.size());
+    std::vector<TypeId> argTypes(node.parameters.size());
     for (size_t i = 0; i < node.parameters.size(); i++) {
-        argTypes[i] = dynamic_cast<ExpressionNode*>(node.parameters[i].get())->resolvedType;
+        argTypes[i] = dynamic_cast<ExpressionNode*>(node.parameters[i])->resolvedType;
     }
-    std::string expectedReturnType = evalType(&node);
+    TypeId expectedReturnType = evalType(&node);
 
     const FunctionSignature* signature =
-        findReservedFunction(node.name, argTypes, expectedReturnType);
+        findReservedFunction(node.symbol, argTypes, expectedReturnType);
     if (signature == nullptr) {
         throw std::logic_error("reserved function signature mismatch");
     }
 
-    if (node.name == "in") {
+    if (node.symbol == SYMBOL_IN) {
         if (signature->paramTypes.empty()) {
-            emitCode("ldi 0");
+            emitCode(Opcode::Ldi, Operand::immediate(0));
         } else {
             node.parameters[0]->accept(*this);
         }
-        emitCode("st input_count");
-
-        const std::string returnType = node.resolvedType;
-
-        if (returnType == "int" || returnType == "uint") {
-            emitCode("call read_int");
-        } else if (returnType == "char") {
-            emitCode("call read_char");
-        } else if (returnType == "string") {
-            emitCode("call read_string");
-        } else if (returnType == "int[]") {
-            emitCode("call read_arr");
+        emitCode(Opcode::St, "input_count");
+
+        TypeId returnType = node.resolvedType;
+
+        if (returnType == TypeId::Int || returnType == TypeId::Uint) {
+            emitCode(Opcode::Call, "read_int");
+        } else if (returnType == TypeId::Char) {
+            emitCode(Opcode::Call, "read_char");
+        } else if (returnType == TypeId::String) {
+            emitCode(Opcode::Call, "read_string");
+        } else if (returnType == TypeId::IntArray) {
+            emitCode(Opcode::Call, "read_arr");
         }
 
-    } else if (node.name == "out") {
-        auto* arg                      = node.parameters[0].get();
-        const std::string& typeToPrint = dynamic_cast<ExpressionNode*>(arg)->resolvedType;
+    } else if (node.symbol == SYMBOL_OUT) {
+        auto* arg          = node.parameters[0];
+        TypeId typeToPrint = dynamic_cast<ExpressionNode*>(arg)->resolvedType;
         arg->accept(*this);
 
-        if (typeToPrint == "int") {
-            emitCode("call write_int");
-        } else if (typeToPrint == "uint") {
-            emitCode("call write_uint");
-        } else if (typeToPrint == "char") {
-            emitCode("call write_char");
-        } else if (typeToPrint == "string") {
-            emitCode("call write_string");
-        } else if (typeToPrint == "int[]") {
-            emitCode("call write_arr");
+        if (typeToPrint == TypeId::Int) {
+            emitCode(Opcode::Call, "write_int");
+        } else if (typeToPrint == TypeId::Uint) {
+            emitCode(Opcode::Call, "write_uint");
+        } else if (typeToPrint == TypeId::Char) {
+            emitCode(Opcode::Call, "write_char");
+        } else if (typeToPrint == TypeId::String) {
+            emitCode(Opcode::Call, "write_string");
+        } else if (typeToPrint == TypeId::IntArray) {
+            emitCode(Opcode::Call, "write_arr");
         }
     }
 }
 
 void CodeGenerator::processRegularFunctionCall(FunctionCallNode& node) {
-    std::vector<std::string> argTypes(node.parameters.size());
-    for (size_t i = 0; i < node.parameters.size(); i++) {
-        argTypes[i] = dynamic_cast<ExpressionNode*>(node.parameters[i].get())->resolvedType;
-    }
-    std::string mangledLabelToCall = mangleFunctionName(node.name, argTypes);
-
-    if (currentFunction) {
-        emitCode("ld temp_ret_addr");
-        emitCode("push");
-
-        for (const auto& param : currentFunction->params) {
-            std::string argLabel = "arg_" + currentFunction->label + "_" + param.second;
-            emitCode("ld " + argLabel);
-            emitCode("push");
-        }
-    }
+    const FunctionData* callee = findFunction(node);
 
+    // The caller's own frame stays where it is; only the arguments are pushed and dropped.
     for (const auto& argExpr : node.parameters) {
         argExpr->accept(*this);
-        emitCode("push");
+        emitCode(Opcode::Push);
     }
 
-    emitCode("call " + mangledLabelToCall);
-
-    if (currentFunction) {
-        emitCode("st temp_right");
-
-        for (int i = (int)currentFunction->params.size() - 1; i >= 0; i--) {
-            const auto& param    = currentFunction->params[i];
-            std::string argLabel = "arg_" + currentFunction->label + "_" + param.second;
-            emitCode("pop");
-            emitCode("st " + argLabel);
-        }
+    emitCode(Opcode::Call, Operand::label(callee->labelId));
 
-        emitCode("pop");
-        emitCode("st temp_ret_addr");
-
-        emitCode("ld temp_right");
+    if (!node.parameters.empty()) {
+        auto count = static_cast<uint32_t>(node.parameters.size());
+        emitCode(Opcode::Adsp, Operand::immediate(count));
+        frameDepth -= count;
     }
 }
 
-std::string CodeGenerator::evalType(ASTNode* node) {
+TypeId CodeGenerator::evalType(ASTNode* node) {
     switch (node->nodeType) {
-        case ASTNodeType::NumberLiteral:
-            return "int";
+        case ASTNodeType::NumberLiteral: {
+            TypeId type = dynamic_cast<NumberLiteralNode*>(node)->resolvedType;
+            return type != TypeId::None ? type : TypeId::Int;
+        }
         case ASTNodeType::CharLiteral:
-            return "char";
+            return TypeId::Char;
         case ASTNodeType::StringLiteral:
-            return "string";
+            return TypeId::String;
         case ASTNodeType::BooleanLiteral:
-            return "bool";
+            return TypeId::Bool;
         case ASTNodeType::VoidLiteral:
-            return "void";
+            return TypeId::Void;
         case ASTNodeType::IntArrayLiteral:
-            return "int[]";
+            return TypeId::IntArray;
         case ASTNodeType::ArrayGet:
-            return "int";
+            return TypeId::Int;
         case ASTNodeType::Identifier: {
             auto* identifierNode = dynamic_cast<IdentifierNode*>(node);
+            if (std::optional<FrameSlot> slot = frameSlot(identifierNode->name)) {
+                return slot->type;
+            }
             return variables[getVarLabel(identifierNode->name)];
         }
         case ASTNodeType::BinaryOp: {
             auto* binaryOpNode = dynamic_cast<BinaryOpNode*>(node);
-            std::string opr    = binaryOpNode->op;
-            if (opr == "+" || opr == "-" || opr == "*" || opr == "/" || opr == "%") {
-                return "int";
+            Operator opr       = binaryOpNode->op;
+            if (isArithmetic(opr)) {
+                return TypeId::Int;
             }
-            if (opr == "==" || opr == "!=" || opr == ">" || opr == ">=" || opr == "<" ||
-                opr == "<=" || opr == "&&" || opr == "||") {
-                return "bool";
+            if (isComparison(opr) || opr == Operator::And || opr == Operator::Or) {
+                return TypeId::Bool;
             }
-            throw std::runtime_error("Unknown op " + opr);
+            throw std::runtime_error("Unknown op " + std::string(operatorName(opr)));
         }
         case ASTNodeType::UnaryOp: {
             auto* unaryOpNode = dynamic_cast<UnaryOpNode*>(node);
-            std::string opr   = unaryOpNode->op;
-            if (opr == "!") {
-                return "bool";
+            Operator opr      = unaryOpNode->op;
+            if (opr == Operator::Not) {
+                return TypeId::Bool;
             }
-            if (opr == "-") {
-                return "int";
+            if (opr == Operator::Sub) {
+                return TypeId::Int;
             }
-            throw std::runtime_error("Unknown op " + opr);
+            throw std::runtime_error("Unknown op " + std::string(operatorName(opr)));
         }
         case ASTNodeType::FunctionCall: {
             auto* functionCallNode = dynamic_cast<FunctionCallNode*>(node);
 
-            std::vector<std::string> paramTypes(functionCallNode->parameters.size());
+            std::vector<TypeId> paramTypes(functionCallNode->parameters.size());
             for (size_t i = 0; i < functionCallNode->parameters.size(); i++) {
-                paramTypes[i] = evalType(functionCallNode->parameters[i].get());
+                paramTypes[i] = evalType(functionCallNode->parameters[i]);
             }
 
-            if (reservedFunctions.count(functionCallNode->name) != 0U) {
-                const FunctionSignature* funcSig =
-                    findReservedFunction(functionCallNode->name, paramTypes, "");
-                return funcSig->returnType;
+            SymbolId symbol = functionCallNode->symbol;
+            if (reservedFunctions.count(symbol) != 0U) {
+                return findReservedFunction(symbol, paramTypes, TypeId::None)->returnType;
             }
 
-            FunctionData* funcData = findFunction(functionCallNode->name, paramTypes);
+            FunctionData* funcData = findFunction(symbol, paramTypes);
             return funcData->returnType;
         }
         case ASTNodeType::MethodCall: {
@@ -630,9 +1293,29 @@ std::string CodeGenerator::evalType(ASTNode* node) {
     }
 }
 
-CodeGenerator::FunctionData* CodeGenerator::findFunction(const std::string& name,
-                                                         std::vector<std::string> paramTypes) {
-    for (auto& funcData : functions[name]) {
+CodeGenerator::FunctionData CodeGenerator::describeFunction(FunctionNode& node) {
+    std::vector<TypeId> paramTypes(node.parameters.size());
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+        paramTypes[i] = dynamic_cast<ParameterNode*>(node.parameters[i])->type;
+    }
+
+    FunctionData funcData;
+    funcData.name       = node.name;
+    funcData.label      = mangleFunctionName(node.name, paramTypes);
+    funcData.labelId    = program.label(funcData.label);
+    funcData.returnType = node.returnType;
+    funcData.params.resize(node.parameters.size());
+
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+        auto* paramNode    = dynamic_cast<ParameterNode*>(node.parameters[i]);
+        funcData.params[i] = {paramNode->type, std::string(paramNode->name)};
+    }
+    return funcData;
+}
+
+CodeGenerator::FunctionData* CodeGenerator::findFunction(SymbolId symbol,
+                                                         const std::vector<TypeId>& paramTypes) {
+    for (auto& funcData : functions[symbol]) {
         bool match = true;
 
         if (funcData.params.size() != paramTypes.size()) {
@@ -653,19 +1336,27 @@ CodeGenerator::FunctionData* CodeGenerator::findFunction(const std::string& name
     return nullptr;
 }
 
+CodeGenerator::FunctionData* CodeGenerator::findFunction(FunctionCallNode& node) {
+    std::vector<TypeId> argTypes(node.parameters.size());
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+        argTypes[i] = dynamic_cast<ExpressionNode*>(node.parameters[i])->resolvedType;
+    }
+    return findFunction(node.symbol, argTypes);
+}
+
 const CodeGenerator::FunctionSignature* CodeGenerator::findReservedFunction(
-    const std::string& name, const std::vector<std::string>& paramTypes,
-    const std::string& expectedReturnType) {
-    if (reservedFunctions.find(name) == reservedFunctions.end()) {
+    SymbolId symbol, const std::vector<TypeId>& paramTypes, TypeId expectedReturnType) {
+    auto reserved = reservedFunctions.find(symbol);
+    if (reserved == reservedFunctions.end()) {
         return nullptr;
     }
 
-    for (const auto& sig : reservedFunctions.at(name)) {
+    for (const auto& sig : reserved->second) {
         if (sig.paramTypes != paramTypes) {
             continue;
         }
 
-        if (expectedReturnType.empty() || sig.returnType == expectedReturnType) {
+        if (expectedReturnType == TypeId::None || sig.returnType == expectedReturnType) {
             return &sig;
         }
     }
@@ -677,95 +1368,241 @@ std::string CodeGenerator::getNewLabel() {
     return "L" + std::to_string(labelCounter++);
 }
 
-std::string CodeGenerator::mangleFunctionName(const std::string& name,
-                                              const std::vector<std::string>& paramTypes) {
-    std::string mangledName = "func_" + name;
-    for (const auto& type : paramTypes) {
+std::string CodeGenerator::mangleFunctionName(std::string_view name,
+                                              const std::vector<TypeId>& paramTypes) {
+    std::string mangledName = "func_" + std::string(name);
+    for (TypeId type : paramTypes) {
         mangledName += "_";
-        if (type == "int") {
-            mangledName += "i";
-        } else if (type == "string") {
-            mangledName += "s";
-        } else if (type == "bool") {
-            mangledName += "b";
-        } else if (type == "int[]") {
-            mangledName += "ai";
-        }
+        mangledName += typeInfo(type).mangled;
     }
     return mangledName;
 }
 
-void CodeGenerator::emitCode(const std::string& line) {
-    if (currentFunction) {
-        funcSection.push_back("  " + line);
-    } else {
-        codeSection.push_back("  " + line);
+void CodeGenerator::emitCode(Opcode opcode, Operand operand) {
+    if (opcode == Opcode::Push) {
+        frameDepth++;
+    } else if (opcode == Opcode::Pop) {
+        frameDepth--;
     }
+
+    section->push_back(TextItem::instruction(opcode, operand));
+}
+
+void CodeGenerator::emitCode(Opcode opcode, const std::string& label) {
+    emitCode(opcode, Operand::label(program.label(label)));
 }
 
 void CodeGenerator::emitCodeLabel(const std::string& label) {
-    if (currentFunction) {
-        funcSection.push_back(label + ":");
-    } else {
-        codeSection.push_back(label + ":");
-    }
+    section->push_back(TextItem::labelAt(program.label(label)));
 }
 
-void CodeGenerator::emitData(const std::string& line) {
-    dataSection.push_back("  " + line);
+void CodeGenerator::emitData(const std::string& label, std::vector<Operand> words) {
+    program.data.push_back({program.label(label), std::move(words)});
 }
 
-std::string CodeGenerator::getVarLabel(const std::string& varName) {
+// Static storage: globals, locals of functions that keep them out of the frame, and arguments of
+// an inlined body.
+std::string CodeGenerator::getVarLabel(std::string_view name) {
+    std::string varName(name);
+
+    if (currentFunction && !currentFunction->returnLabel.empty()) {
+        const auto& params = currentFunction->params;
+        auto named         = [&varName](const auto& param) { return param.second == varName; };
+        if (std::any_of(params.begin(), params.end(), named)) {
+            return argumentLabel(*currentFunction, varName);
+        }
+    }
+    // A global declared after the function does not hide its locals at later inlined call sites.
     if (currentFunction) {
-        auto& funcData = functions[currentFunction->name];
-        bool isArg     = std::any_of(currentFunction->params.begin(), currentFunction->params.end(),
-                                     [&varName](const auto& param) { return param.second == varName; });
+        std::string local = "var_" + currentFunction->label + "_" + varName;
+        if (variables.count(local) != 0 || variables.count("var_" + varName) == 0) {
+            return local;
+        }
+    }
+
+    return "var_" + varName;
+}
+
+std::optional<CodeGenerator::FrameSlot> CodeGenerator::frameSlot(std::string_view name) const {
+    // An inlined body runs in its caller's frame and keeps its arguments in static cells.
+    if (!currentFunction || !currentFunction->returnLabel.empty()) {
+        return std::nullopt;
+    }
 
-        if (isArg) {
-            return "arg_" + currentFunction->label + "_" + varName;
+    const auto& params = currentFunction->params;
+    for (size_t i = 0; i < params.size(); i++) {
+        if (params[i].second == name) {
+            return FrameSlot{params[i].first,
+                             frameDepth + 1 + static_cast<uint32_t>(params.size() - i)};
         }
+    }
 
-        if (variables.find("var_" + varName) != variables.end()) {
-            return "var_" + varName;
+    const auto& locals = currentFunction->locals;
+    for (size_t i = 0; i < locals.size(); i++) {
+        if (locals[i].second == name) {
+            return FrameSlot{locals[i].first,
+                             frameDepth - static_cast<uint32_t>(locals.size() - i) + 1};
         }
+    }
+
+    return std::nullopt;
+}
 
-        return "var_" + currentFunction->label + "_" + varName;
+// Every variable declared in the body gets a slot, unless the name is a parameter or an already
+// declared global, which the body then refers to instead.
+void CodeGenerator::collectLocals(ASTNode* node, FunctionData& function) {
+    if (node == nullptr) {
+        return;
     }
 
-    return "var_" + varName;
+    switch (node->nodeType) {
+        case ASTNodeType::Block:
+            for (ASTNode* child : dynamic_cast<BlockNode*>(node)->children) {
+                collectLocals(child, function);
+            }
+            break;
+        case ASTNodeType::If: {
+            auto* ifNode = dynamic_cast<IfNode*>(node);
+            collectLocals(ifNode->thenBranch, function);
+            collectLocals(ifNode->elseBranch, function);
+            break;
+        }
+        case ASTNodeType::While:
+            collectLocals(dynamic_cast<WhileNode*>(node)->body, function);
+            break;
+        case ASTNodeType::VarDecl: {
+            auto* varDecl = dynamic_cast<VarDeclNode*>(node);
+            std::string name(varDecl->name);
+
+            auto named = [&name](const auto& variable) { return variable.second == name; };
+            if (variables.count("var_" + name) != 0 ||
+                std::any_of(function.params.begin(), function.params.end(), named) ||
+                std::any_of(function.locals.begin(), function.locals.end(), named)) {
+                break;
+            }
+            function.locals.emplace_back(varDecl->type, std::move(name));
+            break;
+        }
+        default:
+            break;
+    }
 }
 
-std::string CodeGenerator::assembleCode() {
-    std::stringstream result;
+void CodeGenerator::loadRuntime() {
+    const std::array<const std::string*, 11> routines = {
+        &interrupts, &read_char, &read_int,   &write_to_buf, &read_string, &read_arr,
+        &write_char, &write_int, &write_uint, &write_string, &write_arr,
+    };
 
-    result << data << "\n";
+    parseAssembly(data + "\n.text\n.org 0x20\n", program);
 
-    for (const auto& line : dataSection) {
-        result << line << "\n";
+    runtimeRanges.clear();
+    for (const std::string* routine : routines) {
+        size_t begin = program.text.size();
+        parseAssembly(".text\n" + *routine, program);
+        runtimeRanges.emplace_back(begin, program.text.size());
     }
+}
 
-    result << "\n.text\n";
-    result << ".org 0x20\n";
-    result << interrupts;
-    result << read_char;
-    result << read_int;
-    result << write_to_buf;
-    result << read_string;
-    result << read_arr;
-    result << write_char;
-    result << write_int;
-    result << write_uint;
-    result << write_string;
-    result << write_arr;
-    result << arr_size;
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void CodeGenerator::linkRuntime() {
+    constexpr size_t NONE = SIZE_MAX;
+
+    // Routine that defines each label; a reference to any of its labels links the routine.
+    std::vector<size_t> owner(program.labelCount(), NONE);
+    for (size_t routine = 0; routine < runtimeRanges.size(); routine++) {
+        auto [begin, end] = runtimeRanges[routine];
+        for (size_t i = begin; i < end; i++) {
+            if (program.text[i].kind == TextItem::Kind::Label) {
+                owner[program.text[i].operand.value] = routine;
+            }
+        }
+    }
+
+    // The interrupt handlers are always linked: the vector table at the start of data points at
+    // them.
+    std::vector<bool> linked(runtimeRanges.size(), false);
+    std::vector<size_t> pending = {0};
+    linked[0]                   = true;
+
+    auto reference = [&](const Operand& operand) {
+        if (operand.kind != Operand::Kind::Label || owner[operand.value] == NONE ||
+            linked[owner[operand.value]]) {
+            return;
+        }
+        linked[owner[operand.value]] = true;
+        pending.push_back(owner[operand.value]);
+    };
 
-    for (const auto& line : funcSection) {
-        result << line << "\n";
+    size_t generatedBegin = runtimeRanges.back().second;
+    for (size_t i = generatedBegin; i < program.text.size(); i++) {
+        reference(program.text[i].operand);
+    }
+    for (const DataItem& item : program.data) {
+        for (const Operand& word : item.words) {
+            reference(word);
+        }
+    }
+    while (!pending.empty()) {
+        auto [begin, end] = runtimeRanges[pending.back()];
+        pending.pop_back();
+        for (size_t i = begin; i < end; i++) {
+            reference(program.text[i].operand);
+        }
     }
 
-    for (const auto& line : codeSection) {
-        result << line << "\n";
+    std::vector<TextItem> text;
+    text.reserve(program.text.size());
+    for (size_t routine = 0; routine < runtimeRanges.size(); routine++) {
+        if (linked[routine]) {
+            auto [begin, end] = runtimeRanges[routine];
+            text.insert(text.end(), program.text.begin() + static_cast<long>(begin),
+                        program.text.begin() + static_cast<long>(end));
+        }
+    }
+    text.insert(text.end(), program.text.begin() + static_cast<long>(generatedBegin),
+                program.text.end());
+    program.text.swap(text);
+
+    // Data is kept when linked code or kept data refers to it. A label with no words marks the
+    // item after it, which is kept along with it.
+    std::vector<bool> used(program.labelCount(), false);
+    used[program.label("default_vector")] = true;
+    used[program.label("input_vector")]   = true;
+    for (const TextItem& item : program.text) {
+        if (item.operand.kind == Operand::Kind::Label) {
+            used[item.operand.value] = true;
+        }
     }
 
-    return result.str();
-}
\ No newline at end of file
+    auto isKept = [&](size_t i) { return used[program.data[i].label]; };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < program.data.size(); i++) {
+            if (!isKept(i)) {
+                continue;
+            }
+            for (const Operand& word : program.data[i].words) {
+                if (word.kind == Operand::Kind::Label && !used[word.value]) {
+                    used[word.value] = true;
+                    changed          = true;
+                }
+            }
+            if (program.data[i].words.empty() && i + 1 < program.data.size() &&
+                !used[program.data[i + 1].label]) {
+                used[program.data[i + 1].label] = true;
+                changed                         = true;
+            }
+        }
+    }
+
+    std::vector<DataItem> data;
+    for (size_t i = 0; i < program.data.size(); i++) {
+        if (isKept(i)) {
+            data.push_back(std::move(program.data[i]));
+        }
+    }
+    program.data.swap(data);
+}
@@ -2,23 +2,38 @@
 #define _CODE_GENERATOR_H
 
 #include <algorithm>
+#include <array>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
 
 #include "ASTNode.hpp"
 #include "ASTVisitor.hpp"
+#include "asmIR.h"
+#include "peephole.h"
 #include "semanticAnalyzer.h"
+#include "ssaPasses.h"
 
 constexpr uint32_t FULL_MASK    = 0xFFFFFFFF;
 constexpr uint32_t FULL_MASK_24 = 0xFFFFFF;
 
 class CodeGenerator : ASTVisitor {
 public:
-    CodeGenerator() = default;
-
-    std::string generateCode(ASTNode* root);
+    // Generated code goes through the peephole optimizer when one is given. Functions of at most
+    // inlineLimit instructions are expanded at their call sites; 0 turns inlining off.
+    //
+    // Given SSA passes, the main program and every function that does not call itself are built
+    // in SSA form, optimized by the passes, printed to ssaDump if there is one, and lowered from
+    // there; functions that call themselves keep the direct translation. Small functions are then
+    // inlined in SSA form, measured by the code they lower to.
+    explicit CodeGenerator(PeepholeOptimizer* peephole = nullptr, size_t inlineLimit = 0,
+                           SsaPassManager* ssaPasses = nullptr, std::ostream* ssaDump = nullptr)
+        : peephole(peephole), inlineLimit(inlineLimit), ssaPasses(ssaPasses), ssaDump(ssaDump) {
+    }
+
+    AsmProgram generateCode(ASTNode* root);
 
     void visit(VarDeclNode& node) override;
     void visit(NumberLiteralNode& node) override;
@@ -43,76 +58,147 @@ public:
     void visit(ReturnNode& node) override;
 
 private:
-    void visitWithLabels(ASTNode* node, const std::string& trueL, const std::string& falseL);
-    std::string evalType(ASTNode* node);
+    // Lowers a boolean to jumps to trueL or falseL; nextL is the label placed right after the
+    // emitted code, which is reached by falling through instead of a jump.
+    void visitWithLabels(ASTNode* node, std::string trueL, std::string falseL, std::string nextL);
+    void emitBranch(Opcode jump, const std::string& trueL, const std::string& falseL,
+                    const std::string& nextL);
+
+    // Leaves `left opcode right` in the accumulator. A side that is already in memory becomes the
+    // instruction's operand; only when neither is does the left side wait on the stack.
+    void emitOperation(Opcode opcode, ASTNode* left, ASTNode* right, bool commutative);
+    bool emitStrengthReduced(BinaryOpNode& node);
+    // Memory word holding the node's value: a global, or a pooled constant for a literal.
+    std::optional<Operand> memoryOperand(ASTNode* node);
+    bool isIndexable(ArrayGetNode& node);
+    Operand emitIndexBase(ArrayGetNode& node);
+    void emitElementAddress(ArrayGetNode& node);
+    TypeId evalType(ASTNode* node);
 
     struct FunctionSignature {
-        std::string returnType;
-        std::vector<std::string> paramTypes;
+        TypeId returnType;
+        std::vector<TypeId> paramTypes;
 
         bool operator==(const FunctionSignature& other) const {
             return returnType == other.returnType && paramTypes == other.paramTypes;
         }
     };
 
+    // Frame of a call, from the top of the stack down: expression temporaries, locals (only for
+    // functions that call themselves), the return address, then the arguments with the last one
+    // nearest.
     struct FunctionData {
         std::string name;
         std::string label;
-        std::string returnType;
-        std::vector<std::pair<std::string, std::string>> params;
+        LabelId labelId;  // of label, interned once for every call to use
+        TypeId returnType;
+        std::vector<std::pair<TypeId, std::string>> params;
+        std::vector<std::pair<TypeId, std::string>> locals;
+        std::string bodyLabel;  // past the prologue; self tail calls loop back to it
+
+        // Set for a function small enough to inline; its arguments then have static cells too.
+        FunctionNode* inlineBody = nullptr;
+        // Set while the body is expanded at a call site: returns jump here instead of ret.
+        std::string returnLabel;
+        bool returnJumped = false;
 
         bool operator==(const FunctionData& other) const {
             return returnType == other.returnType && params == other.params;
         }
     };
 
-    FunctionData* findFunction(const std::string& name, std::vector<std::string> paramTypes);
-    const FunctionSignature* findReservedFunction(const std::string& name,
-                                                  const std::vector<std::string>& paramTypes,
-                                                  const std::string& expectedReturnType);
+    // Signature and label of the function, before anything is known about its body.
+    FunctionData describeFunction(FunctionNode& node);
+    static std::string mangleFunctionName(std::string_view name,
+                                          const std::vector<TypeId>& paramTypes);
+    FunctionData* findFunction(SymbolId symbol, const std::vector<TypeId>& paramTypes);
+    // The overload a checked call resolves to.
+    FunctionData* findFunction(FunctionCallNode& node);
+    const FunctionSignature* findReservedFunction(SymbolId symbol,
+                                                  const std::vector<TypeId>& paramTypes,
+                                                  TypeId expectedReturnType);
 
     void processReservedFunctionCall(FunctionCallNode& node);
     void processRegularFunctionCall(FunctionCallNode& node);
 
+    struct FrameSlot {
+        TypeId type;
+        uint32_t offset;  // from SP as it stands at the instruction being emitted
+    };
+
+    // Parameter or local of the current function, addressed with lds/sts.
+    [[nodiscard]] std::optional<FrameSlot> frameSlot(std::string_view name) const;
+    void collectLocals(ASTNode* node, FunctionData& function);
+    void emitEpilogue();
+
+    // A call whose result the current function returns, or that ends a void function, reuses
+    // the current return address: its arguments replace the current ones and it is entered with
+    // jmp. The callee must not take more arguments than the current function has slots for.
+    [[nodiscard]] bool isTailCall(ASTNode* node);
+    void emitTailCall(FunctionCallNode& node);
+
+    // Binds the arguments to the callee's static argument cells and emits its body in place.
+    void emitInlineCall(FunctionCallNode& node, const FunctionData& callee);
+    const FunctionData* inlineCandidate(FunctionCallNode& node);
+    static std::string argumentLabel(const FunctionData& function, const std::string& name);
+
+    // Gives the function static argument cells and expands it at its call sites from then on.
+    void makeInlineable(FunctionNode& node);
+
+    void generateSsa(BlockNode& root);
+    // Inlines, optimizes and dumps the function, then lowers it to out.
+    void generateSsaFunction(SsaFunction function, std::vector<TextItem>& out);
+    // Gives every variable the statement declares, at any depth, a var_ cell.
+    void declareGlobals(ASTNode* node);
+
     std::vector<std::string> breakLabels;
 
-    std::vector<std::string> dataSection;
-    std::vector<std::string> codeSection;
-    std::vector<std::string> funcSection;
-    std::unordered_map<std::string, std::string> variables;
+    PeepholeOptimizer* peephole;
+    size_t inlineLimit;
+    SsaPassManager* ssaPasses;
+    std::ostream* ssaDump;
+
+    AsmProgram program;
+    std::vector<TextItem> codeSection;
+    std::vector<TextItem> funcSection;
+    // Section being emitted to: function bodies, or the main program.
+    std::vector<TextItem>* section = &codeSection;
+    std::unordered_map<std::string, TypeId> variables;
     std::unordered_map<std::string, int> functionLabels;
+    // Optimized SSA form of the functions small enough to inline, by label.
+    std::unordered_map<std::string, SsaFunction> ssaBodies;
 
-    std::unordered_map<std::string, std::vector<FunctionData>> functions;
+    std::unordered_map<SymbolId, std::vector<FunctionData>> functions;
 
     // clang-format off
-    const std::unordered_map<std::string, std::vector<FunctionSignature>> reservedFunctions = {
-        {"in", {
-            {"int", {"int"}},
-            {"int", {}},
-            {"uint", {"int"}},
-            {"uint", {}},
-            {"char", {}},
-            {"string", {"int"}},
-            {"string", {}},
-            {"int[]", {"int"}},
-            {"int[]", {}}
+    const std::unordered_map<SymbolId, std::vector<FunctionSignature>> reservedFunctions = {
+        {SYMBOL_IN, {
+            {TypeId::Int, {TypeId::Int}},
+            {TypeId::Int, {}},
+            {TypeId::Uint, {TypeId::Int}},
+            {TypeId::Uint, {}},
+            {TypeId::Char, {}},
+            {TypeId::String, {TypeId::Int}},
+            {TypeId::String, {}},
+            {TypeId::IntArray, {TypeId::Int}},
+            {TypeId::IntArray, {}}
         }},
-        {"out", {
-            {"void", {"int"}},
-            {"void", {"uint"}},
-            {"void", {"char"}},
-            {"void", {"int[]"}},
-            {"void", {"string"}}
+        {SYMBOL_OUT, {
+            {TypeId::Void, {TypeId::Int}},
+            {TypeId::Void, {TypeId::Uint}},
+            {TypeId::Void, {TypeId::Char}},
+            {TypeId::Void, {TypeId::IntArray}},
+            {TypeId::Void, {TypeId::String}}
         }}
     };
 
-    const std::unordered_map<std::string, std::unordered_map<std::string, FunctionSignature>> typeMethods = {
-        {"int[]", {
-            {"size", {"int", {}}}
+    const std::unordered_map<TypeId, std::unordered_map<SymbolId, FunctionSignature>> typeMethods = {
+        {TypeId::IntArray, {
+            {SYMBOL_SIZE, {TypeId::Int, {}}}
         }},
 
-        {"string", {
-            {"size", {"int", {}}}
+        {TypeId::String, {
+            {SYMBOL_SIZE, {TypeId::Int, {}}}
         }}
     };
     // clang-format on
@@ -123,26 +209,26 @@ private:
     int bufferCounter = 0;
 
     std::shared_ptr<FunctionData> currentFunction;
+    // Words below the current function's return address; push and pop keep it up to date.
+    uint32_t frameDepth = 0;
 
     std::string currentTrueLabel;
     std::string currentFalseLabel;
+    std::string currentNextLabel;
 
-    static std::string mangleFunctionName(const std::string& name,
-                                          const std::vector<std::string>& paramTypes);
-
-    void emitCode(const std::string& line);
+    void emitCode(Opcode opcode, Operand operand = {});
+    void emitCode(Opcode opcode, const std::string& label);
     void emitCodeLabel(const std::string& label);
-    void emitData(const std::string& line);
+    void emitData(const std::string& label, std::vector<Operand> words);
 
     std::string getNewLabel();
-    std::string getVarLabel(const std::string& varName);
+    std::string getVarLabel(std::string_view name);
 
     const std::string data =
         ".data\n"
         "  default_vector: default_interrupt\n"
         "  input_vector: input_interrupt\n\n"
         "  temp_right: 0\n"
-        "  temp_ret_addr: 0\n"
         "  input_addr: 0x10\n"
         "  output_addr: 0x11\n\n"
         "  const_eot: 4\n"
@@ -249,6 +335,7 @@ private:
         "  ldi input_buffer\n"
         "  add input_buffer_i\n"
         "  st input_ptr\n"
+        "  call write_to_buf\n"
         "read_string_do:\n"
         "  ld input_buffer_i\n"
         "  cmp input_buffer_size\n"
@@ -265,6 +352,7 @@ private:
         "  ldi input_buffer\n"
         "  add input_buffer_i\n"
         "  sub input_ptr\n"
+        "  dec\n"
         "  sub input_count\n"
         "  jz read_string_ret\n\n"
         "  jmp read_string_do\n"
@@ -273,16 +361,21 @@ private:
         "read_string_ret:\n"
         "  ldi 0\n"
         "  st token\n"
-        "  st input_count\n"
-        "  call write_to_buf\n\n"
-        "  ld input_ptr\n\n"
+        "  st input_count\n\n"
+        "  ldi input_buffer\n"
+        "  add input_buffer_i\n"
+        "  sub input_ptr\n"
+        "  dec\n"
+        "  sta input_ptr\n\n"
+        "  ld input_ptr\n"
         "  ret\n\n";
 
     const std::string read_arr =
         "read_arr:\n"
         "  ldi input_buffer\n"
         "  add input_buffer_i\n"
-        "  st input_ptr\n\n"
+        "  st input_ptr\n"
+        "  call write_to_buf\n\n"
         "  ldi 0\n"
         "  st read_arr_stop\n"
         "read_arr_do:\n"
@@ -296,6 +389,7 @@ private:
         "  ldi input_buffer\n"
         "  add input_buffer_i\n"
         "  sub input_ptr\n"
+        "  dec\n"
         "  sub input_count\n"
         "  jz read_arr_ret\n\n"
         "  jmp read_arr_do\n"
@@ -303,9 +397,13 @@ private:
         "  halt\n"
         "read_arr_ret:\n"
         "  ldi 0\n"
-        "  st input_count\n"
-        "  call write_to_buf\n\n"
-        "  ld input_ptr\n\n"
+        "  st input_count\n\n"
+        "  ldi input_buffer\n"
+        "  add input_buffer_i\n"
+        "  sub input_ptr\n"
+        "  dec\n"
+        "  sta input_ptr\n\n"
+        "  ld input_ptr\n"
         "  ret\n\n";
 
     const std::string write_char =
@@ -395,67 +493,54 @@ private:
     const std::string write_string =
         "write_string:\n"
         "  st input_ptr\n"
-        "  ldi 0\n"
+        "  lda input_ptr\n"
+        "  jz write_string_ret\n"
         "  st write_i\n"
         "write_string_do:\n"
         "  ld input_ptr\n"
-        "  add write_i\n"
-        "  st temp_right\n"
-        "  lda temp_right\n\n"
-        "  jz write_string_ret\n"
+        "  inc\n"
+        "  st input_ptr\n"
+        "  lda input_ptr\n"
         "  sta output_addr\n\n"
         "  ld write_i\n"
-        "  inc\n"
-        "  st write_i\n\n"
-        "  jmp write_string_do\n"
+        "  dec\n"
+        "  st write_i\n"
+        "  jnz write_string_do\n"
         "write_string_ret:\n"
         "  ret\n\n";
 
     const std::string write_arr =
         "write_arr:\n"
-        "  st input_ptr\n\n"
+        "  st input_ptr\n"
         "  lda input_ptr\n"
         "  jz write_arr_ret\n"
-        "  call write_int\n\n"
-        "  ldi 1\n"
         "  st write_i\n"
+        "  jmp write_arr_element\n"
         "write_arr_do:\n"
-        "  ld input_ptr\n"
-        "  add write_i\n"
-        "  st temp_right\n"
-        "  lda temp_right\n"
-        "  jz write_arr_ret\n\n"
         "  ld const_space\n"
-        "  sta output_addr\n\n"
-        "  lda temp_right\n"
+        "  sta output_addr\n"
+        "write_arr_element:\n"
+        "  ld input_ptr\n"
+        "  inc\n"
+        "  st input_ptr\n"
+        "  lda input_ptr\n"
         "  call write_int\n\n"
         "  ld write_i\n"
-        "  inc\n"
-        "  st write_i\n\n"
-        "  jmp write_arr_do\n"
+        "  dec\n"
+        "  st write_i\n"
+        "  jnz write_arr_do\n"
         "write_arr_ret:\n"
         "  ret\n\n";
 
-    const std::string arr_size =
-        "arr_size:\n"
-        "  st input_ptr\n\n"
-        "  ldi 0\n"
-        "  st write_i\n"
-        "arr_size_do:\n"
-        "  ld input_ptr\n"
-        "  add write_i\n"
-        "  st temp_right\n"
-        "  lda temp_right\n"
-        "  jz arr_size_ret\n\n"
-        "  ld write_i\n"
-        "  inc\n"
-        "  st write_i\n\n"
-        "  jmp arr_size_do\n"
-        "arr_size_ret:\n"
-        "  ld write_i\n"
-        "  ret\n\n";
+    // Parses the runtime data and every routine into the program first, recording where each
+    // routine's text lies.
+    void loadRuntime();
+    // Keeps only the routines the generated code reaches, directly or through other routines,
+    // and the data that the kept code refers to.
+    void linkRuntime();
 
-    std::string assembleCode();
+    // [begin, end) of each runtime routine in program.text; interrupts come first.
+    std::vector<std::pair<size_t, size_t>> runtimeRanges;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "constantFolder.h"
+
+#include <optional>
+
+namespace {
+
+// Per-name facts gathered over the whole tree. Storage is named after the variable, not its
+// scope, so a name is only safe to propagate when nothing else in the program uses it.
+struct NameUse {
+    size_t declarations = 0;
+    bool assigned       = false;
+    bool parameter      = false;
+    TypeId type         = TypeId::None;
+};
+
+class UsageScanner : public ASTVisitor {
+public:
+    explicit UsageScanner(std::vector<NameUse>& uses) : uses(uses) {
+    }
+
+    void visit(VarDeclNode& node) override {
+        uses[node.symbol].declarations++;
+        uses[node.symbol].type = node.type;
+        node.value->accept(*this);
+    }
+    void visit([[maybe_unused]] NumberLiteralNode& node) override {
+    }
+    void visit([[maybe_unused]] CharLiteralNode& node) override {
+    }
+    void visit([[maybe_unused]] StringLiteralNode& node) override {
+    }
+    void visit([[maybe_unused]] BooleanLiteralNode& node) override {
+    }
+    void visit([[maybe_unused]] VoidLiteralNode& node) override {
+    }
+    void visit(IntArrayLiteralNode& node) override {
+        visitAll(node.values);
+    }
+    void visit(ArrayGetNode& node) override {
+        node.object->accept(*this);
+        node.index->accept(*this);
+    }
+    void visit(MethodCallNode& node) override {
+        node.object->accept(*this);
+        visitAll(node.arguments);
+    }
+    void visit([[maybe_unused]] IdentifierNode& node) override {
+    }
+    void visit(AssignNode& node) override {
+        if (node.var1->nodeType == ASTNodeType::Identifier) {
+            uses[dynamic_cast<IdentifierNode*>(node.var1)->symbol].assigned = true;
+        }
+        node.var1->accept(*this);
+        node.var2->accept(*this);
+    }
+    void visit(BinaryOpNode& node) override {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+    void visit(UnaryOpNode& node) override {
+        node.operand->accept(*this);
+    }
+    void visit(IfNode& node) override {
+        node.condition->accept(*this);
+        node.thenBranch->accept(*this);
+        if (node.elseBranch != nullptr) {
+            node.elseBranch->accept(*this);
+        }
+    }
+    void visit(WhileNode& node) override {
+        node.condition->accept(*this);
+        node.body->accept(*this);
+    }
+    void visit([[maybe_unused]] BreakNode& node) override {
+    }
+    void visit(BlockNode& node) override {
+        visitAll(node.children);
+    }
+    void visit(ParameterNode& node) override {
+        uses[node.symbol].parameter = true;
+    }
+    void visit(FunctionNode& node) override {
+        visitAll(node.parameters);
+        node.body->accept(*this);
+    }
+    void visit(FunctionCallNode& node) override {
+        visitAll(node.parameters);
+    }
+    void visit(ReturnNode& node) override {
+        if (node.returnValue != nullptr) {
+            node.returnValue->accept(*this);
+        }
+    }
+
+private:
+    void visitAll(const NodeList& list) {
+        for (ASTNode* child : list) {
+            child->accept(*this);
+        }
+    }
+
+    std::vector<NameUse>& uses;
+};
+
+bool isScalar(TypeId type) {
+    return type == TypeId::Int || type == TypeId::Uint || type == TypeId::Char ||
+           type == TypeId::Bool;
+}
+
+// Result bits of a binary operator as the generated code would compute them; nullopt when the
+// operator is not folded (division by zero is left to the machine).
+std::optional<uint32_t> evaluate(Operator opr, uint32_t left, uint32_t right, bool isUnsigned) {
+    auto less = [&](uint32_t lhs, uint32_t rhs) {
+        return isUnsigned ? lhs < rhs : static_cast<int32_t>(lhs) < static_cast<int32_t>(rhs);
+    };
+
+    switch (opr) {
+        case Operator::Add:
+            return left + right;
+        case Operator::Sub:
+            return left - right;
+        case Operator::Mul:
+            return left * right;
+        case Operator::Div:
+            return right != 0 ? std::optional<uint32_t>(left / right) : std::nullopt;
+        case Operator::Rem:
+            return right != 0 ? std::optional<uint32_t>(left % right) : std::nullopt;
+        case Operator::ShiftLeft:
+            return right < 32 ? left << right : 0;
+        case Operator::ShiftRight:
+            return right < 32 ? left >> right : 0;
+        case Operator::BitAnd:
+            return left & right;
+        case Operator::BitOr:
+            return left | right;
+        case Operator::BitXor:
+            return left ^ right;
+        case Operator::Equal:
+            return left == right;
+        case Operator::NotEqual:
+            return left != right;
+        case Operator::Greater:
+            return less(right, left);
+        case Operator::GreaterEqual:
+            return !less(left, right);
+        case Operator::Less:
+            return less(left, right);
+        case Operator::LessEqual:
+            return !less(right, left);
+        case Operator::And:
+            return left != 0 && right != 0;
+        case Operator::Or:
+            return left != 0 || right != 0;
+        default:
+            return std::nullopt;
+    }
+}
+
+}  // namespace
+
+void ConstantFolder::optimize(AST& ast) {
+    arena = &ast.arena;
+
+    std::vector<NameUse> uses(ast.symbols.size());
+    UsageScanner scanner(uses);
+    ast.root->accept(scanner);
+
+    constants.assign(uses.size(), nullptr);
+    propagatable.assign(uses.size(), false);
+    for (size_t symbol = 0; symbol < uses.size(); symbol++) {
+        const NameUse& use   = uses[symbol];
+        propagatable[symbol] = use.declarations == 1 && !use.assigned && !use.parameter &&
+                               isScalar(use.type);
+    }
+
+    fold(ast.root);
+}
+
+ASTNode* ConstantFolder::fold(ASTNode* node) {
+    replacement = node;
+    node->accept(*this);
+    return replacement;
+}
+
+// Statement slots that cannot be empty get an empty block instead of nullptr.
+ASTNode* ConstantFolder::foldStatement(ASTNode* node) {
+    ASTNode* folded = fold(node);
+    return folded != nullptr ? folded : arena->make<BlockNode>(NodeList{});
+}
+
+void ConstantFolder::foldList(NodeList& list) {
+    size_t kept = 0;
+    for (ASTNode* child : list) {
+        if (ASTNode* folded = fold(child)) {
+            list[kept++] = folded;
+        }
+    }
+    list = NodeList(list.begin(), kept);
+}
+
+bool ConstantFolder::asConstant(ASTNode* node, Constant& constant) {
+    switch (node->nodeType) {
+        case ASTNodeType::NumberLiteral: {
+            auto* number = dynamic_cast<NumberLiteralNode*>(node);
+            TypeId type  = number->resolvedType == TypeId::Uint ? TypeId::Uint : TypeId::Int;
+            constant     = {type, static_cast<uint32_t>(number->number)};
+            return true;
+        }
+        case ASTNodeType::CharLiteral:
+            constant = {TypeId::Char,
+                        static_cast<unsigned char>(dynamic_cast<CharLiteralNode*>(node)->value)};
+            return true;
+        case ASTNodeType::BooleanLiteral:
+            constant = {TypeId::Bool,
+                        static_cast<uint32_t>(dynamic_cast<BooleanLiteralNode*>(node)->value)};
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Evaluating the node has no effect besides producing its value.
+bool ConstantFolder::isPure(ASTNode* node) {
+    switch (node->nodeType) {
+        case ASTNodeType::NumberLiteral:
+        case ASTNodeType::CharLiteral:
+        case ASTNodeType::StringLiteral:
+        case ASTNodeType::BooleanLiteral:
+        case ASTNodeType::Identifier:
+            return true;
+        case ASTNodeType::ArrayGet: {
+            auto* arrayGet = dynamic_cast<ArrayGetNode*>(node);
+            return isPure(arrayGet->object) && isPure(arrayGet->index);
+        }
+        case ASTNodeType::BinaryOp: {
+            auto* binaryOp = dynamic_cast<BinaryOpNode*>(node);
+            return isPure(binaryOp->left) && isPure(binaryOp->right);
+        }
+        case ASTNodeType::UnaryOp:
+            return isPure(dynamic_cast<UnaryOpNode*>(node)->operand);
+        default:
+            return false;
+    }
+}
+
+ExpressionNode* ConstantFolder::makeLiteral(Constant constant) {
+    ExpressionNode* literal = nullptr;
+    switch (constant.type) {
+        case TypeId::Int:
+            literal = arena->make<NumberLiteralNode>(static_cast<int32_t>(constant.bits));
+            break;
+        case TypeId::Uint:
+            literal = arena->make<NumberLiteralNode>(static_cast<long>(constant.bits));
+            break;
+        case TypeId::Char:
+            literal = arena->make<CharLiteralNode>(static_cast<char>(constant.bits));
+            break;
+        default:
+            literal = arena->make<BooleanLiteralNode>(constant.bits != 0);
+            break;
+    }
+    literal->resolvedType = constant.type;
+    return literal;
+}
+
+void ConstantFolder::visit(VarDeclNode& node) {
+    node.value = fold(node.value);
+
+    Constant constant{};
+    if (propagatable[node.symbol] && asConstant(node.value, constant)) {
+        constants[node.symbol] = node.value;
+        replacement            = nullptr;
+    } else {
+        replacement = &node;
+    }
+}
+
+void ConstantFolder::visit([[maybe_unused]] NumberLiteralNode& node) {
+}
+
+void ConstantFolder::visit([[maybe_unused]] CharLiteralNode& node) {
+}
+
+void ConstantFolder::visit([[maybe_unused]] StringLiteralNode& node) {
+}
+
+void ConstantFolder::visit([[maybe_unused]] BooleanLiteralNode& node) {
+}
+
+void ConstantFolder::visit([[maybe_unused]] VoidLiteralNode& node) {
+}
+
+void ConstantFolder::visit(IntArrayLiteralNode& node) {
+    foldList(node.values);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(ArrayGetNode& node) {
+    node.object = fold(node.object);
+    node.index  = fold(node.index);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(MethodCallNode& node) {
+    foldList(node.arguments);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(IdentifierNode& node) {
+    if (constants[node.symbol] != nullptr) {
+        replacement = constants[node.symbol];
+    }
+}
+
+void ConstantFolder::visit(AssignNode& node) {
+    if (node.var1->nodeType == ASTNodeType::ArrayGet) {
+        node.var1 = fold(node.var1);
+    }
+    node.var2   = fold(node.var2);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(BinaryOpNode& node) {
+    node.left   = fold(node.left);
+    node.right  = fold(node.right);
+    replacement = &node;
+
+    Constant left{};
+    Constant right{};
+    bool leftConstant  = asConstant(node.left, left);
+    bool rightConstant = asConstant(node.right, right);
+
+    if (leftConstant && rightConstant) {
+        bool isUnsigned = left.type == TypeId::Uint || right.type == TypeId::Uint;
+        if (std::optional<uint32_t> bits = evaluate(node.op, left.bits, right.bits, isUnsigned)) {
+            replacement = makeLiteral({node.resolvedType, *bits});
+        }
+        return;
+    }
+
+    // One known side of && / ||: drop it when it cannot decide the result, or take the result
+    // when it does and the other side has nothing to run.
+    if (node.op != Operator::And && node.op != Operator::Or) {
+        return;
+    }
+    bool decisive = node.op == Operator::Or;
+    if (leftConstant) {
+        if ((left.bits != 0) != decisive) {
+            replacement = node.right;
+        } else if (isPure(node.right)) {
+            replacement = node.left;
+        }
+    } else if (rightConstant) {
+        if ((right.bits != 0) != decisive) {
+            replacement = node.left;
+        } else if (isPure(node.left)) {
+            replacement = node.right;
+        }
+    }
+}
+
+void ConstantFolder::visit(UnaryOpNode& node) {
+    node.operand = fold(node.operand);
+    replacement  = &node;
+
+    Constant operand{};
+    if (!asConstant(node.operand, operand)) {
+        return;
+    }
+    if (node.op == Operator::Sub) {
+        replacement = makeLiteral({node.resolvedType, 0U - operand.bits});
+    } else if (node.op == Operator::Not) {
+        replacement = makeLiteral({TypeId::Bool, operand.bits == 0 ? 1U : 0U});
+    }
+}
+
+void ConstantFolder::visit(IfNode& node) {
+    node.condition = fold(node.condition);
+
+    Constant condition{};
+    if (asConstant(node.condition, condition)) {
+        ASTNode* taken = condition.bits != 0 ? node.thenBranch : node.elseBranch;
+        replacement    = taken != nullptr ? fold(taken) : nullptr;
+        return;
+    }
+
+    node.thenBranch = foldStatement(node.thenBranch);
+    if (node.elseBranch != nullptr) {
+        node.elseBranch = fold(node.elseBranch);
+    }
+    replacement = &node;
+}
+
+void ConstantFolder::visit(WhileNode& node) {
+    node.condition = fold(node.condition);
+
+    Constant condition{};
+    if (asConstant(node.condition, condition) && condition.bits == 0) {
+        replacement = nullptr;
+        return;
+    }
+
+    node.body   = foldStatement(node.body);
+    replacement = &node;
+}
+
+void ConstantFolder::visit([[maybe_unused]] BreakNode& node) {
+}
+
+void ConstantFolder::visit(BlockNode& node) {
+    foldList(node.children);
+    replacement = &node;
+}
+
+void ConstantFolder::visit([[maybe_unused]] ParameterNode& node) {
+}
+
+void ConstantFolder::visit(FunctionNode& node) {
+    node.body   = foldStatement(node.body);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(FunctionCallNode& node) {
+    foldList(node.parameters);
+    replacement = &node;
+}
+
+void ConstantFolder::visit(ReturnNode& node) {
+    if (node.returnValue != nullptr) {
+        node.returnValue = fold(node.returnValue);
+    }
+    replacement = &node;
+}
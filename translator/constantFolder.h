@@ -0,0 +1,67 @@
+#ifndef _CONSTANT_FOLDER_H
+#define _CONSTANT_FOLDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ASTNode.hpp"
+#include "ASTVisitor.hpp"
+
+// Rewrites a checked tree before code generation: operators on literals are evaluated the way the
+// machine would (32-bit wraparound, unsigned div/rem), variables declared once from a constant and
+// never assigned are replaced by that constant, and if/while statements with a constant condition
+// keep only the branch that can run. Replacement nodes come from the tree's arena.
+class ConstantFolder : ASTVisitor {
+public:
+    ConstantFolder() = default;
+
+    void optimize(AST& ast);
+
+    void visit(VarDeclNode& node) override;
+    void visit(NumberLiteralNode& node) override;
+    void visit(CharLiteralNode& node) override;
+    void visit(StringLiteralNode& node) override;
+    void visit(BooleanLiteralNode& node) override;
+    void visit(VoidLiteralNode& node) override;
+    void visit(IntArrayLiteralNode& node) override;
+    void visit(ArrayGetNode& node) override;
+    void visit(MethodCallNode& node) override;
+    void visit(IdentifierNode& node) override;
+    void visit(AssignNode& node) override;
+    void visit(BinaryOpNode& node) override;
+    void visit(UnaryOpNode& node) override;
+    void visit(IfNode& node) override;
+    void visit(WhileNode& node) override;
+    void visit(BreakNode& node) override;
+    void visit(BlockNode& node) override;
+    void visit(ParameterNode& node) override;
+    void visit(FunctionNode& node) override;
+    void visit(FunctionCallNode& node) override;
+    void visit(ReturnNode& node) override;
+
+private:
+    // Literal value as the machine holds it in a word.
+    struct Constant {
+        TypeId type;
+        uint32_t bits;
+    };
+
+    // Returns what should stand in place of node: node itself, a new node, or nullptr for a
+    // statement that can be dropped.
+    ASTNode* fold(ASTNode* node);
+    ASTNode* foldStatement(ASTNode* node);
+    void foldList(NodeList& list);
+
+    static bool asConstant(ASTNode* node, Constant& constant);
+    static bool isPure(ASTNode* node);
+    ExpressionNode* makeLiteral(Constant constant);
+
+    Arena* arena         = nullptr;
+    ASTNode* replacement = nullptr;
+
+    // Indexed by SymbolId: literal to substitute for a propagated variable, or nullptr.
+    std::vector<ASTNode*> constants;
+    std::vector<bool> propagatable;
+};
+
+#endif
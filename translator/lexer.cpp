@@ -0,0 +1,353 @@
+#include "lexer.h"
+
+#include <stdexcept>
+
+namespace {
+
+enum CharClass : uint8_t {
+    CLASS_SPACE = 1U << 0U,
+    CLASS_ALPHA = 1U << 1U,
+    CLASS_DIGIT = 1U << 2U,
+};
+
+constexpr auto makeCharClasses() -> std::array<uint8_t, 256> {
+    std::array<uint8_t, 256> classes{};
+    for (char c : std::string_view(" \t\n\v\f\r")) {
+        classes[static_cast<unsigned char>(c)] = CLASS_SPACE;
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+        classes[c]             = CLASS_ALPHA;
+        classes[c - 'a' + 'A'] = CLASS_ALPHA;
+    }
+    classes['_'] = CLASS_ALPHA;
+    for (int c = '0'; c <= '9'; c++) {
+        classes[c] = CLASS_DIGIT;
+    }
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = makeCharClasses();
+
+constexpr bool hasClass(char character, uint8_t mask) {
+    return (CHAR_CLASSES[static_cast<unsigned char>(character)] & mask) != 0;
+}
+
+struct Keyword {
+    std::string_view word;
+    TokenType type;
+};
+
+// clang-format off
+constexpr std::array<Keyword, 13> KEYWORDS = {{
+    {"if",     TokenType::KeywordIf},
+    {"else",   TokenType::KeywordElse},
+    {"while",  TokenType::KeywordWhile},
+    {"break",  TokenType::KeywordBreak},
+    {"return", TokenType::KeywordReturn},
+    {"void",   TokenType::KeywordVoid},
+    {"int",    TokenType::KeywordInt},
+    {"uint",   TokenType::KeywordUint},
+    {"char",   TokenType::KeywordChar},
+    {"string", TokenType::KeywordString},
+    {"bool",   TokenType::KeywordBool},
+    {"true",   TokenType::Boolean},
+    {"false",  TokenType::Boolean},
+}};
+// clang-format on
+
+constexpr size_t KEYWORD_SLOTS = 16;
+
+// Perfect for the words above: every keyword lands in its own slot, checked below.
+constexpr size_t keywordHash(std::string_view word) {
+    return (word.size() + static_cast<unsigned char>(word.front()) +
+            12U * static_cast<unsigned char>(word.back())) %
+           KEYWORD_SLOTS;
+}
+
+struct KeywordTable {
+    std::array<Keyword, KEYWORD_SLOTS> slots{};
+    bool perfect = true;
+};
+
+constexpr auto makeKeywordTable() -> KeywordTable {
+    KeywordTable table;
+    for (auto& slot : table.slots) {
+        slot = {"", TokenType::Identifier};
+    }
+    for (const auto& keyword : KEYWORDS) {
+        auto& slot = table.slots[keywordHash(keyword.word)];
+        if (!slot.word.empty()) {
+            table.perfect = false;
+        }
+        slot = keyword;
+    }
+    return table;
+}
+
+constexpr KeywordTable KEYWORD_TABLE = makeKeywordTable();
+static_assert(KEYWORD_TABLE.perfect, "keywordHash collides, pick new multipliers");
+
+}  // namespace
+
+SymbolId Interner::intern(std::string_view name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+
+    auto id = static_cast<SymbolId>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+TokenType Lexer::classifyWord(std::string_view word) {
+    const Keyword& slot = KEYWORD_TABLE.slots[keywordHash(word)];
+    return slot.word == word ? slot.type : TokenType::Identifier;
+}
+
+std::vector<Token> Lexer::tokenize(std::string_view input) {
+    std::vector<Token> tokens;
+    tokens.reserve(input.size() / 4);
+    size_t pos = 0;
+
+    while (pos < input.size()) {
+        char current = input[pos];
+
+        if (hasClass(current, CLASS_SPACE)) {
+            pos++;
+            continue;
+        }
+
+        if (hasClass(current, CLASS_ALPHA)) {
+            size_t start = pos;
+            while (pos < input.size() && hasClass(input[pos], CLASS_ALPHA | CLASS_DIGIT)) {
+                pos++;
+            }
+
+            std::string_view word = input.substr(start, pos - start);
+            TokenType type        = classifyWord(word);
+
+            if (type == TokenType::Identifier) {
+                tokens.emplace_back(type, word, symbols.intern(word));
+                continue;
+            }
+
+            if (type == TokenType::KeywordInt) {
+                size_t tempPos = pos;
+                while (tempPos < input.size() && hasClass(input[tempPos], CLASS_SPACE)) {
+                    tempPos++;
+                }
+
+                if (tempPos < input.size() && input[tempPos] == '[') {
+                    tempPos++;
+                    while (tempPos < input.size() && hasClass(input[tempPos], CLASS_SPACE)) {
+                        tempPos++;
+                    }
+
+                    if (tempPos < input.size() && input[tempPos] == ']') {
+                        pos = tempPos + 1;
+                        tokens.emplace_back(TokenType::KeywordIntArr, "int[]");
+                        continue;
+                    }
+                }
+            }
+
+            tokens.emplace_back(type, word);
+            continue;
+        }
+
+        if (hasClass(current, CLASS_DIGIT)) {
+            size_t start = pos;
+            while (pos < input.size() && hasClass(input[pos], CLASS_DIGIT)) {
+                pos++;
+            }
+            tokens.emplace_back(TokenType::Number, input.substr(start, pos - start));
+            continue;
+        }
+
+        if (current == '"') {
+            pos++;
+            size_t end = input.find('"', pos);
+
+            if (end == std::string_view::npos) {
+                throw std::runtime_error("Expected \"");
+            }
+
+            tokens.emplace_back(TokenType::String, input.substr(pos, end - pos));
+            pos = end + 1;
+            continue;
+        }
+
+        if (current == '\'') {
+            pos++;
+
+            if (pos >= input.size()) {
+                throw std::runtime_error("expected \'");
+            }
+
+            size_t start = pos;
+
+            if (input[pos] == '\\') {
+                pos++;
+
+                if (pos >= input.size()) {
+                    throw std::runtime_error("incomplete char literal");
+                }
+
+                switch (input[pos]) {
+                    case 'n':
+                    case 't':
+                    case '\\':
+                    case '\'':
+                        break;
+                    default:
+                        throw std::runtime_error("unsuppoerted escapte-sequence: " +
+                                                 std::to_string(input[pos]));
+                }
+            }
+            pos++;
+
+            if (pos >= input.size() || input[pos] != '\'') {
+                throw std::runtime_error("expected \'");
+            }
+
+            // The raw literal body is kept; the parser resolves the escape.
+            tokens.emplace_back(TokenType::Char, input.substr(start, pos - start));
+            pos++;
+            continue;
+        }
+
+        char next = pos + 1 < input.size() ? input[pos + 1] : '\0';
+
+        switch (current) {
+            case '=':
+                if (next == '=') {
+                    tokens.emplace_back(TokenType::LogicEqual, "==");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::Equals, "=");
+                    pos++;
+                }
+                break;
+            case ';':
+                tokens.emplace_back(TokenType::Semicolon, ";");
+                pos++;
+                break;
+            case '.':
+                tokens.emplace_back(TokenType::Dot, ".");
+                pos++;
+                break;
+            case ',':
+                tokens.emplace_back(TokenType::Comma, ",");
+                pos++;
+                break;
+            case '(':
+                tokens.emplace_back(TokenType::LParen, "(");
+                pos++;
+                break;
+            case ')':
+                tokens.emplace_back(TokenType::RParen, ")");
+                pos++;
+                break;
+            case '{':
+                tokens.emplace_back(TokenType::LBrace, "{");
+                pos++;
+                break;
+            case '}':
+                tokens.emplace_back(TokenType::RBrace, "}");
+                pos++;
+                break;
+            case '[':
+                tokens.emplace_back(TokenType::LBracket, "[");
+                pos++;
+                break;
+            case ']':
+                tokens.emplace_back(TokenType::RBracket, "]");
+                pos++;
+                break;
+            case '!':
+                if (next == '=') {
+                    tokens.emplace_back(TokenType::LogicNotEqual, "!=");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::LogicNot, "!");
+                    pos++;
+                }
+                break;
+            case '+':
+                tokens.emplace_back(TokenType::Plus, "+");
+                pos++;
+                break;
+            case '-':
+                tokens.emplace_back(TokenType::Minus, "-");
+                pos++;
+                break;
+            case '*':
+                tokens.emplace_back(TokenType::Multiply, "*");
+                pos++;
+                break;
+            case '/':
+                tokens.emplace_back(TokenType::Divide, "/");
+                pos++;
+                break;
+            case '%':
+                tokens.emplace_back(TokenType::Rem, "%");
+                pos++;
+                break;
+            case '&':
+                if (next == '&') {
+                    tokens.emplace_back(TokenType::LogicAnd, "&&");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::BitAnd, "&");
+                    pos++;
+                }
+                break;
+            case '|':
+                if (next == '|') {
+                    tokens.emplace_back(TokenType::LogicOr, "||");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::BitOr, "|");
+                    pos++;
+                }
+                break;
+            case '^':
+                tokens.emplace_back(TokenType::BitXor, "^");
+                pos++;
+                break;
+            case '>':
+                if (next == '=') {
+                    tokens.emplace_back(TokenType::LogicGreaterEqual, ">=");
+                    pos += 2;
+                } else if (next == '>') {
+                    tokens.emplace_back(TokenType::ShiftRight, ">>");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::LogicGreater, ">");
+                    pos++;
+                }
+                break;
+            case '<':
+                if (next == '=') {
+                    tokens.emplace_back(TokenType::LogicLessEqual, "<=");
+                    pos += 2;
+                } else if (next == '<') {
+                    tokens.emplace_back(TokenType::ShiftLeft, "<<");
+                    pos += 2;
+                } else {
+                    tokens.emplace_back(TokenType::LogicLess, "<");
+                    pos++;
+                }
+                break;
+            default:
+                tokens.emplace_back(TokenType::Unknown, input.substr(pos, 1));
+                pos++;
+                break;
+        }
+    }
+
+    tokens.emplace_back(TokenType::EndOfFile, "");
+    return tokens;
+}
@@ -0,0 +1,132 @@
+#ifndef _LEXER_H
+#define _LEXER_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class TokenType : uint8_t {
+    // Keywords
+    KeywordIf,
+    KeywordElse,
+    KeywordWhile,
+    KeywordBreak,
+    KeywordReturn,
+    KeywordVoid,
+
+    // Data types
+    KeywordInt,
+    KeywordUint,
+    KeywordChar,
+    KeywordString,
+    KeywordBool,
+    KeywordIntArr,
+
+    // Utility
+    Identifier,
+    Equals,
+    Number,
+    Char,
+    String,
+    Boolean,
+
+    // Delimeters
+    LParen,
+    RParen,
+    LBrace,
+    RBrace,
+    LBracket,
+    RBracket,
+    Semicolon,
+    Dot,
+    Comma,
+
+    // Logic operators
+    LogicNot,
+    LogicAnd,
+    LogicOr,
+    LogicEqual,
+    LogicNotEqual,
+    LogicGreater,
+    LogicGreaterEqual,
+    LogicLess,
+    LogicLessEqual,
+
+    // Operators
+    Plus,
+    Minus,
+    Multiply,
+    Divide,
+    Rem,
+    ShiftLeft,
+    ShiftRight,
+    BitAnd,
+    BitOr,
+    BitXor,
+
+    // Utility
+    EndOfFile,
+    Unknown
+};
+
+using SymbolId = uint32_t;
+
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Token values are views into the source text, which must outlive the tokens. Identifiers also
+// carry their interned symbol id.
+struct Token {
+    TokenType type;
+    std::string_view value;
+    SymbolId symbol = NO_SYMBOL;
+
+    Token(TokenType type, std::string_view value) : type(type), value(value) {
+    }
+    Token(TokenType type, std::string_view value, SymbolId symbol)
+        : type(type), value(value), symbol(symbol) {
+    }
+};
+
+// Hands out one dense id per distinct identifier. Names are copied, so ids and names stay valid
+// after the source text is gone.
+class Interner {
+public:
+    SymbolId intern(std::string_view name);
+
+    // NO_SYMBOL when the name was never interned.
+    [[nodiscard]] SymbolId find(std::string_view name) const {
+        auto found = ids.find(name);
+        return found == ids.end() ? NO_SYMBOL : found->second;
+    }
+
+    [[nodiscard]] const std::string& name(SymbolId id) const {
+        return names.at(id);
+    }
+    [[nodiscard]] size_t size() const {
+        return names.size();
+    }
+
+private:
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, SymbolId> ids;
+};
+
+class Lexer {
+public:
+    explicit Lexer(Interner& symbols) : symbols(symbols) {
+    }
+
+    std::vector<Token> tokenize(std::string_view input);
+
+    // Keyword, type or boolean literal for the word, Identifier otherwise.
+    static TokenType classifyWord(std::string_view word);
+
+private:
+    Interner& symbols;
+};
+
+#endif
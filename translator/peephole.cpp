@@ -0,0 +1,240 @@
+#include "peephole.h"
+
+#include <array>
+#include <iomanip>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr uint32_t LDI_MASK = 0xFFFFFF;  // ldi loads a 24-bit operand
+
+struct Window {
+    const std::vector<TextItem>& code;
+    AsmProgram& program;
+    LabelId scratch;  // temp_right
+
+    [[nodiscard]] bool is(size_t index, Opcode opcode) const {
+        return index < code.size() && code[index].kind == TextItem::Kind::Instruction &&
+               code[index].opcode == opcode;
+    }
+
+    [[nodiscard]] bool isLoad(size_t index) const {
+        return is(index, Opcode::Ld) || is(index, Opcode::Ldi) || is(index, Opcode::Lds);
+    }
+
+    // The load reads back the word the store writes: ld after st, or lds after sts with no stack
+    // move in between.
+    [[nodiscard]] bool readsBack(size_t store, size_t load) const {
+        return ((is(store, Opcode::St) && is(load, Opcode::Ld)) ||
+                (is(store, Opcode::Sts) && is(load, Opcode::Lds))) &&
+               sameOperand(store, load);
+    }
+
+    [[nodiscard]] bool isScratch(size_t index) const {
+        return code[index].operand.kind == Operand::Kind::Label &&
+               code[index].operand.value == scratch;
+    }
+
+    [[nodiscard]] bool sameOperand(size_t first, size_t second) const {
+        const Operand& lhs = code[first].operand;
+        const Operand& rhs = code[second].operand;
+        return lhs.kind == rhs.kind && lhs.value == rhs.value;
+    }
+
+    // True when the flags are overwritten before anything can read them. Branches, calls and
+    // labels end the search: the flags may be live on the other side.
+    [[nodiscard]] bool flagsDeadAt(size_t index) const {
+        for (; index < code.size(); index++) {
+            const TextItem& item = code[index];
+            if (item.kind == TextItem::Kind::Label || isConditionalJump(item.opcode)) {
+                return false;
+            }
+            if (writesFlags(item.opcode)) {
+                return true;
+            }
+            if (item.opcode == Opcode::Jmp || item.opcode == Opcode::Call ||
+                item.opcode == Opcode::Ret || item.opcode == Opcode::Iret) {
+                return false;
+            }
+        }
+        return false;
+    }
+};
+
+// A rule inspects code[at...]; on a match it appends the replacement to out and returns how many
+// items it consumed, otherwise it returns 0 and leaves out alone.
+using Apply = size_t (*)(const Window& window, size_t at, std::vector<TextItem>& out);
+
+struct Rule {
+    std::string_view name;
+    Apply apply;
+};
+
+// push; pop
+size_t pushPop(const Window& window, size_t at, std::vector<TextItem>& /*out*/) {
+    return window.is(at, Opcode::Push) && window.is(at + 1, Opcode::Pop) ? 2 : 0;
+}
+
+// push; ld x; st temp_right; pop; op temp_right  ->  op x
+// push; ldi k; st temp_right; pop; op temp_right  ->  op const_k
+// temp_right is scratch: codegen and the runtime always store it right before reading it.
+size_t scratchOperand(const Window& window, size_t at, std::vector<TextItem>& out) {
+    constexpr std::array<Opcode, 11> OPERATIONS = {
+        Opcode::Add, Opcode::Sub, Opcode::Mul, Opcode::Div, Opcode::Rem, Opcode::Cmp,
+        Opcode::Shl, Opcode::Shr, Opcode::And, Opcode::Or,  Opcode::Xor};
+
+    bool isImmediate = window.is(at + 1, Opcode::Ldi) &&
+                       window.code[at + 1].operand.kind == Operand::Kind::Immediate;
+    if (!window.is(at, Opcode::Push) || !(window.is(at + 1, Opcode::Ld) || isImmediate) ||
+        !window.is(at + 2, Opcode::St) || !window.is(at + 3, Opcode::Pop) ||
+        window.isScratch(at + 1) || !window.isScratch(at + 2) || at + 4 >= window.code.size() ||
+        !window.isScratch(at + 4)) {
+        return 0;
+    }
+
+    for (Opcode opcode : OPERATIONS) {
+        if (window.is(at + 4, opcode)) {
+            Operand operand = window.code[at + 1].operand;
+            if (isImmediate) {
+                operand = window.program.constant(operand.value & LDI_MASK);
+            }
+            out.push_back(TextItem::instruction(opcode, operand));
+            return 5;
+        }
+    }
+    return 0;
+}
+
+// st x; ld x  ->  st x, when the load's flags are never read (also sts/lds)
+size_t storeLoad(const Window& window, size_t at, std::vector<TextItem>& out) {
+    if (!window.readsBack(at, at + 1) || !window.flagsDeadAt(at + 2)) {
+        return 0;
+    }
+    out.push_back(window.code[at]);
+    return 2;
+}
+
+// ld x; st x  ->  ld x (also lds/sts)
+size_t loadStore(const Window& window, size_t at, std::vector<TextItem>& out) {
+    if (!window.readsBack(at + 1, at)) {
+        return 0;
+    }
+    out.push_back(window.code[at]);
+    return 2;
+}
+
+// st x; st x  ->  st x (also sts)
+size_t storeStore(const Window& window, size_t at, std::vector<TextItem>& out) {
+    bool stores = (window.is(at, Opcode::St) && window.is(at + 1, Opcode::St)) ||
+                  (window.is(at, Opcode::Sts) && window.is(at + 1, Opcode::Sts));
+    if (!stores || !window.sameOperand(at, at + 1)) {
+        return 0;
+    }
+    out.push_back(window.code[at]);
+    return 2;
+}
+
+// ld a; ld b  ->  ld b (any of ld/ldi, then ld/ldi/lda)
+size_t deadLoad(const Window& window, size_t at, std::vector<TextItem>& /*out*/) {
+    return window.isLoad(at) && (window.isLoad(at + 1) || window.is(at + 1, Opcode::Lda)) ? 1 : 0;
+}
+
+// ld a; st x; st y...; ld a  ->  ld a; st x; st y... (stores may also be sts)
+// Stores change neither the accumulator nor the flags and write back the loaded value, so the
+// reload repeats the first load.
+size_t reload(const Window& window, size_t at, std::vector<TextItem>& out) {
+    if (!window.isLoad(at)) {
+        return 0;
+    }
+
+    size_t next = at + 1;
+    while (window.is(next, Opcode::St) || window.is(next, Opcode::Sts)) {
+        next++;
+    }
+    if (next == at + 1 || !window.is(next, window.code[at].opcode) ||
+        !window.sameOperand(at, next)) {
+        return 0;
+    }
+
+    out.insert(out.end(), window.code.begin() + static_cast<long>(at),
+               window.code.begin() + static_cast<long>(next));
+    return next - at + 1;
+}
+
+// jmp l; l:  ->  l:
+size_t jumpToNext(const Window& window, size_t at, std::vector<TextItem>& /*out*/) {
+    if (!window.is(at, Opcode::Jmp) || window.code[at].operand.kind != Operand::Kind::Label) {
+        return 0;
+    }
+    for (size_t next = at + 1;
+         next < window.code.size() && window.code[next].kind == TextItem::Kind::Label; next++) {
+        if (window.code[next].operand.value == window.code[at].operand.value) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// clang-format off
+constexpr std::array<Rule, 8> RULES = {{
+    {"push-pop",        pushPop},
+    {"scratch-operand", scratchOperand},
+    {"store-load",      storeLoad},
+    {"load-store",      loadStore},
+    {"store-store",     storeStore},
+    {"dead-load",       deadLoad},
+    {"reload",          reload},
+    {"jump-to-next",    jumpToNext},
+}};
+// clang-format on
+
+}  // namespace
+
+PeepholeOptimizer::PeepholeOptimizer() : hits(RULES.size(), 0) {
+}
+
+void PeepholeOptimizer::optimize(std::vector<TextItem>& code, AsmProgram& program) {
+    LabelId scratch = program.label("temp_right");
+    size_t before   = code.size();
+
+    std::vector<TextItem> out;
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        out.clear();
+        out.reserve(code.size());
+
+        Window window{code, program, scratch};
+
+        for (size_t at = 0; at < code.size();) {
+            size_t consumed = 0;
+            for (size_t rule = 0; rule < RULES.size() && consumed == 0; rule++) {
+                consumed = RULES[rule].apply(window, at, out);
+                if (consumed != 0) {
+                    hits[rule]++;
+                }
+            }
+
+            if (consumed == 0) {
+                out.push_back(code[at]);
+                consumed = 1;
+            } else {
+                changed = true;
+            }
+            at += consumed;
+        }
+
+        code.swap(out);
+    }
+
+    removedCount += before - code.size();
+}
+
+void PeepholeOptimizer::report(std::ostream& out) const {
+    for (size_t rule = 0; rule < RULES.size(); rule++) {
+        out << "  " << std::left << std::setw(16) << RULES[rule].name << hits[rule] << "\n";
+    }
+    out << "  " << std::left << std::setw(16) << "removed" << removedCount << "\n";
+}
@@ -0,0 +1,28 @@
+#ifndef _PEEPHOLE_H
+#define _PEEPHOLE_H
+
+#include <ostream>
+#include <vector>
+
+#include "asmIR.h"
+
+// Rewrites short instruction sequences of generated code into cheaper equivalents until no rule
+// applies. Windows never span a label, so control can only enter them at the top. Counts how
+// often each rule fired across every optimized stream.
+class PeepholeOptimizer {
+public:
+    PeepholeOptimizer();
+
+    void optimize(std::vector<TextItem>& code, AsmProgram& program);
+
+    [[nodiscard]] size_t removed() const {
+        return removedCount;
+    }
+    void report(std::ostream& out) const;
+
+private:
+    std::vector<size_t> hits;
+    size_t removedCount = 0;
+};
+
+#endif
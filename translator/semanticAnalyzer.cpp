@@ -9,48 +9,49 @@ void SemanticAnalyzer::analyze(ASTNode* node) {
 void SemanticAnalyzer::visit(VarDeclNode& node) {
     this->expectedType = node.type;
     node.value->accept(*this);
-    this->expectedType = "";
+    this->expectedType = TypeId::None;
 
-    std::string varType = this->lastVisitedExpression->resolvedType;
+    TypeId varType = this->lastVisitedExpression->resolvedType;
     if (varType != node.type) {
-        throw std::runtime_error("Type mismatch in variable declaration: " + node.name);
+        throw std::runtime_error("Type mismatch in variable declaration: " +
+                                 std::string(node.name));
     }
-    if (varType == "void") {
+    if (varType == TypeId::Void) {
         throw std::runtime_error("Can't assign void");
     }
-    declareVariable(node.name, varType);
+    declareVariable(node.symbol, varType);
 }
 
 void SemanticAnalyzer::visit(NumberLiteralNode& node) {
-    if (this->expectedType == "uint") {
-        node.resolvedType = "uint";
+    if (this->expectedType == TypeId::Uint) {
+        node.resolvedType = TypeId::Uint;
     } else {
-        node.resolvedType = "int";
+        node.resolvedType = TypeId::Int;
     }
 
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(CharLiteralNode& node) {
-    node.resolvedType = "char";
+    node.resolvedType = TypeId::Char;
 
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(StringLiteralNode& node) {
-    node.resolvedType = "string";
+    node.resolvedType = TypeId::String;
 
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(BooleanLiteralNode& node) {
-    node.resolvedType = "bool";
+    node.resolvedType = TypeId::Bool;
 
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(VoidLiteralNode& node) {
-    node.resolvedType = "void";
+    node.resolvedType = TypeId::Void;
 
     this->lastVisitedExpression = &node;
 }
@@ -58,35 +59,35 @@ void SemanticAnalyzer::visit(VoidLiteralNode& node) {
 void SemanticAnalyzer::visit(IntArrayLiteralNode& node) {
     for (auto& value : node.values) {
         value->accept(*this);
-        if (this->lastVisitedExpression->resolvedType != "int") {
+        if (this->lastVisitedExpression->resolvedType != TypeId::Int) {
             throw std::runtime_error("Int array must contain int values");
         }
     }
 
-    node.resolvedType = "int[]";
+    node.resolvedType = TypeId::IntArray;
 
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(ArrayGetNode& node) {
     node.object->accept(*this);
-    std::string objectType = this->lastVisitedExpression->resolvedType;
+    TypeId objectType = this->lastVisitedExpression->resolvedType;
 
-    if (objectType != "int[]" && objectType != "string") {
+    if (objectType != TypeId::IntArray && objectType != TypeId::String) {
         throw std::runtime_error("subscripted value is not array");
     }
 
     node.index->accept(*this);
-    std::string indexType = this->lastVisitedExpression->resolvedType;
+    TypeId indexType = this->lastVisitedExpression->resolvedType;
 
-    if (indexType != "int") {
+    if (indexType != TypeId::Int) {
         throw std::runtime_error("array subscript is not int");
     }
 
-    if (objectType == "int[]") {
-        node.resolvedType = "int";
-    } else if (objectType == "string") {
-        node.resolvedType = "char";
+    if (objectType == TypeId::IntArray) {
+        node.resolvedType = TypeId::Int;
+    } else if (objectType == TypeId::String) {
+        node.resolvedType = TypeId::Char;
     }
 
     this->lastVisitedExpression = &node;
@@ -94,26 +95,31 @@ void SemanticAnalyzer::visit(ArrayGetNode& node) {
 
 void SemanticAnalyzer::visit(MethodCallNode& node) {
     node.object->accept(*this);
-    std::string objectType = this->lastVisitedExpression->resolvedType;
+    TypeId objectType = this->lastVisitedExpression->resolvedType;
 
-    if (typeMethods.find(objectType) == typeMethods.end()) {
-        throw std::runtime_error("type " + objectType + " has no methods");
+    auto methods = typeMethods.find(objectType);
+    if (methods == typeMethods.end()) {
+        throw std::runtime_error("type " + typeName(objectType) + " has no methods");
     }
 
-    if (typeMethods.at(objectType).find(node.methodName) == typeMethods.at(objectType).end()) {
-        throw std::runtime_error("type " + objectType + " has no method named " + node.methodName);
+    auto method = methods->second.find(node.method);
+    if (method == methods->second.end()) {
+        throw std::runtime_error("type " + typeName(objectType) + " has no method named " +
+                                 std::string(node.methodName));
     }
 
-    const FunctionSignature& expectedSig = typeMethods.at(objectType).at(node.methodName);
+    const FunctionSignature& expectedSig = method->second;
 
     if (node.arguments.size() != expectedSig.paramTypes.size()) {
-        throw std::runtime_error("argument size mismatch for method " + node.methodName);
+        throw std::runtime_error("argument size mismatch for method " +
+                                 std::string(node.methodName));
     }
 
     for (size_t i = 0; i < node.arguments.size(); i++) {
         node.arguments[i]->accept(*this);
         if (this->lastVisitedExpression->resolvedType != expectedSig.paramTypes[i]) {
-            throw std::runtime_error("argument type mismatch for method " + node.methodName);
+            throw std::runtime_error("argument type mismatch for method " +
+                                     std::string(node.methodName));
         }
     }
 
@@ -123,61 +129,59 @@ void SemanticAnalyzer::visit(MethodCallNode& node) {
 }
 
 void SemanticAnalyzer::visit(IdentifierNode& node) {
-    node.resolvedType           = lookupVariable(node.name);
+    node.resolvedType           = lookupVariable(node.symbol, node.name);
     this->lastVisitedExpression = &node;
 }
 
 void SemanticAnalyzer::visit(AssignNode& node) {
     node.var1->accept(*this);
-    std::string var1Type = this->lastVisitedExpression->resolvedType;
+    TypeId var1Type = this->lastVisitedExpression->resolvedType;
 
     this->expectedType = var1Type;
 
     node.var2->accept(*this);
-    std::string var2Type = this->lastVisitedExpression->resolvedType;
+    TypeId var2Type = this->lastVisitedExpression->resolvedType;
 
     if (var1Type != var2Type) {
         throw std::runtime_error("Type mismatch in variable assignment");
     }
 
-    this->expectedType = "";
+    this->expectedType = TypeId::None;
 }
 
 void SemanticAnalyzer::visit(BinaryOpNode& node) {
     node.left->accept(*this);
-    std::string leftType = this->lastVisitedExpression->resolvedType;
+    TypeId leftType = this->lastVisitedExpression->resolvedType;
 
     this->expectedType = leftType;
 
     node.right->accept(*this);
-    std::string rightType = this->lastVisitedExpression->resolvedType;
+    TypeId rightType = this->lastVisitedExpression->resolvedType;
 
-    this->expectedType = "";
+    this->expectedType = TypeId::None;
 
-    if (node.op == "+" || node.op == "-" || node.op == "*" || node.op == "/" || node.op == "%") {
-        if ((leftType == "int" || leftType == "uint") &&
-            (rightType == "int" || rightType == "uint")) {
-            if (leftType == "uint" || rightType == "uint") {
-                node.resolvedType = "uint";
+    if (isArithmetic(node.op)) {
+        if (isNumeric(leftType) && isNumeric(rightType)) {
+            if (leftType == TypeId::Uint || rightType == TypeId::Uint) {
+                node.resolvedType = TypeId::Uint;
             } else {
-                node.resolvedType = "int";
+                node.resolvedType = TypeId::Int;
             }
         } else {
             throw std::runtime_error("Arithmetic operations require int or uint operands");
         }
-    } else if (node.op == "==" || node.op == "!=" || node.op == ">" || node.op == ">=" ||
-               node.op == "<" || node.op == "<=") {
+    } else if (isComparison(node.op)) {
         if (leftType != rightType) {
             throw std::runtime_error("Comparsion between incompatible types");
         }
-        node.resolvedType = "bool";
-    } else if (node.op == "&&" || node.op == "||") {
-        if (leftType != "bool" || rightType != "bool") {
+        node.resolvedType = TypeId::Bool;
+    } else if (node.op == Operator::And || node.op == Operator::Or) {
+        if (leftType != TypeId::Bool || rightType != TypeId::Bool) {
             throw std::runtime_error("Logical operations require bool operands");
         }
-        node.resolvedType = "bool";
+        node.resolvedType = TypeId::Bool;
     } else {
-        throw std::runtime_error("Unknown binary operator: " + node.op);
+        throw std::runtime_error("Unknown binary operator: " + std::string(operatorName(node.op)));
     }
 
     this->lastVisitedExpression = &node;
@@ -185,20 +189,20 @@ void SemanticAnalyzer::visit(BinaryOpNode& node) {
 
 void SemanticAnalyzer::visit(UnaryOpNode& node) {
     node.operand->accept(*this);
-    std::string opType = this->lastVisitedExpression->resolvedType;
+    TypeId opType = this->lastVisitedExpression->resolvedType;
 
-    if (node.op == "!") {
-        if (opType != "bool") {
+    if (node.op == Operator::Not) {
+        if (opType != TypeId::Bool) {
             throw std::runtime_error("Unary '!' requres bool");
         }
-        node.resolvedType = "bool";
-    } else if (node.op == "-") {
-        if (opType != "int") {
+        node.resolvedType = TypeId::Bool;
+    } else if (node.op == Operator::Sub) {
+        if (opType != TypeId::Int) {
             throw std::runtime_error("Unary '-' requires int");
         }
-        node.resolvedType = "int";
+        node.resolvedType = TypeId::Int;
     } else {
-        throw std::runtime_error("Unknown unary operator: " + node.op);
+        throw std::runtime_error("Unknown unary operator: " + std::string(operatorName(node.op)));
     }
 
     this->lastVisitedExpression = &node;
@@ -206,9 +210,9 @@ void SemanticAnalyzer::visit(UnaryOpNode& node) {
 
 void SemanticAnalyzer::visit(IfNode& node) {
     node.condition->accept(*this);
-    std::string condType = this->lastVisitedExpression->resolvedType;
+    TypeId condType = this->lastVisitedExpression->resolvedType;
 
-    if (condType != "bool") {
+    if (condType != TypeId::Bool) {
         throw std::runtime_error("if condition must be boolean");
     }
 
@@ -221,9 +225,9 @@ void SemanticAnalyzer::visit(IfNode& node) {
 
 void SemanticAnalyzer::visit(WhileNode& node) {
     node.condition->accept(*this);
-    std::string condType = this->lastVisitedExpression->resolvedType;
+    TypeId condType = this->lastVisitedExpression->resolvedType;
 
-    if (condType != "bool") {
+    if (condType != TypeId::Bool) {
         throw std::runtime_error("while condition must be boolean");
     }
 
@@ -253,14 +257,14 @@ void SemanticAnalyzer::visit(FunctionNode& node) {
     FunctionSignature sig;
     sig.returnType = node.returnType;
     for (const auto& paramNode : node.parameters) {
-        sig.paramTypes.push_back(dynamic_cast<ParameterNode*>(paramNode.get())->type);
+        sig.paramTypes.emplace_back(dynamic_cast<ParameterNode*>(paramNode)->type);
     }
 
-    if (isReserved(node.name, sig)) {
-        throw std::runtime_error("Function name " + node.name + " is reserved");
+    if (isReserved(node.symbol, sig)) {
+        throw std::runtime_error("Function name " + std::string(node.name) + " is reserved");
     }
 
-    this->functions[node.name].push_back(sig);
+    this->functions[node.symbol].push_back(sig);
     // hasReturn = false;
     // currentReturnType = fn->returnType;
 
@@ -268,27 +272,28 @@ void SemanticAnalyzer::visit(FunctionNode& node) {
     hasReturn         = false;
 
     for (const auto& paramNode : node.parameters) {
-        auto* param = dynamic_cast<ParameterNode*>(paramNode.get());
-        declareVariable(param->name, {param->type});
+        auto* param = dynamic_cast<ParameterNode*>(paramNode);
+        declareVariable(param->symbol, param->type);
     }
 
     node.body->accept(*this);
 
-    if (!hasReturn && currentReturnType != "void") {
-        throw std::runtime_error("non-void function " + node.name + " must have return statement");
+    if (!hasReturn && currentReturnType != TypeId::Void) {
+        throw std::runtime_error("non-void function " + std::string(node.name) +
+                                 " must have return statement");
     }
     hasReturn = false;
 }
 
 void SemanticAnalyzer::visit(FunctionCallNode& node) {
-    std::vector<std::string> actualParamTypes;
+    std::vector<TypeId> actualParamTypes;
     for (const auto& argExpression : node.parameters) {
         argExpression->accept(*this);
-        actualParamTypes.push_back(this->lastVisitedExpression->resolvedType);
+        actualParamTypes.emplace_back(this->lastVisitedExpression->resolvedType);
     }
 
-    std::string returnType = findFunction(node.name, actualParamTypes, this->expectedType);
-    if (returnType.empty()) {
+    TypeId returnType = findFunction(node.symbol, actualParamTypes, this->expectedType);
+    if (returnType == TypeId::None) {
         throw std::runtime_error("no matching function found");
     }
 
@@ -300,9 +305,9 @@ void SemanticAnalyzer::visit(FunctionCallNode& node) {
 void SemanticAnalyzer::visit(ReturnNode& node) {
     this->expectedType = this->currentReturnType;
     node.returnValue->accept(*this);
-    this->expectedType = "";
+    this->expectedType = TypeId::None;
 
-    std::string returnType = this->lastVisitedExpression->resolvedType;
+    TypeId returnType = this->lastVisitedExpression->resolvedType;
     if (returnType != this->currentReturnType) {
         throw std::runtime_error("return type mismatch in function signature");
     }
@@ -310,62 +315,52 @@ void SemanticAnalyzer::visit(ReturnNode& node) {
     this->hasReturn = true;
 }
 
-// NOLINTNEXTLINE(modernize-use-emplace)
 void SemanticAnalyzer::enterScope() {
-    scopes.push_back({});
+    variables.enterScope();
 }
 
 void SemanticAnalyzer::exitScope() {
-    scopes.pop_back();
+    variables.exitScope();
 }
 
-void SemanticAnalyzer::declareVariable(const std::string& name, std::string data) {
-    scopes.back()[name] = std::move(data);
+void SemanticAnalyzer::declareVariable(SymbolId symbol, TypeId type) {
+    variables.declare(symbol, type);
 }
 
-std::string SemanticAnalyzer::lookupVariable(const std::string& name) {
-    for (size_t i = scopes.size() - 1; i >= 0; i--) {
-        if (scopes[i].count(name) != 0U) {
-            return scopes[i][name];
-        }
+TypeId SemanticAnalyzer::lookupVariable(SymbolId symbol, std::string_view name) {
+    TypeId type = variables.lookup(symbol);
+    if (type == TypeId::None) {
+        throw std::runtime_error("Undeclared variable: " + std::string(name));
     }
-
-    throw std::runtime_error("Undeclared variable: " + name);
+    return type;
 }
 
-bool SemanticAnalyzer::isReserved(const std::string& name, const FunctionSignature& sig) {
-    for (const auto& pair : reservedFunctions) {
-        if (pair.first == name) {
-            for (const auto& reserved : pair.second) {
-                if (reserved == sig) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+bool SemanticAnalyzer::isReserved(SymbolId symbol, const FunctionSignature& sig) {
+    auto reserved = reservedFunctions.find(symbol);
+    return reserved != reservedFunctions.end() &&
+           std::find(reserved->second.begin(), reserved->second.end(), sig) !=
+               reserved->second.end();
 }
 
-std::string SemanticAnalyzer::findFunction(const std::string& name,
-                                           std::vector<std::string> paramTypes,
-                                           std::string& expected) {
-    auto search = [&](const std::vector<FunctionSignature>& candidates) -> std::string {
+TypeId SemanticAnalyzer::findFunction(SymbolId symbol, const std::vector<TypeId>& paramTypes,
+                                      TypeId expected) {
+    auto search = [&](const std::vector<FunctionSignature>& candidates) -> TypeId {
         for (const auto& fnc : candidates) {
             if (fnc.paramTypes == paramTypes) {
-                if (expected.empty() || fnc.returnType == expected) {
+                if (expected == TypeId::None || fnc.returnType == expected) {
                     return fnc.returnType;
                 }
             }
         }
-        return "";
+        return TypeId::None;
     };
 
-    if (reservedFunctions.count(name) != 0U) {
-        return search(reservedFunctions.at(name));
+    if (reservedFunctions.count(symbol) != 0U) {
+        return search(reservedFunctions.at(symbol));
     }
-    if (functions.count(name) != 0U) {
-        return search(functions[name]);
+    if (functions.count(symbol) != 0U) {
+        return search(functions[symbol]);
     }
 
-    return "";
+    return TypeId::None;
 }
\ No newline at end of file
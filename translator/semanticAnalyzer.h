@@ -8,6 +8,7 @@
 
 #include "ASTNode.hpp"
 #include "ASTVisitor.hpp"
+#include "symbolTable.hpp"
 
 class SemanticAnalyzer : ASTVisitor {
 public:
@@ -39,66 +40,65 @@ public:
 
 private:
     struct FunctionSignature {
-        std::string returnType;
-        std::vector<std::string> paramTypes;
+        TypeId returnType;
+        std::vector<TypeId> paramTypes;
 
         bool operator==(const FunctionSignature& other) const {
             return returnType == other.returnType && paramTypes == other.paramTypes;
         }
     };
 
-    std::unordered_map<std::string, std::vector<FunctionSignature>> functions;
-    std::vector<std::unordered_map<std::string, std::string>> scopes;
+    std::unordered_map<SymbolId, std::vector<FunctionSignature>> functions;
+    SymbolTable variables;
 
     // clang-format off
-    const std::unordered_map<std::string, std::vector<FunctionSignature>> reservedFunctions = {
-        {"in", {
-            {"int", {"int"}},
-            {"int", {}},
-            {"uint", {"int"}},
-            {"uint", {}},
-            {"char", {}},
-            {"string", {"int"}},
-            {"string", {}},
-            {"int[]", {"int"}},
-            {"int[]", {}}
+    const std::unordered_map<SymbolId, std::vector<FunctionSignature>> reservedFunctions = {
+        {SYMBOL_IN, {
+            {TypeId::Int, {TypeId::Int}},
+            {TypeId::Int, {}},
+            {TypeId::Uint, {TypeId::Int}},
+            {TypeId::Uint, {}},
+            {TypeId::Char, {}},
+            {TypeId::String, {TypeId::Int}},
+            {TypeId::String, {}},
+            {TypeId::IntArray, {TypeId::Int}},
+            {TypeId::IntArray, {}}
         }},
-        {"out", {
-            {"void", {"int"}},
-            {"void", {"uint"}},
-            {"void", {"char"}},
-            {"void", {"int[]"}},
-            {"void", {"string"}}
+        {SYMBOL_OUT, {
+            {TypeId::Void, {TypeId::Int}},
+            {TypeId::Void, {TypeId::Uint}},
+            {TypeId::Void, {TypeId::Char}},
+            {TypeId::Void, {TypeId::IntArray}},
+            {TypeId::Void, {TypeId::String}}
         }}
     };
 
-    const std::unordered_map<std::string, std::unordered_map<std::string, FunctionSignature>> typeMethods = {
-        {"int[]", {
-            {"size", {"int", {}}}
+    const std::unordered_map<TypeId, std::unordered_map<SymbolId, FunctionSignature>> typeMethods = {
+        {TypeId::IntArray, {
+            {SYMBOL_SIZE, {TypeId::Int, {}}}
         }},
 
-        {"string", {
-            {"size", {"int", {}}}
+        {TypeId::String, {
+            {SYMBOL_SIZE, {TypeId::Int, {}}}
         }}
     };
     // clang-format on
 
-    bool isReserved(const std::string& name, const FunctionSignature& sig);
-    std::string findFunction(const std::string& name, std::vector<std::string> paramTypes,
-                             std::string& expected);
+    bool isReserved(SymbolId symbol, const FunctionSignature& sig);
+    TypeId findFunction(SymbolId symbol, const std::vector<TypeId>& paramTypes, TypeId expected);
 
     void enterScope();
     void exitScope();
 
-    void declareVariable(const std::string& name, std::string data);
-    std::string lookupVariable(const std::string& name);
+    void declareVariable(SymbolId symbol, TypeId type);
+    TypeId lookupVariable(SymbolId symbol, std::string_view name);
 
-    int loopDepth  = 0;
-    bool hasReturn = false;
-    std::string currentReturnType;
+    int loopDepth            = 0;
+    bool hasReturn           = false;
+    TypeId currentReturnType = TypeId::None;
 
     ExpressionNode* lastVisitedExpression = nullptr;
-    std::string expectedType;
+    TypeId expectedType                   = TypeId::None;
 };
 
 #endif
\ No newline at end of file
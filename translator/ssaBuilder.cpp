@@ -0,0 +1,484 @@
+#include "ssaBuilder.h"
+
+#include <algorithm>
+
+#include "codeGenerator.h"
+
+namespace {
+
+// Taken after `cmp left, right` when the comparison holds.
+Opcode comparisonJump(Operator opr, bool isUnsigned) {
+    switch (opr) {
+        case Operator::Equal:
+            return Opcode::Jz;
+        case Operator::NotEqual:
+            return Opcode::Jnz;
+        case Operator::Greater:
+            return isUnsigned ? Opcode::Ja : Opcode::Jg;
+        case Operator::GreaterEqual:
+            return isUnsigned ? Opcode::Jae : Opcode::Jge;
+        case Operator::Less:
+            return isUnsigned ? Opcode::Jb : Opcode::Jl;
+        default:
+            return isUnsigned ? Opcode::Jbe : Opcode::Jle;
+    }
+}
+
+SsaOp arithmeticOp(Operator opr) {
+    switch (opr) {
+        case Operator::Add:
+            return SsaOp::Add;
+        case Operator::Sub:
+            return SsaOp::Sub;
+        case Operator::Mul:
+            return SsaOp::Mul;
+        case Operator::Div:
+            return SsaOp::Div;
+        case Operator::Rem:
+            return SsaOp::Rem;
+        case Operator::ShiftLeft:
+            return SsaOp::Shl;
+        case Operator::ShiftRight:
+            return SsaOp::Shr;
+        case Operator::BitAnd:
+            return SsaOp::And;
+        case Operator::BitOr:
+            return SsaOp::Or;
+        default:
+            return SsaOp::Xor;
+    }
+}
+
+TypeId typeOf(ASTNode* node) {
+    return dynamic_cast<ExpressionNode*>(node)->resolvedType;
+}
+
+}  // namespace
+
+SsaFunction SsaBuilder::buildProgram(const std::vector<ASTNode*>& statements,
+                                     const MemoryNames& inMemory) {
+    start("_start", inMemory);
+    for (ASTNode* statement : statements) {
+        statement->accept(*this);
+    }
+    terminate({SsaOp::Halt}, {});
+    return std::move(function);
+}
+
+SsaFunction SsaBuilder::buildFunction(FunctionNode& node, const std::string& label,
+                                      const MemoryNames& inMemory) {
+    start(label, inMemory);
+    function.parameterCount = static_cast<uint32_t>(node.parameters.size());
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+        auto* parameter = dynamic_cast<ParameterNode*>(node.parameters[i]);
+        SsaInstr param{SsaOp::Param};
+        param.bits = static_cast<uint32_t>(i);
+        writeVariable(newVariable(parameter->name), current, emit(param));
+    }
+
+    node.body->accept(*this);
+    // A void function may end without a return statement.
+    terminate({SsaOp::Return}, {});
+    return std::move(function);
+}
+
+void SsaBuilder::start(std::string name, const MemoryNames& memoryNames) {
+    function = SsaFunction(std::move(name));
+    inMemory = memoryNames;
+    variables.clear();
+    definitions.clear();
+    sealed.clear();
+    incompletePhis.clear();
+    breakTargets.clear();
+
+    enter(newBlock());
+    seal(current);
+}
+
+void SsaBuilder::visit(VarDeclNode& node) {
+    assign(node.name, value(node.value), true);
+}
+
+void SsaBuilder::visit(NumberLiteralNode& node) {
+    result = constant(static_cast<uint32_t>(node.number));
+}
+
+void SsaBuilder::visit(CharLiteralNode& node) {
+    // The same word ldi would load for it.
+    result = constant(static_cast<uint32_t>(static_cast<int>(node.value)) & FULL_MASK_24);
+}
+
+void SsaBuilder::visit(StringLiteralNode& node) {
+    std::vector<Operand> chars = decodeString(node.value);
+    chars.insert(chars.begin(), Operand::immediate(chars.size()));
+    result = literalData("str_", strCounter, std::move(chars));
+}
+
+void SsaBuilder::visit(BooleanLiteralNode& node) {
+    result = constant(node.value ? 1 : 0);
+}
+
+void SsaBuilder::visit([[maybe_unused]] VoidLiteralNode& node) {
+    result = NO_VALUE;
+}
+
+void SsaBuilder::visit(IntArrayLiteralNode& node) {
+    std::vector<Operand> values = {Operand::immediate(node.values.size())};
+    for (ASTNode* element : node.values) {
+        auto* numberNode = dynamic_cast<NumberLiteralNode*>(element);
+        values.push_back(Operand::immediate(static_cast<uint32_t>(numberNode->number)));
+    }
+    result = literalData("arr_", arrCounter, std::move(values));
+}
+
+void SsaBuilder::visit(ArrayGetNode& node) {
+    ValueId array = value(node.object);
+    ValueId index = value(node.index);
+    result        = emit({SsaOp::LoadElement, 0, {array, index}});
+}
+
+void SsaBuilder::visit(MethodCallNode& node) {
+    if (node.method != SYMBOL_SIZE) {
+        throw std::runtime_error("Unknown method: " + std::string(node.methodName));
+    }
+    result = emit({SsaOp::Size, 0, {value(node.object)}});
+}
+
+void SsaBuilder::visit(IdentifierNode& node) {
+    result = read(node.name);
+}
+
+void SsaBuilder::visit(AssignNode& node) {
+    if (node.var1->nodeType == ASTNodeType::Identifier) {
+        assign(dynamic_cast<IdentifierNode*>(node.var1)->name, value(node.var2), false);
+        return;
+    }
+
+    auto* element  = dynamic_cast<ArrayGetNode*>(node.var1);
+    ValueId stored = value(node.var2);
+    ValueId array  = value(element->object);
+    ValueId index  = value(element->index);
+    emit({SsaOp::StoreElement, 0, {array, index, stored}});
+}
+
+void SsaBuilder::visit(BinaryOpNode& node) {
+    ValueId left  = value(node.left);
+    ValueId right = value(node.right);
+
+    // Like the template generator, a && or || whose value is needed evaluates both sides; only
+    // conditions short-circuit. Booleans are 0 or 1, so the bitwise operators do.
+    if (node.op == Operator::And || node.op == Operator::Or) {
+        result = emit({node.op == Operator::And ? SsaOp::And : SsaOp::Or, 0, {left, right}});
+        return;
+    }
+    if (isComparison(node.op)) {
+        bool isUnsigned = typeOf(node.left) == TypeId::Uint || typeOf(node.right) == TypeId::Uint;
+        SsaInstr compare{SsaOp::Compare, 0, {left, right}};
+        compare.jump = comparisonJump(node.op, isUnsigned);
+        result       = emit(compare);
+        return;
+    }
+    result = emit({arithmeticOp(node.op), 0, {left, right}});
+}
+
+void SsaBuilder::visit(UnaryOpNode& node) {
+    ValueId operand = value(node.operand);
+    if (node.op == Operator::Sub) {
+        result = emit({SsaOp::Neg, 0, {operand}});
+    } else {
+        // Booleans are 0 or 1.
+        result = emit({SsaOp::Xor, 0, {operand, constant(1)}});
+    }
+}
+
+void SsaBuilder::visit(IfNode& node) {
+    BlockId thenBlock = newBlock();
+    BlockId elseBlock = node.elseBranch != nullptr ? newBlock() : NO_BLOCK;
+    BlockId endBlock  = newBlock();
+
+    branch(node.condition, thenBlock, elseBlock != NO_BLOCK ? elseBlock : endBlock);
+    seal(thenBlock);
+
+    enter(thenBlock);
+    node.thenBranch->accept(*this);
+    jump(endBlock);
+
+    if (elseBlock != NO_BLOCK) {
+        seal(elseBlock);
+        enter(elseBlock);
+        node.elseBranch->accept(*this);
+        jump(endBlock);
+    }
+
+    seal(endBlock);
+    enter(endBlock);
+}
+
+// Rotated like the template generator's loops: the condition is tested on entry and again at
+// the bottom of the body, which is the loop header.
+void SsaBuilder::visit(WhileNode& node) {
+    BlockId body = newBlock();
+    BlockId exit = newBlock();
+
+    branch(node.condition, body, exit);
+    breakTargets.push_back(exit);
+
+    enter(body);
+    node.body->accept(*this);
+    branch(node.condition, body, exit);
+
+    breakTargets.pop_back();
+    seal(body);
+    seal(exit);
+    enter(exit);
+}
+
+void SsaBuilder::visit([[maybe_unused]] BreakNode& node) {
+    jump(breakTargets.back());
+}
+
+void SsaBuilder::visit(BlockNode& node) {
+    for (ASTNode* child : node.children) {
+        child->accept(*this);
+    }
+}
+
+void SsaBuilder::visit([[maybe_unused]] ParameterNode& node) {
+    throw std::logic_error("visit(ParameterNode&) should not be called in SsaBuilder");
+}
+
+void SsaBuilder::visit([[maybe_unused]] FunctionNode& node) {
+    throw std::logic_error("functions are built one at a time");
+}
+
+void SsaBuilder::visit(FunctionCallNode& node) {
+    std::vector<ValueId> arguments;
+    std::vector<TypeId> argTypes;
+    for (ASTNode* argument : node.parameters) {
+        arguments.push_back(value(argument));
+        argTypes.push_back(typeOf(argument));
+    }
+
+    if (node.symbol == SYMBOL_IN) {
+        SsaInstr count{SsaOp::Store, 0, {arguments.empty() ? constant(0) : arguments[0]}};
+        count.label = "input_count";
+        emit(count);
+
+        SsaInstr call{SsaOp::RuntimeCall};
+        switch (node.resolvedType) {
+            case TypeId::Char:
+                call.label = "read_char";
+                break;
+            case TypeId::String:
+                call.label = "read_string";
+                break;
+            case TypeId::IntArray:
+                call.label = "read_arr";
+                break;
+            default:
+                call.label = "read_int";
+                break;
+        }
+        result = emit(call);
+        return;
+    }
+
+    if (node.symbol == SYMBOL_OUT) {
+        SsaInstr call{SsaOp::RuntimeCall, 0, arguments};
+        switch (argTypes[0]) {
+            case TypeId::Uint:
+                call.label = "write_uint";
+                break;
+            case TypeId::Char:
+                call.label = "write_char";
+                break;
+            case TypeId::String:
+                call.label = "write_string";
+                break;
+            case TypeId::IntArray:
+                call.label = "write_arr";
+                break;
+            default:
+                call.label = "write_int";
+                break;
+        }
+        result = emit(call);
+        return;
+    }
+
+    SsaInstr call{SsaOp::Call, 0, std::move(arguments)};
+    call.label = calleeLabel(node);
+    result     = emit(call);
+}
+
+void SsaBuilder::visit(ReturnNode& node) {
+    ValueId returned = value(node.returnValue);
+    terminate({SsaOp::Return, 0, returned != NO_VALUE ? std::vector{returned}
+                                                      : std::vector<ValueId>{}},
+              {});
+}
+
+ValueId SsaBuilder::value(ASTNode* node) {
+    result = NO_VALUE;
+    node->accept(*this);
+    return result;
+}
+
+ValueId SsaBuilder::emit(SsaInstr instr) {
+    return function.append(current, std::move(instr));
+}
+
+ValueId SsaBuilder::constant(uint32_t bits) {
+    SsaInstr instr{SsaOp::Const};
+    instr.bits = bits;
+    return emit(instr);
+}
+
+ValueId SsaBuilder::literalData(const std::string& prefix, int& counter,
+                                std::vector<Operand> words) {
+    std::string label = prefix + std::to_string(counter++);
+    program.data.push_back({program.label(label), std::move(words)});
+
+    SsaInstr address{SsaOp::Address};
+    address.label = label;
+    return emit(address);
+}
+
+void SsaBuilder::branch(ASTNode* condition, BlockId trueBlock, BlockId falseBlock) {
+    if (condition->nodeType == ASTNodeType::BinaryOp) {
+        auto* binaryOp = dynamic_cast<BinaryOpNode*>(condition);
+        if (binaryOp->op == Operator::And || binaryOp->op == Operator::Or) {
+            BlockId rightSide = newBlock();
+            if (binaryOp->op == Operator::And) {
+                branch(binaryOp->left, rightSide, falseBlock);
+            } else {
+                branch(binaryOp->left, trueBlock, rightSide);
+            }
+            seal(rightSide);
+            enter(rightSide);
+            branch(binaryOp->right, trueBlock, falseBlock);
+            return;
+        }
+    }
+    if (condition->nodeType == ASTNodeType::UnaryOp &&
+        dynamic_cast<UnaryOpNode*>(condition)->op == Operator::Not) {
+        branch(dynamic_cast<UnaryOpNode*>(condition)->operand, falseBlock, trueBlock);
+        return;
+    }
+    if (condition->nodeType == ASTNodeType::BooleanLiteral) {
+        jump(dynamic_cast<BooleanLiteralNode*>(condition)->value ? trueBlock : falseBlock);
+        return;
+    }
+
+    terminate({SsaOp::Branch, 0, {value(condition)}}, {trueBlock, falseBlock});
+}
+
+void SsaBuilder::jump(BlockId target) {
+    terminate({SsaOp::Jump}, {target});
+}
+
+void SsaBuilder::terminate(SsaInstr instr, std::vector<BlockId> targets) {
+    emit(std::move(instr));
+    for (BlockId target : targets) {
+        function.addEdge(current, target);
+    }
+    BlockId unreachable = newBlock();
+    seal(unreachable);
+    enter(unreachable);
+}
+
+void SsaBuilder::enter(BlockId block) {
+    current = block;
+    function.layout.push_back(block);
+}
+
+BlockId SsaBuilder::newBlock() {
+    sealed.push_back(false);
+    incompletePhis.emplace_back();
+    return function.addBlock();
+}
+
+void SsaBuilder::assign(std::string_view name, ValueId assigned, bool declaring) {
+    auto known = variables.find(std::string(name));
+    if (known == variables.end() && (!declaring || inMemory(name))) {
+        SsaInstr store{SsaOp::Store, 0, {assigned}};
+        store.label = "var_" + std::string(name);
+        emit(store);
+        return;
+    }
+
+    uint32_t variable = known != variables.end() ? known->second : newVariable(name);
+    writeVariable(variable, current, emit({SsaOp::Copy, 0, {assigned}}));
+}
+
+uint32_t SsaBuilder::newVariable(std::string_view name) {
+    auto variable = static_cast<uint32_t>(definitions.size());
+    variables[std::string(name)] = variable;
+    definitions.emplace_back();
+    return variable;
+}
+
+ValueId SsaBuilder::read(std::string_view name) {
+    auto known = variables.find(std::string(name));
+    if (known != variables.end()) {
+        return readVariable(known->second, current);
+    }
+
+    SsaInstr load{SsaOp::Load};
+    load.label = "var_" + std::string(name);
+    return emit(load);
+}
+
+void SsaBuilder::writeVariable(uint32_t variable, BlockId block, ValueId value) {
+    definitions[variable][block] = value;
+}
+
+ValueId SsaBuilder::readVariable(uint32_t variable, BlockId block) {
+    auto known = definitions[variable].find(block);
+    if (known != definitions[variable].end()) {
+        return known->second;
+    }
+
+    const std::vector<BlockId>& predecessors = function.blocks[block].predecessors;
+    ValueId found                            = NO_VALUE;
+    if (!sealed[block]) {
+        found = function.append(block, {SsaOp::Phi});
+        incompletePhis[block].emplace_back(variable, found);
+    } else if (predecessors.empty()) {
+        // Read before any assignment on this path; static storage would hold 0. The block's
+        // code may already be under way, so the constant goes right after its phis.
+        found                      = function.append(block, {SsaOp::Const});
+        std::vector<ValueId>& code = function.blocks[block].code;
+        code.pop_back();
+        code.insert(std::find_if(code.begin(), code.end(),
+                                 [this](ValueId other) {
+                                     return function[other].op != SsaOp::Phi;
+                                 }),
+                    found);
+    } else if (predecessors.size() == 1) {
+        found = readVariable(variable, predecessors[0]);
+    } else {
+        // Recorded before the arguments are read, so a cycle through a loop ends at this phi.
+        found = function.append(block, {SsaOp::Phi});
+        writeVariable(variable, block, found);
+        for (BlockId predecessor : predecessors) {
+            ValueId argument = readVariable(variable, predecessor);
+            function[found].args.push_back(argument);
+        }
+    }
+    writeVariable(variable, block, found);
+    return found;
+}
+
+void SsaBuilder::seal(BlockId block) {
+    // Each read is of the phi's own variable, which the block already defines, so the list does
+    // not grow meanwhile.
+    for (auto [variable, phi] : incompletePhis[block]) {
+        for (BlockId predecessor : function.blocks[block].predecessors) {
+            ValueId argument = readVariable(variable, predecessor);
+            function[phi].args.push_back(argument);
+        }
+    }
+    incompletePhis[block].clear();
+    sealed[block] = true;
+}
@@ -0,0 +1,110 @@
+#ifndef _SSA_BUILDER_H
+#define _SSA_BUILDER_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ASTNode.hpp"
+#include "ASTVisitor.hpp"
+#include "ssaIR.h"
+
+// Builds the SSA form of the main program or of one function straight from the checked tree,
+// after Braun et al.: reading a variable looks for its value through the predecessors of the
+// reading block, and a block whose predecessors are not all known yet (a loop body) gets
+// placeholder phis that are completed once the block is sealed. Assignments become copies and
+// trivial phis are left in place for the passes to clean up.
+//
+// Variables of the region become values. A name kept in memory is read and written in its var_
+// cell instead; calls may reach those cells.
+class SsaBuilder : ASTVisitor {
+public:
+    // Whether a name refers to a var_<name> cell rather than a variable of the region.
+    using MemoryNames = std::function<bool(std::string_view)>;
+    // Label of the function a call resolves to.
+    using CalleeLabels = std::function<const std::string&(FunctionCallNode&)>;
+
+    // String and array literals go to the program's data as str_N and arr_N, continuing the
+    // given counters.
+    SsaBuilder(AsmProgram& program, int& strCounter, int& arrCounter, CalleeLabels calleeLabel)
+        : program(program),
+          strCounter(strCounter),
+          arrCounter(arrCounter),
+          calleeLabel(std::move(calleeLabel)) {
+    }
+
+    // The statements run in order and the program halts after them.
+    SsaFunction buildProgram(const std::vector<ASTNode*>& statements, const MemoryNames& inMemory);
+    // Parameters are read from the caller's frame on entry.
+    SsaFunction buildFunction(FunctionNode& node, const std::string& label,
+                              const MemoryNames& inMemory);
+
+    void visit(VarDeclNode& node) override;
+    void visit(NumberLiteralNode& node) override;
+    void visit(CharLiteralNode& node) override;
+    void visit(StringLiteralNode& node) override;
+    void visit(BooleanLiteralNode& node) override;
+    void visit(VoidLiteralNode& node) override;
+    void visit(IntArrayLiteralNode& node) override;
+    void visit(ArrayGetNode& node) override;
+    void visit(MethodCallNode& node) override;
+    void visit(IdentifierNode& node) override;
+    void visit(AssignNode& node) override;
+    void visit(BinaryOpNode& node) override;
+    void visit(UnaryOpNode& node) override;
+    void visit(IfNode& node) override;
+    void visit(WhileNode& node) override;
+    void visit(BreakNode& node) override;
+    void visit(BlockNode& node) override;
+    void visit(ParameterNode& node) override;
+    void visit(FunctionNode& node) override;
+    void visit(FunctionCallNode& node) override;
+    void visit(ReturnNode& node) override;
+
+private:
+    void start(std::string name, const MemoryNames& inMemory);
+
+    ValueId value(ASTNode* node);
+    ValueId emit(SsaInstr instr);
+    ValueId constant(uint32_t bits);
+    ValueId literalData(const std::string& prefix, int& counter, std::vector<Operand> words);
+
+    // Jumps to trueBlock when the boolean holds and to falseBlock otherwise; && and || become
+    // control flow.
+    void branch(ASTNode* condition, BlockId trueBlock, BlockId falseBlock);
+    void jump(BlockId target);
+    void terminate(SsaInstr instr, std::vector<BlockId> targets);
+    // Starts filling the block; code after a jump or return goes to a block nothing reaches.
+    void enter(BlockId block);
+    BlockId newBlock();
+
+    void assign(std::string_view name, ValueId value, bool declaring);
+    uint32_t newVariable(std::string_view name);
+    ValueId read(std::string_view name);
+    void writeVariable(uint32_t variable, BlockId block, ValueId value);
+    ValueId readVariable(uint32_t variable, BlockId block);
+    void seal(BlockId block);
+
+    AsmProgram& program;
+    int& strCounter;
+    int& arrCounter;
+    CalleeLabels calleeLabel;
+
+    SsaFunction function{""};
+    MemoryNames inMemory;
+    BlockId current = 0;
+    ValueId result  = NO_VALUE;
+    std::vector<BlockId> breakTargets;
+
+    std::unordered_map<std::string, uint32_t> variables;
+    // Indexed by variable: its value at the end of each block that defines it.
+    std::vector<std::unordered_map<BlockId, ValueId>> definitions;
+    std::vector<bool> sealed;
+    // Indexed by block: placeholder phis and the variables they stand for.
+    std::vector<std::vector<std::pair<uint32_t, ValueId>>> incompletePhis;
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "ssaIR.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+std::string_view opName(SsaOp op) {
+    // clang-format off
+    constexpr std::array<std::string_view, 28> NAMES = {
+        "const", "address", "param", "copy", "phi",
+        "load", "store", "size", "load_element", "store_element",
+        "add", "sub", "mul", "div", "rem", "shl", "shr", "and", "or", "xor", "neg", "compare",
+        "call", "runtime_call",
+        "jump", "branch", "return", "halt",
+    };
+    // clang-format on
+    return NAMES.at(static_cast<size_t>(op));
+}
+
+BlockId SsaFunction::addBlock() {
+    blocks.emplace_back();
+    return static_cast<BlockId>(blocks.size() - 1);
+}
+
+ValueId SsaFunction::append(BlockId block, SsaInstr instr) {
+    instr.block = block;
+    auto value  = static_cast<ValueId>(values.size());
+    bool isPhi  = instr.op == SsaOp::Phi;
+    values.push_back(std::move(instr));
+
+    std::vector<ValueId>& code = blocks[block].code;
+    if (!isPhi) {
+        code.push_back(value);
+        return value;
+    }
+    auto firstOther = std::find_if(code.begin(), code.end(), [this](ValueId other) {
+        return values[other].op != SsaOp::Phi;
+    });
+    code.insert(firstOther, value);
+    return value;
+}
+
+void SsaFunction::addEdge(BlockId from, BlockId to) {
+    blocks[from].successors.push_back(to);
+    blocks[to].predecessors.push_back(from);
+}
+
+void SsaFunction::replaceUses(ValueId from, ValueId to) {
+    for (SsaInstr& instr : values) {
+        if (instr.removed) {
+            continue;
+        }
+        std::replace(instr.args.begin(), instr.args.end(), from, to);
+    }
+}
+
+void SsaFunction::remove(ValueId value) {
+    SsaInstr& instr = values[value];
+    if (instr.removed) {
+        return;
+    }
+    std::vector<ValueId>& code = blocks[instr.block].code;
+    code.erase(std::find(code.begin(), code.end(), value));
+    instr.removed = true;
+    instr.args.clear();
+}
+
+void SsaFunction::removeEdge(BlockId from, BlockId to) {
+    std::vector<BlockId>& successors = blocks[from].successors;
+    successors.erase(std::find(successors.begin(), successors.end(), to));
+
+    std::vector<BlockId>& predecessors = blocks[to].predecessors;
+    auto position                      = std::find(predecessors.begin(), predecessors.end(), from);
+    auto index                         = position - predecessors.begin();
+    predecessors.erase(position);
+
+    for (ValueId value : blocks[to].code) {
+        if (values[value].op == SsaOp::Phi) {
+            values[value].args.erase(values[value].args.begin() + index);
+        }
+    }
+}
+
+std::vector<uint32_t> SsaFunction::useCounts() const {
+    std::vector<uint32_t> counts(values.size(), 0);
+    for (const SsaInstr& instr : values) {
+        if (instr.removed) {
+            continue;
+        }
+        for (ValueId arg : instr.args) {
+            counts[arg]++;
+        }
+    }
+    return counts;
+}
+
+std::vector<BlockId> SsaFunction::reversePostorder() const {
+    std::vector<BlockId> order;
+    std::vector<bool> visited(blocks.size(), false);
+
+    // Depth first with a stack of its own: inlining makes chains of blocks too long to recurse
+    // along. Each entry holds the next successor to look at.
+    std::vector<std::pair<BlockId, size_t>> stack = {{0, 0}};
+    visited[0]                                    = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next == blocks[block].successors.size()) {
+            order.push_back(block);
+            stack.pop_back();
+            continue;
+        }
+        BlockId successor = blocks[block].successors[next++];
+        if (!visited[successor]) {
+            visited[successor] = true;
+            stack.emplace_back(successor, 0);
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Cooper, Harvey and Kennedy's iteration over the reverse postorder.
+std::vector<BlockId> SsaFunction::immediateDominators() const {
+    std::vector<BlockId> order = reversePostorder();
+    std::vector<uint32_t> position(blocks.size(), 0);
+    for (size_t i = 0; i < order.size(); i++) {
+        position[order[i]] = static_cast<uint32_t>(i);
+    }
+
+    std::vector<BlockId> dominator(blocks.size(), NO_BLOCK);
+    dominator[0] = 0;
+
+    auto intersect = [&](BlockId left, BlockId right) {
+        while (left != right) {
+            while (position[left] > position[right]) {
+                left = dominator[left];
+            }
+            while (position[right] > position[left]) {
+                right = dominator[right];
+            }
+        }
+        return left;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            BlockId block = order[i];
+            BlockId idom  = NO_BLOCK;
+            for (BlockId predecessor : blocks[block].predecessors) {
+                if (dominator[predecessor] == NO_BLOCK) {
+                    continue;
+                }
+                idom = idom == NO_BLOCK ? predecessor : intersect(predecessor, idom);
+            }
+            if (dominator[block] != idom) {
+                dominator[block] = idom;
+                changed          = true;
+            }
+        }
+    }
+    return dominator;
+}
+
+void SsaFunction::print(std::ostream& out) const {
+    out << "function " << name << "\n";
+
+    for (BlockId block : layout) {
+        const SsaBlock& data = blocks[block];
+        if (data.code.empty()) {
+            continue;
+        }
+
+        out << "b" << block << ":";
+        if (!data.predecessors.empty()) {
+            out << " ; from";
+            for (BlockId predecessor : data.predecessors) {
+                out << " b" << predecessor;
+            }
+        }
+        out << "\n";
+
+        for (ValueId value : data.code) {
+            const SsaInstr& instr = values[value];
+            out << "  ";
+            if (!hasSideEffects(instr.op) || instr.op == SsaOp::Call ||
+                instr.op == SsaOp::RuntimeCall) {
+                out << "v" << value << " = ";
+            }
+            out << opName(instr.op);
+            if (instr.op == SsaOp::Compare) {
+                out << " " << mnemonicName(instr.jump);
+            }
+            if (instr.op == SsaOp::Const || instr.op == SsaOp::Param) {
+                out << " " << instr.bits;
+            }
+            if (!instr.label.empty()) {
+                out << " " << instr.label;
+            }
+            for (size_t i = 0; i < instr.args.size(); i++) {
+                out << (i == 0 && instr.label.empty() ? " " : ", ") << "v" << instr.args[i];
+            }
+            for (size_t i = 0; i < data.successors.size() && isTerminator(instr.op); i++) {
+                out << (i == 0 && instr.args.empty() ? " " : ", ") << "b" << data.successors[i];
+            }
+            out << "\n";
+        }
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef _SSA_IR_H
+#define _SSA_IR_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "asmIR.h"
+
+// Three-address SSA form of one function (or of the main program) between the AST and assembly.
+// Every instruction defines at most one value, named by the instruction's index, and no value
+// is assigned twice. A block's phis come first and take one argument per predecessor, in the
+// order of SsaBlock::predecessors; its last instruction is a terminator.
+using ValueId = uint32_t;
+using BlockId = uint32_t;
+
+constexpr ValueId NO_VALUE = UINT32_MAX;
+constexpr BlockId NO_BLOCK = UINT32_MAX;
+
+enum class SsaOp : uint8_t {
+    Const,    // bits
+    Address,  // label
+    Param,    // bits: parameter index
+    Copy,     // args[0]
+    Phi,
+
+    Load,          // label
+    Store,         // label, args[0]
+    Size,          // length word of the array or string args[0]
+    LoadElement,   // args: array, index
+    StoreElement,  // args: array, index, value
+
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Rem,
+    Shl,
+    Shr,
+    And,
+    Or,
+    Xor,
+    Neg,
+    Compare,  // 1 when jump would be taken after `cmp args[0], args[1]`, else 0
+
+    Call,         // label; arguments pushed in order
+    RuntimeCall,  // label; args[0], if any, passed in the accumulator
+
+    Jump,    // successors[0]
+    Branch,  // args[0] != 0 ? successors[0] : successors[1]
+    Return,  // args[0], if any
+    Halt,
+};
+
+struct SsaInstr {
+    SsaOp op;
+    BlockId block             = 0;
+    std::vector<ValueId> args = {};
+    uint32_t bits             = 0;
+    Opcode jump               = Opcode::Jz;
+    std::string label         = {};
+    bool removed              = false;
+};
+
+struct SsaBlock {
+    std::vector<ValueId> code;
+    std::vector<BlockId> predecessors;
+    std::vector<BlockId> successors;
+};
+
+std::string_view opName(SsaOp op);
+
+constexpr bool isTerminator(SsaOp op) {
+    return op >= SsaOp::Jump;
+}
+
+// Stores, calls and terminators must stay even when nothing reads their value.
+constexpr bool hasSideEffects(SsaOp op) {
+    return op == SsaOp::Store || op == SsaOp::StoreElement || op == SsaOp::Call ||
+           op == SsaOp::RuntimeCall || isTerminator(op);
+}
+
+// The value depends only on the arguments, so two such instructions with equal arguments agree.
+// Arrays never change length, so Size counts.
+constexpr bool isPure(SsaOp op) {
+    return op == SsaOp::Const || op == SsaOp::Address || op == SsaOp::Param ||
+           op == SsaOp::Size || (op >= SsaOp::Add && op <= SsaOp::Compare);
+}
+
+constexpr bool isCommutative(SsaOp op) {
+    return op == SsaOp::Add || op == SsaOp::Mul || op == SsaOp::And || op == SsaOp::Or ||
+           op == SsaOp::Xor;
+}
+
+// Jump with the same meaning once the operands of the comparison are swapped.
+constexpr Opcode swappedJump(Opcode jump) {
+    switch (jump) {
+        case Opcode::Jg:
+            return Opcode::Jl;
+        case Opcode::Jl:
+            return Opcode::Jg;
+        case Opcode::Jge:
+            return Opcode::Jle;
+        case Opcode::Jle:
+            return Opcode::Jge;
+        case Opcode::Ja:
+            return Opcode::Jb;
+        case Opcode::Jb:
+            return Opcode::Ja;
+        case Opcode::Jae:
+            return Opcode::Jbe;
+        case Opcode::Jbe:
+            return Opcode::Jae;
+        default:
+            return jump;
+    }
+}
+
+class SsaFunction {
+public:
+    explicit SsaFunction(std::string name) : name(std::move(name)) {
+    }
+
+    BlockId addBlock();
+    // Appends to the block, or puts a phi after the block's other phis.
+    ValueId append(BlockId block, SsaInstr instr);
+    void addEdge(BlockId from, BlockId to);
+
+    [[nodiscard]] const SsaInstr& operator[](ValueId value) const {
+        return values[value];
+    }
+    SsaInstr& operator[](ValueId value) {
+        return values[value];
+    }
+
+    // Points every argument that reads from at to.
+    void replaceUses(ValueId from, ValueId to);
+    void remove(ValueId value);
+    // Drops the edge, and the matching argument of each phi in to.
+    void removeEdge(BlockId from, BlockId to);
+
+    // Number of arguments, phi arguments included, that read each value.
+    [[nodiscard]] std::vector<uint32_t> useCounts() const;
+    // Immediate dominator of every block reachable from the entry; the entry is its own, and an
+    // unreachable block has NO_BLOCK.
+    [[nodiscard]] std::vector<BlockId> immediateDominators() const;
+    // Reachable blocks, each after all of its predecessors except along back edges.
+    [[nodiscard]] std::vector<BlockId> reversePostorder() const;
+
+    void print(std::ostream& out) const;
+
+    std::string name;
+    uint32_t parameterCount = 0;
+    std::vector<SsaInstr> values;
+    std::vector<SsaBlock> blocks;  // the entry is block 0
+    // Order the blocks were filled in by the builder, which lowering keeps.
+    std::vector<BlockId> layout;
+};
+
+#endif
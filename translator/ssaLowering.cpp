@@ -0,0 +1,816 @@
+#include "ssaLowering.h"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+
+#include "codeGenerator.h"
+
+namespace {
+
+bool hasPhis(const SsaFunction& function, BlockId block) {
+    const std::vector<ValueId>& code = function.blocks[block].code;
+    return !code.empty() && function[code.front()].op == SsaOp::Phi;
+}
+
+bool definesValue(SsaOp op) {
+    return op != SsaOp::Store && op != SsaOp::StoreElement && !isTerminator(op);
+}
+
+// Argument that is best computed in the accumulator right before the instruction, or -1 when
+// every argument is read from memory.
+int naturalSlot(const SsaInstr& instr) {
+    switch (instr.op) {
+        case SsaOp::LoadElement:
+            return 1;
+        case SsaOp::StoreElement:
+            return 2;
+        case SsaOp::Size:
+        case SsaOp::Phi:
+            return -1;
+        default:
+            return instr.args.empty() ? -1 : 0;
+    }
+}
+
+bool swappable(SsaOp op) {
+    return isCommutative(op) || op == SsaOp::Compare;
+}
+
+// Whether the instruction may change the memory the load reads.
+bool kills(const SsaInstr& instr, const SsaInstr& load) {
+    switch (instr.op) {
+        case SsaOp::Call:
+            return true;
+        case SsaOp::Store:
+            return load.op == SsaOp::Load && load.label == instr.label;
+        case SsaOp::StoreElement:
+            return load.op == SsaOp::LoadElement;
+        default:
+            return false;
+    }
+}
+
+std::optional<uint32_t> powerOfTwoExponent(const SsaInstr& instr) {
+    if (instr.op != SsaOp::Const || instr.bits == 0 || (instr.bits & (instr.bits - 1)) != 0) {
+        return std::nullopt;
+    }
+    uint32_t exponent = 0;
+    for (uint32_t bits = instr.bits; bits > 1; bits >>= 1) {
+        exponent++;
+    }
+    return exponent;
+}
+
+Opcode aluOpcode(SsaOp op) {
+    switch (op) {
+        case SsaOp::Add:
+            return Opcode::Add;
+        case SsaOp::Sub:
+            return Opcode::Sub;
+        case SsaOp::Mul:
+            return Opcode::Mul;
+        case SsaOp::Div:
+            return Opcode::Div;
+        case SsaOp::Rem:
+            return Opcode::Rem;
+        case SsaOp::Shl:
+            return Opcode::Shl;
+        case SsaOp::Shr:
+            return Opcode::Shr;
+        case SsaOp::And:
+            return Opcode::And;
+        case SsaOp::Or:
+            return Opcode::Or;
+        default:
+            return Opcode::Xor;
+    }
+}
+
+}  // namespace
+
+void SsaLowering::lower(SsaFunction& lowered, std::vector<TextItem>& out) {
+    function = &lowered;
+    splitCriticalEdges();
+    schedule();
+    classify();
+    assignCells();
+
+    // A jump to a block that only jumps on goes straight to where that one leads, unless the
+    // blocks form an empty loop.
+    forwarders.assign(function->blocks.size(), false);
+    for (BlockId block = 1; block < function->blocks.size(); block++) {
+        if (order[block].size() != 1 || (*function)[order[block][0]].op != SsaOp::Jump ||
+            !edgeCopies(block).empty()) {
+            continue;
+        }
+        BlockId target = function->blocks[block].successors[0];
+        while (forwarders[target] && target != block) {
+            target = function->blocks[target].successors[0];
+        }
+        forwarders[block] = target != block;
+    }
+
+    std::vector<BlockId> emitted;
+    for (BlockId block : function->layout) {
+        if (!order[block].empty() && !forwarders[block]) {
+            emitted.push_back(block);
+        }
+    }
+
+    std::vector<TextItem> body;
+    code = &body;
+    for (size_t i = 0; i < emitted.size(); i++) {
+        emitBlock(emitted[i], i + 1 < emitted.size() ? emitted[i + 1] : NO_BLOCK);
+    }
+
+    // Only the labels something jumps to are kept, so the peephole windows run across the rest.
+    std::vector<bool> referenced(program.labelCount(), false);
+    for (const TextItem& item : body) {
+        if (item.kind == TextItem::Kind::Instruction && item.operand.kind == Operand::Kind::Label) {
+            referenced[item.operand.value] = true;
+        }
+    }
+    out.push_back(TextItem::labelAt(program.label(function->name)));
+    std::copy_if(body.begin(), body.end(), std::back_inserter(out), [&](const TextItem& item) {
+        return item.kind == TextItem::Kind::Instruction || referenced[item.operand.value];
+    });
+    code = nullptr;
+}
+
+// An edge from a block with two successors into a block with phis gets a block of its own, where
+// the phi copies for that edge can go.
+void SsaLowering::splitCriticalEdges() {
+    auto count = static_cast<BlockId>(function->blocks.size());
+    std::vector<std::vector<BlockId>> splits(count);
+    for (BlockId block = 0; block < count; block++) {
+        for (size_t i = 0; i < function->blocks[block].successors.size(); i++) {
+            BlockId target = function->blocks[block].successors[i];
+            if (function->blocks[block].successors.size() < 2 || !hasPhis(*function, target)) {
+                continue;
+            }
+
+            BlockId split                         = function->addBlock();
+            function->blocks[block].successors[i] = split;
+            function->blocks[split].predecessors  = {block};
+            function->blocks[split].successors    = {target};
+            function->append(split, {SsaOp::Jump});
+
+            std::vector<BlockId>& predecessors = function->blocks[target].predecessors;
+            *std::find(predecessors.begin(), predecessors.end(), block) = split;
+
+            splits[block].push_back(split);
+        }
+    }
+
+    // Each split block goes right after the block it leaves.
+    std::vector<BlockId> layout;
+    for (BlockId block : function->layout) {
+        layout.push_back(block);
+        layout.insert(layout.end(), splits[block].rbegin(), splits[block].rend());
+    }
+    function->layout = std::move(layout);
+}
+
+void SsaLowering::schedule() {
+    useCounts = function->useCounts();
+    users.assign(function->values.size(), {});
+    for (ValueId value = 0; value < function->values.size(); value++) {
+        for (ValueId arg : (*function)[value].args) {
+            users[arg].push_back(value);
+        }
+    }
+
+    order.assign(function->blocks.size(), {});
+    std::vector<uint32_t> position(function->values.size(), 0);
+    std::vector<bool> sunk(function->values.size(), false);
+    for (BlockId block = 0; block < function->blocks.size(); block++) {
+        const std::vector<ValueId>& code = function->blocks[block].code;
+        for (size_t i = 0; i < code.size(); i++) {
+            position[code[i]] = static_cast<uint32_t>(i);
+        }
+        for (ValueId value : code) {
+            sunk[value] = sinkable(value, position);
+        }
+        for (ValueId value : code) {
+            if (!sunk[value]) {
+                place(value, order[block], sunk);
+            }
+        }
+    }
+}
+
+// A value with one user in its block moves down to that user, unless it is a load and
+// something in between may change what it reads.
+bool SsaLowering::sinkable(ValueId value, const std::vector<uint32_t>& position) const {
+    const SsaInstr& instr = (*function)[value];
+    if (useCounts[value] != 1 || instr.op == SsaOp::Phi) {
+        return false;
+    }
+    ValueId user = users[value][0];
+    if ((*function)[user].op == SsaOp::Phi || (*function)[user].block != instr.block) {
+        return false;
+    }
+    if (isPure(instr.op) || instr.op == SsaOp::Copy) {
+        return true;
+    }
+    if (instr.op != SsaOp::Load && instr.op != SsaOp::LoadElement) {
+        return false;
+    }
+
+    const std::vector<ValueId>& code = function->blocks[instr.block].code;
+    for (uint32_t i = position[value] + 1; i < position[user]; i++) {
+        if (kills((*function)[code[i]], instr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The arguments moved down to the instruction come first, the one it wants in the accumulator
+// last.
+void SsaLowering::place(ValueId value, std::vector<ValueId>& placed, std::vector<bool>& sunk) {
+    const SsaInstr& instr = (*function)[value];
+    auto isChild          = [&](ValueId arg) { return sunk[arg] && users[arg][0] == value; };
+
+    int slot = naturalSlot(instr);
+    if (slot >= 0 && !isChild(instr.args[slot]) && swappable(instr.op) &&
+        isChild(instr.args[1])) {
+        slot = 1;
+    }
+    for (size_t i = 0; i < instr.args.size(); i++) {
+        if (static_cast<int>(i) != slot && isChild(instr.args[i])) {
+            place(instr.args[i], placed, sunk);
+        }
+    }
+    if (slot >= 0 && isChild(instr.args[slot])) {
+        place(instr.args[slot], placed, sunk);
+    }
+    placed.push_back(value);
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void SsaLowering::classify() {
+    kinds.assign(function->values.size(), Kind::Cell);
+    slots.assign(function->values.size(), -1);
+
+    std::vector<uint32_t> position(function->values.size(), 0);
+    for (const std::vector<ValueId>& placed : order) {
+        for (size_t i = 0; i < placed.size(); i++) {
+            position[placed[i]] = static_cast<uint32_t>(i);
+        }
+    }
+
+    for (BlockId block = 0; block < function->blocks.size(); block++) {
+        const std::vector<ValueId>& placed = order[block];
+        for (size_t i = 0; i < placed.size(); i++) {
+            ValueId value         = placed[i];
+            const SsaInstr& instr = (*function)[value];
+
+            if (instr.op == SsaOp::Const || instr.op == SsaOp::Address) {
+                kinds[value] = Kind::Rematerialized;
+            } else if (instr.op == SsaOp::Load) {
+                auto readsSameWord = [&](ValueId user) {
+                    const SsaInstr& use = (*function)[user];
+                    if (use.op == SsaOp::Phi || use.block != block) {
+                        return false;
+                    }
+                    for (uint32_t j = position[value] + 1; j < position[user]; j++) {
+                        if (kills((*function)[placed[j]], instr)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                };
+                if (std::all_of(users[value].begin(), users[value].end(), readsSameWord)) {
+                    kinds[value] = Kind::Folded;
+                }
+            } else if (instr.op == SsaOp::Compare && useCounts[value] == 1 &&
+                       i + 1 < placed.size() && placed[i + 1] == users[value][0] &&
+                       (*function)[placed[i + 1]].op == SsaOp::Branch) {
+                kinds[value] = Kind::Fused;
+            }
+        }
+    }
+
+    // Rematerialized and folded values cost nothing where they are defined, so whatever was
+    // computed before them is still in the accumulator.
+    auto emitsCode = [this](ValueId value) {
+        return kinds[value] != Kind::Rematerialized && kinds[value] != Kind::Folded;
+    };
+
+    for (BlockId block = 0; block < function->blocks.size(); block++) {
+        const std::vector<ValueId>& placed = order[block];
+        ValueId previous                   = NO_VALUE;
+        for (ValueId value : placed) {
+            const SsaInstr& instr = (*function)[value];
+            slots[value]          = naturalSlot(instr);
+            if (slots[value] == 0 && swappable(instr.op) && instr.args[1] == previous &&
+                instr.args[0] != previous) {
+                slots[value] = 1;
+            }
+            if (emitsCode(value)) {
+                previous = value;
+            }
+        }
+
+        for (size_t i = 0; i < placed.size(); i++) {
+            ValueId value         = placed[i];
+            const SsaInstr& instr = (*function)[value];
+            if (kinds[value] != Kind::Cell || instr.op == SsaOp::Phi ||
+                !definesValue(instr.op) || useCounts[value] != 1) {
+                continue;
+            }
+            size_t next = i + 1;
+            while (next < placed.size() && !emitsCode(placed[next])) {
+                next++;
+            }
+            ValueId user = users[value][0];
+            if (next < placed.size() && placed[next] == user && slots[user] >= 0 &&
+                (*function)[user].args[slots[user]] == value) {
+                kinds[value] = Kind::Accumulator;
+            }
+        }
+    }
+}
+
+// Phis share a cell with the arguments whose live ranges do not overlap theirs; two values
+// overlap when one is live where the other is defined.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void SsaLowering::assignCells() {
+    std::vector<std::set<ValueId>> out = liveOut();
+    std::vector<std::vector<ValueId>> interferences(function->values.size());
+    auto interfere = [&](ValueId left, ValueId right) {
+        interferences[left].push_back(right);
+        interferences[right].push_back(left);
+    };
+
+    for (BlockId block = 0; block < function->blocks.size(); block++) {
+        std::set<ValueId> live = out[block];
+        std::vector<ValueId> phis;
+        for (auto it = order[block].rbegin(); it != order[block].rend(); ++it) {
+            const SsaInstr& instr = (*function)[*it];
+            if (instr.op == SsaOp::Phi) {
+                phis.push_back(*it);
+                continue;
+            }
+            if (kinds[*it] == Kind::Cell && definesValue(instr.op) && useCounts[*it] != 0) {
+                live.erase(*it);
+                for (ValueId other : live) {
+                    interfere(*it, other);
+                }
+            }
+            for (ValueId arg : instr.args) {
+                if (kinds[arg] == Kind::Cell) {
+                    live.insert(arg);
+                }
+            }
+        }
+        for (ValueId phi : phis) {
+            live.erase(phi);
+        }
+        for (size_t i = 0; i < phis.size(); i++) {
+            for (ValueId other : live) {
+                interfere(phis[i], other);
+            }
+            for (size_t j = i + 1; j < phis.size(); j++) {
+                interfere(phis[i], phis[j]);
+            }
+        }
+    }
+
+    classes.resize(function->values.size());
+    std::vector<std::vector<ValueId>> members(function->values.size());
+    for (ValueId value = 0; value < function->values.size(); value++) {
+        classes[value] = value;
+        members[value] = {value};
+    }
+    auto overlap = [&](ValueId left, ValueId right) {
+        return std::any_of(members[left].begin(), members[left].end(), [&](ValueId member) {
+            return std::any_of(interferences[member].begin(), interferences[member].end(),
+                               [&](ValueId other) { return find(other) == right; });
+        });
+    };
+
+    for (BlockId block : function->layout) {
+        for (ValueId phi : order[block]) {
+            if ((*function)[phi].op != SsaOp::Phi) {
+                break;
+            }
+            for (ValueId arg : (*function)[phi].args) {
+                ValueId left  = find(phi);
+                ValueId right = find(arg);
+                if (kinds[arg] != Kind::Cell || left == right || overlap(left, right)) {
+                    continue;
+                }
+                classes[right] = left;
+                members[left].insert(members[left].end(), members[right].begin(),
+                                     members[right].end());
+            }
+        }
+    }
+
+    cells.assign(function->values.size(), NO_SYMBOL);
+    for (ValueId value = 0; value < function->values.size(); value++) {
+        const SsaInstr& instr = (*function)[value];
+        if (instr.removed || kinds[value] != Kind::Cell || !definesValue(instr.op) ||
+            cells[find(value)] != NO_SYMBOL) {
+            continue;
+        }
+        LabelId label = program.label(function->name + "_v" + std::to_string(find(value)));
+        program.data.push_back({label, {Operand::immediate(0)}});
+        cells[find(value)] = label;
+    }
+}
+
+// Values kept in cells that are live at the end of each block; a phi argument is live at the
+// end of its predecessor only.
+std::vector<std::set<ValueId>> SsaLowering::liveOut() const {
+    std::vector<std::set<ValueId>> in(function->blocks.size());
+    std::vector<std::set<ValueId>> out(function->blocks.size());
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto block = function->layout.rbegin(); block != function->layout.rend(); ++block) {
+            std::set<ValueId> live;
+            for (BlockId successor : function->blocks[*block].successors) {
+                live.insert(in[successor].begin(), in[successor].end());
+
+                const std::vector<BlockId>& predecessors =
+                    function->blocks[successor].predecessors;
+                size_t index = std::find(predecessors.begin(), predecessors.end(), *block) -
+                               predecessors.begin();
+                for (ValueId phi : order[successor]) {
+                    if ((*function)[phi].op != SsaOp::Phi) {
+                        break;
+                    }
+                    ValueId arg = (*function)[phi].args[index];
+                    if (kinds[arg] == Kind::Cell) {
+                        live.insert(arg);
+                    }
+                }
+            }
+            if (live != out[*block]) {
+                out[*block] = live;
+                changed     = true;
+            }
+
+            for (auto it = order[*block].rbegin(); it != order[*block].rend(); ++it) {
+                live.erase(*it);
+                if ((*function)[*it].op == SsaOp::Phi) {
+                    continue;
+                }
+                for (ValueId arg : (*function)[*it].args) {
+                    if (kinds[arg] == Kind::Cell) {
+                        live.insert(arg);
+                    }
+                }
+            }
+            in[*block] = std::move(live);
+        }
+    }
+    return out;
+}
+
+// Copies into the phis of the block's only successor that the two do not already share a
+// cell for.
+std::vector<SsaLowering::Copy> SsaLowering::edgeCopies(BlockId block) const {
+    std::vector<Copy> copies;
+    const SsaBlock& data = function->blocks[block];
+    if (data.successors.size() != 1) {
+        return copies;
+    }
+
+    BlockId successor                        = data.successors[0];
+    const std::vector<BlockId>& predecessors = function->blocks[successor].predecessors;
+    size_t index                             =
+        std::find(predecessors.begin(), predecessors.end(), block) - predecessors.begin();
+    for (ValueId phi : order[successor]) {
+        if ((*function)[phi].op != SsaOp::Phi) {
+            break;
+        }
+        ValueId arg = (*function)[phi].args[index];
+        if (kinds[arg] == Kind::Cell && find(arg) == find(phi)) {
+            continue;
+        }
+        copies.push_back({arg, kinds[arg] == Kind::Cell ? cell(arg) : NO_SYMBOL, cell(phi)});
+    }
+    return copies;
+}
+
+BlockId SsaLowering::resolve(BlockId block) const {
+    while (forwarders[block]) {
+        block = function->blocks[block].successors[0];
+    }
+    return block;
+}
+
+void SsaLowering::emitBlock(BlockId block, BlockId next) {
+    code->push_back(TextItem::labelAt(blockLabel(block)));
+    accumulator = NO_VALUE;
+    flags       = NO_VALUE;
+    for (ValueId value : order[block]) {
+        emitInstruction(value, next);
+    }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void SsaLowering::emitInstruction(ValueId value, BlockId next) {
+    const SsaInstr& instr = (*function)[value];
+    if (kinds[value] == Kind::Rematerialized || kinds[value] == Kind::Folded ||
+        kinds[value] == Kind::Fused) {
+        return;
+    }
+
+    switch (instr.op) {
+        case SsaOp::Param:
+            emit(Opcode::Lds, Operand::immediate(1 + function->parameterCount - instr.bits));
+            produced(value);
+            break;
+        case SsaOp::Copy:
+            load(instr.args[0]);
+            produced(value);
+            break;
+        case SsaOp::Phi:
+            break;
+        case SsaOp::Load:
+            emit(Opcode::Ld, Operand::label(program.label(instr.label)));
+            produced(value);
+            break;
+        case SsaOp::Store:
+            load(instr.args[0]);
+            emit(Opcode::St, Operand::label(program.label(instr.label)));
+            break;
+        case SsaOp::Size:
+            emit(Opcode::Lda, memory(instr.args[0]));
+            produced(value);
+            break;
+        case SsaOp::LoadElement:
+            load(instr.args[1]);
+            emit(Opcode::Ldx, memory(instr.args[0]));
+            produced(value);
+            break;
+        case SsaOp::StoreElement:
+            // The value waits in XR while the index is loaded.
+            load(instr.args[2]);
+            emit(Opcode::Tax);
+            load(instr.args[1]);
+            emit(Opcode::Stx, memory(instr.args[0]));
+            break;
+        case SsaOp::Neg:
+            load(instr.args[0]);
+            emit(Opcode::Not);
+            emit(Opcode::Inc);
+            produced(value);
+            break;
+        case SsaOp::Compare: {
+            // 1 or 0 by whether the jump is taken; both ldi set the flags from the result.
+            LabelId taken = program.label(function->name + "_c" + std::to_string(compareLabels++));
+            LabelId done  = program.label(function->name + "_c" + std::to_string(compareLabels++));
+            emit(emitCompare(value), Operand::label(taken));
+            emit(Opcode::Ldi, Operand::immediate(0));
+            emit(Opcode::Jmp, Operand::label(done));
+            code->push_back(TextItem::labelAt(taken));
+            emit(Opcode::Ldi, Operand::immediate(1));
+            code->push_back(TextItem::labelAt(done));
+            produced(value);
+            break;
+        }
+        case SsaOp::Call: {
+            for (ValueId arg : instr.args) {
+                load(arg);
+                emit(Opcode::Push);
+            }
+            emit(Opcode::Call, Operand::label(program.label(instr.label)));
+            if (!instr.args.empty()) {
+                emit(Opcode::Adsp, Operand::immediate(instr.args.size()));
+            }
+            produced(value, false);
+            break;
+        }
+        case SsaOp::RuntimeCall:
+            if (!instr.args.empty()) {
+                load(instr.args[0]);
+            }
+            emit(Opcode::Call, Operand::label(program.label(instr.label)));
+            produced(value, false);
+            break;
+        case SsaOp::Jump: {
+            emitCopies(instr.block);
+            BlockId target = resolve(function->blocks[instr.block].successors[0]);
+            if (target != next) {
+                emit(Opcode::Jmp, Operand::label(blockLabel(target)));
+            }
+            break;
+        }
+        case SsaOp::Branch:
+            emitBranch(value, next);
+            break;
+        case SsaOp::Return:
+            if (!instr.args.empty()) {
+                load(instr.args[0]);
+            }
+            emit(Opcode::Ret);
+            break;
+        case SsaOp::Halt:
+            emit(Opcode::Halt);
+            break;
+        default:
+            emitArithmetic(value);
+            break;
+    }
+}
+
+// Adding or subtracting 1 is inc or dec. Multiplying by 2^k is a left shift for either
+// signedness; div and rem are unsigned on this machine, so dividing by 2^k is a logical right
+// shift and the remainder is the low k bits.
+void SsaLowering::emitArithmetic(ValueId value) {
+    const SsaInstr& instr = (*function)[value];
+    int slot              = slots[value];
+    ValueId other         = instr.args[1 - slot];
+    const SsaInstr& right = (*function)[other];
+    load(instr.args[slot]);
+
+    std::optional<uint32_t> exponent = powerOfTwoExponent(right);
+    bool isOne                       = right.op == SsaOp::Const && right.bits == 1;
+    if (instr.op == SsaOp::Add && isOne) {
+        emit(Opcode::Inc);
+    } else if (instr.op == SsaOp::Sub && isOne) {
+        emit(Opcode::Dec);
+    } else if (instr.op == SsaOp::Mul && exponent) {
+        emit(Opcode::Shl, program.constant(*exponent));
+    } else if (instr.op == SsaOp::Div && exponent) {
+        emit(Opcode::Shr, program.constant(*exponent));
+    } else if (instr.op == SsaOp::Rem && exponent) {
+        emit(Opcode::And, program.constant(right.bits - 1));
+    } else {
+        emit(aluOpcode(instr.op), memory(other));
+    }
+    produced(value);
+}
+
+// Sets the flags for the comparison and returns the jump taken when it holds.
+Opcode SsaLowering::emitCompare(ValueId value) {
+    const SsaInstr& instr = (*function)[value];
+    int slot              = slots[value];
+    load(instr.args[slot]);
+    emit(Opcode::Cmp, memory(instr.args[1 - slot]));
+    return slot == 0 ? instr.jump : swappedJump(instr.jump);
+}
+
+void SsaLowering::emitBranch(ValueId value, BlockId next) {
+    const SsaInstr& instr = (*function)[value];
+    ValueId condition     = instr.args[0];
+
+    Opcode jump = Opcode::Jnz;
+    if (kinds[condition] == Kind::Fused) {
+        jump = emitCompare(condition);
+    } else {
+        load(condition);
+        if (flags != condition) {
+            emit(Opcode::Cmp, program.constant(0));
+        }
+    }
+
+    const std::vector<BlockId>& successors = function->blocks[instr.block].successors;
+    BlockId taken                          = resolve(successors[0]);
+    BlockId notTaken                       = resolve(successors[1]);
+    if (taken == notTaken) {
+        if (taken != next) {
+            emit(Opcode::Jmp, Operand::label(blockLabel(taken)));
+        }
+    } else if (taken == next) {
+        emit(invertedJump(jump), Operand::label(blockLabel(notTaken)));
+    } else {
+        emit(jump, Operand::label(blockLabel(taken)));
+        if (notTaken != next) {
+            emit(Opcode::Jmp, Operand::label(blockLabel(notTaken)));
+        }
+    }
+}
+
+// The copies act at once: a cell is overwritten only after every copy reading it is done, and a
+// cycle of copies is broken by saving one cell in temp_right.
+void SsaLowering::emitCopies(BlockId block) {
+    std::vector<Copy> pending = edgeCopies(block);
+    LabelId scratch           = program.label("temp_right");
+
+    while (!pending.empty()) {
+        auto ready = std::find_if(pending.begin(), pending.end(), [&](const Copy& copy) {
+            return std::none_of(pending.begin(), pending.end(), [&](const Copy& other) {
+                return &other != &copy && other.source == copy.target;
+            });
+        });
+
+        if (ready == pending.end()) {
+            LabelId saved = pending.front().target;
+            emit(Opcode::Ld, Operand::label(saved));
+            emit(Opcode::St, Operand::label(scratch));
+            for (Copy& copy : pending) {
+                if (copy.source == saved) {
+                    copy.source = scratch;
+                }
+            }
+            continue;
+        }
+
+        if (ready->source != NO_SYMBOL) {
+            emit(Opcode::Ld, Operand::label(ready->source));
+        } else {
+            accumulator = NO_VALUE;
+            load(ready->value);
+        }
+        emit(Opcode::St, Operand::label(ready->target));
+        pending.erase(ready);
+    }
+    accumulator = NO_VALUE;
+}
+
+void SsaLowering::emit(Opcode opcode, Operand operand) {
+    code->push_back(TextItem::instruction(opcode, operand));
+    if (writesFlags(opcode) || opcode == Opcode::Call) {
+        flags = NO_VALUE;
+    }
+}
+
+// The value has just been computed into the accumulator.
+void SsaLowering::produced(ValueId value, bool setsFlags) {
+    accumulator = value;
+    if (setsFlags) {
+        flags = value;
+    }
+    if (kinds[value] == Kind::Cell && useCounts[value] != 0) {
+        emit(Opcode::St, Operand::label(cell(value)));
+    }
+}
+
+void SsaLowering::load(ValueId value) {
+    if (accumulator == value) {
+        return;
+    }
+
+    const SsaInstr& instr = (*function)[value];
+    switch (kinds[value]) {
+        case Kind::Rematerialized:
+            if (instr.op == SsaOp::Address) {
+                emit(Opcode::Ldi, Operand::label(program.label(instr.label)));
+            } else if (instr.bits > FULL_MASK_24) {
+                emit(Opcode::Ld, program.constant(instr.bits));
+            } else {
+                emit(Opcode::Ldi, Operand::immediate(instr.bits));
+            }
+            break;
+        case Kind::Folded:
+            emit(Opcode::Ld, Operand::label(program.label(instr.label)));
+            break;
+        case Kind::Cell:
+            emit(Opcode::Ld, Operand::label(cell(value)));
+            break;
+        default:
+            throw std::logic_error("value v" + std::to_string(value) + " is not in memory");
+    }
+    accumulator = value;
+    flags       = value;
+}
+
+Operand SsaLowering::memory(ValueId value) {
+    const SsaInstr& instr = (*function)[value];
+    switch (kinds[value]) {
+        case Kind::Rematerialized: {
+            if (instr.op == SsaOp::Const) {
+                return program.constant(instr.bits);
+            }
+            // A word holding the address, for ldx and the like.
+            std::string name = "addr_" + instr.label;
+            LabelId label    = program.findLabel(name);
+            if (label == NO_SYMBOL) {
+                label = program.label(name);
+                program.data.push_back({label, {Operand::label(program.label(instr.label))}});
+            }
+            return Operand::label(label);
+        }
+        case Kind::Folded:
+            return Operand::label(program.label(instr.label));
+        case Kind::Cell:
+            return Operand::label(cell(value));
+        default:
+            throw std::logic_error("value v" + std::to_string(value) + " is not in memory");
+    }
+}
+
+ValueId SsaLowering::find(ValueId value) const {
+    while (classes[value] != value) {
+        value = classes[value];
+    }
+    return value;
+}
+
+LabelId SsaLowering::cell(ValueId value) const {
+    return cells[find(value)];
+}
+
+LabelId SsaLowering::blockLabel(BlockId block) {
+    return program.label(function->name + "_b" + std::to_string(block));
+}
@@ -0,0 +1,94 @@
+#ifndef _SSA_LOWERING_H
+#define _SSA_LOWERING_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "asmIR.h"
+#include "ssaIR.h"
+
+// Turns an SSA function into accumulator code. Each block is first rescheduled so that a value
+// used once is computed right before its user, and then every value gets the cheapest home its
+// uses allow:
+//  - constants and addresses are reloaded with ldi (or read from const_N) wherever they are used;
+//  - a load whose uses all follow it in the block, with nothing in between that may change the
+//    cell, is not emitted at all: its users read the var_ cell directly;
+//  - a comparison that only decides the branch right after it sets the flags for that branch;
+//  - a value whose only user is the next instruction and wants it in the accumulator stays
+//    there;
+//  - anything else is stored to a static cell of its own, shared with the phis it flows into
+//    when their live ranges do not overlap. The remaining phi arguments are copied at the end of
+//    the predecessor, which critical edges get split for.
+// Functions lowered this way must not be re-entered while running, since their cells are
+// static.
+class SsaLowering {
+public:
+    explicit SsaLowering(AsmProgram& program) : program(program) {
+    }
+
+    // Appends the function's code to out, starting with its name as a label.
+    void lower(SsaFunction& function, std::vector<TextItem>& out);
+
+private:
+    enum class Kind : uint8_t {
+        Rematerialized,
+        Folded,
+        Fused,
+        Accumulator,
+        Cell,
+    };
+
+    // Source and destination of a phi copy; source is a cell, or NO_SYMBOL for a constant.
+    struct Copy {
+        ValueId value;
+        LabelId source;
+        LabelId target;
+    };
+
+    void splitCriticalEdges();
+    void schedule();
+    void place(ValueId value, std::vector<ValueId>& order, std::vector<bool>& sunk);
+    [[nodiscard]] bool sinkable(ValueId value, const std::vector<uint32_t>& position) const;
+    void classify();
+    void assignCells();
+    [[nodiscard]] std::vector<std::set<ValueId>> liveOut() const;
+    [[nodiscard]] std::vector<Copy> edgeCopies(BlockId block) const;
+    [[nodiscard]] BlockId resolve(BlockId block) const;
+
+    void emitBlock(BlockId block, BlockId next);
+    void emitInstruction(ValueId value, BlockId next);
+    void emitArithmetic(ValueId value);
+    Opcode emitCompare(ValueId value);
+    void emitBranch(ValueId value, BlockId next);
+    void emitCopies(BlockId block);
+    void emit(Opcode opcode, Operand operand = {});
+    void produced(ValueId value, bool setsFlags = true);
+
+    // Brings the value into the accumulator.
+    void load(ValueId value);
+    // Word holding the value, as the operand of a memory instruction.
+    Operand memory(ValueId value);
+    [[nodiscard]] ValueId find(ValueId value) const;
+    LabelId cell(ValueId value) const;
+    LabelId blockLabel(BlockId block);
+
+    AsmProgram& program;
+    SsaFunction* function = nullptr;
+
+    std::vector<std::vector<ValueId>> order;  // per block, as scheduled
+    std::vector<uint32_t> useCounts;
+    std::vector<std::vector<ValueId>> users;
+    std::vector<Kind> kinds;
+    std::vector<int> slots;        // argument computed in the accumulator, or -1
+    std::vector<ValueId> classes;  // union-find over values that share a cell
+    std::vector<LabelId> cells;    // by class
+    std::vector<bool> forwarders;  // blocks that only jump on
+
+    std::vector<TextItem>* code = nullptr;
+    ValueId accumulator         = NO_VALUE;
+    ValueId flags               = NO_VALUE;
+    uint32_t compareLabels      = 0;
+};
+
+#endif
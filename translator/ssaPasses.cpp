@@ -0,0 +1,493 @@
+#include "ssaPasses.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::string_view COPY_PROPAGATION = "copy-propagation";
+constexpr std::string_view COMMON_SUBEXPR   = "common-subexpr";
+constexpr std::string_view DEAD_CODE        = "dead-code";
+
+// Everything a pure instruction's value depends on.
+using Expression = std::tuple<SsaOp, uint32_t, Opcode, std::string, std::vector<ValueId>>;
+
+Expression expressionOf(const SsaInstr& instr) {
+    std::vector<ValueId> args = instr.args;
+    if (isCommutative(instr.op)) {
+        std::sort(args.begin(), args.end());
+    }
+    return {instr.op, instr.bits, instr.jump, instr.label, std::move(args)};
+}
+
+// Memory the block has seen so far: the value each var_ cell and array element holds, and the
+// stores nothing has read yet.
+struct KnownMemory {
+    std::unordered_map<std::string, ValueId> cells;
+    std::map<std::pair<ValueId, ValueId>, ValueId> elements;
+    std::unordered_map<std::string, ValueId> unreadStores;
+};
+
+std::vector<std::vector<BlockId>> dominatorTree(const SsaFunction& function) {
+    std::vector<BlockId> dominators = function.immediateDominators();
+    std::vector<std::vector<BlockId>> children(function.blocks.size());
+    for (BlockId block = 1; block < dominators.size(); block++) {
+        if (dominators[block] != NO_BLOCK) {
+            children[dominators[block]].push_back(block);
+        }
+    }
+    return children;
+}
+
+}  // namespace
+
+size_t propagateCopies(SsaFunction& function) {
+    std::vector<ValueId> replacement(function.values.size(), NO_VALUE);
+    auto resolve = [&replacement](ValueId value) {
+        while (replacement[value] != NO_VALUE) {
+            value = replacement[value];
+        }
+        return value;
+    };
+
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        const SsaInstr& instr = function[value];
+        if (!instr.removed && instr.op == SsaOp::Copy) {
+            replacement[value] = instr.args[0];
+        }
+    }
+
+    // Replacing one phi can make another trivial, around a loop in particular.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (ValueId value = 0; value < function.values.size(); value++) {
+            const SsaInstr& instr = function[value];
+            if (instr.removed || instr.op != SsaOp::Phi || replacement[value] != NO_VALUE) {
+                continue;
+            }
+
+            ValueId same = NO_VALUE;
+            bool trivial = true;
+            for (ValueId arg : instr.args) {
+                arg = resolve(arg);
+                if (arg == value || arg == same) {
+                    continue;
+                }
+                trivial = same == NO_VALUE;
+                same    = arg;
+                if (!trivial) {
+                    break;
+                }
+            }
+            if (trivial && same != NO_VALUE) {
+                replacement[value] = same;
+                changed            = true;
+            }
+        }
+    }
+
+    size_t changes = 0;
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        if (replacement[value] != NO_VALUE) {
+            function.remove(value);
+            changes++;
+        }
+    }
+    if (changes != 0) {
+        for (SsaInstr& instr : function.values) {
+            std::transform(instr.args.begin(), instr.args.end(), instr.args.begin(), resolve);
+        }
+    }
+    return changes;
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+size_t eliminateCommonSubexpressions(SsaFunction& function) {
+    std::vector<std::vector<BlockId>> children = dominatorTree(function);
+    std::vector<ValueId> replacement(function.values.size(), NO_VALUE);
+    std::vector<ValueId> deadStores;
+
+    // Pure instructions of the dominating blocks; each block undoes its own entries on the way
+    // back up the tree.
+    std::map<Expression, ValueId> available;
+
+    // Blocks on the path from the entry, each with the next child to visit and its entries.
+    struct Scope {
+        BlockId block;
+        size_t child;
+        std::vector<std::map<Expression, ValueId>::iterator> added;
+    };
+    std::vector<Scope> path;
+
+    auto enter = [&](BlockId block) {
+        std::vector<std::map<Expression, ValueId>::iterator> added;
+        KnownMemory memory;
+
+        for (ValueId value : function.blocks[block].code) {
+            SsaInstr& instr = function[value];
+            for (ValueId& arg : instr.args) {
+                if (replacement[arg] != NO_VALUE) {
+                    arg = replacement[arg];
+                }
+            }
+
+            if (isPure(instr.op)) {
+                auto [position, inserted] = available.emplace(expressionOf(instr), value);
+                if (inserted) {
+                    added.push_back(position);
+                } else {
+                    replacement[value] = position->second;
+                }
+                continue;
+            }
+
+            switch (instr.op) {
+                case SsaOp::Load: {
+                    auto known = memory.cells.find(instr.label);
+                    if (known != memory.cells.end()) {
+                        replacement[value] = known->second;
+                    } else {
+                        memory.cells[instr.label] = value;
+                    }
+                    memory.unreadStores.erase(instr.label);
+                    break;
+                }
+                case SsaOp::Store: {
+                    auto unread = memory.unreadStores.find(instr.label);
+                    if (unread != memory.unreadStores.end()) {
+                        deadStores.push_back(unread->second);
+                    }
+                    memory.unreadStores[instr.label] = value;
+                    memory.cells[instr.label]        = instr.args[0];
+                    break;
+                }
+                case SsaOp::LoadElement: {
+                    std::pair<ValueId, ValueId> element{instr.args[0], instr.args[1]};
+                    auto known = memory.elements.find(element);
+                    if (known != memory.elements.end()) {
+                        replacement[value] = known->second;
+                    } else {
+                        memory.elements[element] = value;
+                    }
+                    break;
+                }
+                case SsaOp::StoreElement:
+                    // Another array value may point at the same words.
+                    memory.elements.clear();
+                    memory.elements[{instr.args[0], instr.args[1]}] = instr.args[2];
+                    break;
+                case SsaOp::Call:
+                    // The callee may read and write any global and any array.
+                    memory = KnownMemory();
+                    break;
+                case SsaOp::RuntimeCall:
+                    // Runtime routines keep to their own cells and to input words no array
+                    // holds yet, but read input_count.
+                    memory.unreadStores.clear();
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        path.push_back({block, 0, std::move(added)});
+    };
+    enter(0);
+    while (!path.empty()) {
+        Scope& scope = path.back();
+        if (scope.child < children[scope.block].size()) {
+            enter(children[scope.block][scope.child++]);
+            continue;
+        }
+        for (auto position : scope.added) {
+            available.erase(position);
+        }
+        path.pop_back();
+    }
+
+    size_t changes = deadStores.size();
+    for (ValueId store : deadStores) {
+        function.remove(store);
+    }
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        if (replacement[value] != NO_VALUE) {
+            function.remove(value);
+            changes++;
+        }
+    }
+    // Phis may read a replaced value along a back edge, which the walk above reached first.
+    if (changes != 0) {
+        for (SsaInstr& instr : function.values) {
+            for (ValueId& arg : instr.args) {
+                while (replacement[arg] != NO_VALUE) {
+                    arg = replacement[arg];
+                }
+            }
+        }
+    }
+    return changes;
+}
+
+size_t eliminateDeadCode(SsaFunction& function) {
+    size_t changes = 0;
+
+    for (SsaBlock& block : function.blocks) {
+        if (block.code.empty() || function[block.code.back()].op != SsaOp::Branch) {
+            continue;
+        }
+        SsaInstr& branch          = function[block.code.back()];
+        const SsaInstr& condition = function[branch.args[0]];
+        if (condition.op != SsaOp::Const) {
+            continue;
+        }
+        BlockId from     = branch.block;
+        BlockId notTaken = block.successors[condition.bits != 0 ? 1 : 0];
+        branch.op        = SsaOp::Jump;
+        branch.args.clear();
+        function.removeEdge(from, notTaken);
+        changes++;
+    }
+
+    std::vector<bool> reachable(function.blocks.size(), false);
+    for (BlockId block : function.reversePostorder()) {
+        reachable[block] = true;
+    }
+    for (BlockId block = 0; block < function.blocks.size(); block++) {
+        if (reachable[block]) {
+            continue;
+        }
+        std::vector<BlockId> successors = function.blocks[block].successors;
+        for (BlockId successor : successors) {
+            function.removeEdge(block, successor);
+        }
+        std::vector<ValueId> code = function.blocks[block].code;
+        for (ValueId value : code) {
+            function.remove(value);
+        }
+        changes += code.size();
+    }
+
+    std::vector<bool> live(function.values.size(), false);
+    std::vector<ValueId> pending;
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        if (!function[value].removed && hasSideEffects(function[value].op)) {
+            live[value] = true;
+            pending.push_back(value);
+        }
+    }
+    while (!pending.empty()) {
+        ValueId value = pending.back();
+        pending.pop_back();
+        for (ValueId arg : function[value].args) {
+            if (!live[arg]) {
+                live[arg] = true;
+                pending.push_back(arg);
+            }
+        }
+    }
+
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        if (!function[value].removed && !live[value]) {
+            function.remove(value);
+            changes++;
+        }
+    }
+    return changes;
+}
+
+namespace {
+
+// Moves everything after the value in its block to a new block, which takes over the block's
+// successors.
+BlockId splitAfter(SsaFunction& function, ValueId value) {
+    BlockId block = function[value].block;
+    BlockId rest  = function.addBlock();
+
+    std::vector<ValueId>& code = function.blocks[block].code;
+    auto tail                  = std::find(code.begin(), code.end(), value) + 1;
+    std::vector<ValueId> moved(tail, code.end());
+    code.erase(tail, code.end());
+    for (ValueId other : moved) {
+        function[other].block = rest;
+    }
+    function.blocks[rest].code = std::move(moved);
+
+    // Successors keep their predecessor order, which their phis depend on.
+    function.blocks[rest].successors = std::move(function.blocks[block].successors);
+    function.blocks[block].successors.clear();
+    for (BlockId successor : function.blocks[rest].successors) {
+        std::vector<BlockId>& predecessors = function.blocks[successor].predecessors;
+        std::replace(predecessors.begin(), predecessors.end(), block, rest);
+    }
+    return rest;
+}
+
+// Calls are expanded from the last one back, so that splitting a block moves only what no
+// earlier call has moved already; uses and the layout are fixed up once at the end.
+class Inliner {
+public:
+    explicit Inliner(SsaFunction& function)
+        : function(function),
+          replacement(function.values.size(), NO_VALUE),
+          following(function.blocks.size()) {
+    }
+
+    void expand(ValueId call, const SsaFunction& callee);
+    void finish();
+
+private:
+    SsaFunction& function;
+    std::vector<ValueId> replacement;
+    // Blocks to lay out right after each original block.
+    std::vector<std::vector<BlockId>> following;
+};
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void Inliner::expand(ValueId call, const SsaFunction& callee) {
+    BlockId caller                 = function[call].block;
+    BlockId rest                   = splitAfter(function, call);
+    std::vector<ValueId> arguments = function[call].args;
+
+    std::vector<BlockId> blocks(callee.blocks.size(), NO_BLOCK);
+    std::vector<BlockId> layout;
+    for (BlockId block : callee.layout) {
+        if (!callee.blocks[block].code.empty()) {
+            blocks[block] = function.addBlock();
+            layout.push_back(blocks[block]);
+        }
+    }
+    layout.push_back(rest);
+    following[caller].insert(following[caller].begin(), layout.begin(), layout.end());
+
+    // Values are numbered first, since a phi may read one defined further down.
+    std::vector<ValueId> values(callee.values.size(), NO_VALUE);
+    auto next = static_cast<ValueId>(function.values.size());
+    for (BlockId block : callee.layout) {
+        for (ValueId value : callee.blocks[block].code) {
+            const SsaInstr& instr = callee[value];
+            values[value]         = instr.op == SsaOp::Param ? arguments[instr.bits] : next++;
+        }
+    }
+
+    std::vector<BlockId> returns;
+    std::vector<ValueId> returned;
+    for (BlockId block : callee.layout) {
+        if (blocks[block] == NO_BLOCK) {
+            continue;
+        }
+        for (ValueId value : callee.blocks[block].code) {
+            SsaInstr instr = callee[value];
+            if (instr.op == SsaOp::Param) {
+                continue;
+            }
+            for (ValueId& arg : instr.args) {
+                arg = values[arg];
+            }
+            if (instr.op == SsaOp::Return) {
+                returns.push_back(blocks[block]);
+                if (!instr.args.empty()) {
+                    returned.push_back(instr.args[0]);
+                }
+                instr = {SsaOp::Jump};
+            }
+            function.append(blocks[block], std::move(instr));
+        }
+
+        SsaBlock& copy = function.blocks[blocks[block]];
+        for (BlockId predecessor : callee.blocks[block].predecessors) {
+            copy.predecessors.push_back(blocks[predecessor]);
+        }
+        for (BlockId successor : callee.blocks[block].successors) {
+            copy.successors.push_back(blocks[successor]);
+        }
+    }
+
+    function.append(caller, {SsaOp::Jump});
+    function.addEdge(caller, blocks[0]);
+    for (BlockId block : returns) {
+        function.addEdge(block, rest);
+    }
+
+    if (returned.size() == 1) {
+        replacement[call] = returned[0];
+    } else if (!returned.empty()) {
+        replacement[call] = function.append(rest, {SsaOp::Phi, 0, returned});
+    }
+    function.remove(call);
+}
+
+void Inliner::finish() {
+    for (SsaInstr& instr : function.values) {
+        for (ValueId& arg : instr.args) {
+            // A callee returning its parameter hands back another call's result.
+            while (arg < replacement.size() && replacement[arg] != NO_VALUE) {
+                arg = replacement[arg];
+            }
+        }
+    }
+
+    std::vector<BlockId> layout;
+    for (BlockId block : function.layout) {
+        layout.push_back(block);
+        layout.insert(layout.end(), following[block].begin(), following[block].end());
+    }
+    function.layout = std::move(layout);
+}
+
+}  // namespace
+
+size_t inlineCalls(SsaFunction& function,
+                   const std::function<const SsaFunction*(const std::string&)>& callee) {
+    std::vector<ValueId> calls;
+    for (ValueId value = 0; value < function.values.size(); value++) {
+        const SsaInstr& instr = function[value];
+        if (!instr.removed && instr.op == SsaOp::Call && callee(instr.label) != nullptr) {
+            calls.push_back(value);
+        }
+    }
+    if (calls.empty()) {
+        return 0;
+    }
+
+    Inliner inliner(function);
+    for (auto call = calls.rbegin(); call != calls.rend(); call++) {
+        inliner.expand(*call, *callee(function[*call].label));
+    }
+    inliner.finish();
+    return calls.size();
+}
+
+SsaPassManager::SsaPassManager() {
+    add(COPY_PROPAGATION, propagateCopies);
+    add(COMMON_SUBEXPR, eliminateCommonSubexpressions);
+    add(DEAD_CODE, eliminateDeadCode);
+}
+
+void SsaPassManager::add(std::string_view name, Pass pass) {
+    passes.push_back({name, pass, 0});
+}
+
+void SsaPassManager::run(SsaFunction& function) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (Entry& entry : passes) {
+            size_t changes = entry.pass(function);
+            entry.changes += changes;
+            if (changes != 0) {
+                changed = true;
+            }
+        }
+    }
+}
+
+void SsaPassManager::report(std::ostream& out) const {
+    for (const Entry& entry : passes) {
+        out << "  " << std::left << std::setw(18) << entry.name << entry.changes << "\n";
+    }
+}
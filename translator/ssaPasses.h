@@ -0,0 +1,58 @@
+#ifndef _SSA_PASSES_H
+#define _SSA_PASSES_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ssaIR.h"
+
+// Each pass rewrites the function in place and returns how many instructions it removed or
+// redirected; 0 means it found nothing to do.
+
+// Uses of a copy read its source instead, and a phi whose arguments are all one value (or the
+// phi itself) is replaced by that value.
+size_t propagateCopies(SsaFunction& function);
+
+// A pure instruction equal to one in a dominating block is replaced by it. Loads are reused
+// only within their block and up to the next store or call that may change what they read; a
+// load of a cell just stored to takes the stored value.
+size_t eliminateCommonSubexpressions(SsaFunction& function);
+
+// A branch on a constant becomes a jump, blocks the entry cannot reach are dropped, and so is
+// every instruction whose value nothing with a side effect needs.
+size_t eliminateDeadCode(SsaFunction& function);
+
+// Every call to a function that callee() returns a body for is replaced by a copy of that
+// body: its parameters read the call's arguments, and each return jumps to the rest of the
+// calling block, merging the returned values in a phi. The copies are not inlined into again.
+size_t inlineCalls(SsaFunction& function,
+                   const std::function<const SsaFunction*(const std::string&)>& callee);
+
+// Runs its passes in order until a whole round changes nothing, and counts the work of each
+// across every function it runs on.
+class SsaPassManager {
+public:
+    using Pass = size_t (*)(SsaFunction&);
+
+    // Copy propagation, common subexpressions, then dead code.
+    SsaPassManager();
+
+    void add(std::string_view name, Pass pass);
+    void run(SsaFunction& function);
+    void report(std::ostream& out) const;
+
+private:
+    struct Entry {
+        std::string_view name;
+        Pass pass;
+        size_t changes;
+    };
+
+    std::vector<Entry> passes;
+};
+
+#endif
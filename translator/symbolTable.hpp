@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "lexer.h"
+#include "types.hpp"
+
+// Scoped variable table keyed by interned name. All scopes share one binding stack; an
+// open-addressed hash maps each name to its innermost binding, and every binding remembers the
+// one it shadows. Leaving a scope pops its bindings back to the scope's marker, so blocks cost
+// no allocation once the vectors have grown.
+class SymbolTable {
+public:
+    SymbolTable() : slots(INITIAL_SLOTS) {
+    }
+
+    void enterScope() {
+        scopeMarks.push_back(static_cast<uint32_t>(bindings.size()));
+    }
+
+    void exitScope() {
+        uint32_t mark = scopeMarks.back();
+        scopeMarks.pop_back();
+
+        while (bindings.size() > mark) {
+            const Binding& binding        = bindings.back();
+            slots[binding.slot].innermost = binding.shadowed;
+            bindings.pop_back();
+        }
+    }
+
+    // Declaring a name twice in one scope rebinds it.
+    void declare(SymbolId symbol, TypeId type) {
+        uint32_t slot    = findSlot(symbol);
+        uint32_t current = slots[slot].innermost;
+
+        if (current != NONE && !scopeMarks.empty() && current >= scopeMarks.back()) {
+            bindings[current].type = type;
+            return;
+        }
+
+        bindings.push_back({type, slot, current});
+        slots[slot].innermost = static_cast<uint32_t>(bindings.size() - 1);
+    }
+
+    // TypeId::None when the name is not visible.
+    [[nodiscard]] TypeId lookup(SymbolId symbol) const {
+        uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+        for (uint32_t index = hash(symbol) & mask;; index = (index + 1) & mask) {
+            const Slot& slot = slots[index];
+            if (slot.symbol == symbol) {
+                return slot.innermost == NONE ? TypeId::None : bindings[slot.innermost].type;
+            }
+            if (slot.symbol == NO_SYMBOL) {
+                return TypeId::None;
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE        = UINT32_MAX;
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    struct Slot {
+        SymbolId symbol    = NO_SYMBOL;
+        uint32_t innermost = NONE;
+    };
+
+    struct Binding {
+        TypeId type;
+        uint32_t slot;
+        uint32_t shadowed;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Binding> bindings;
+    std::vector<uint32_t> scopeMarks;
+    size_t occupied = 0;
+
+    static uint32_t hash(SymbolId symbol) {
+        constexpr uint32_t FIBONACCI = 0x9E3779B9U;
+        return symbol * FIBONACCI;
+    }
+
+    // Slot of the name, claimed if the name has never been seen. Names are never removed, so
+    // probing needs no tombstones.
+    uint32_t findSlot(SymbolId symbol) {
+        if ((occupied + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+        for (uint32_t index = hash(symbol) & mask;; index = (index + 1) & mask) {
+            Slot& slot = slots[index];
+            if (slot.symbol == symbol) {
+                return index;
+            }
+            if (slot.symbol == NO_SYMBOL) {
+                slot.symbol = symbol;
+                occupied++;
+                return index;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(old.size() * 2, Slot{});
+
+        uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+        std::vector<uint32_t> moved(old.size(), NONE);
+
+        for (uint32_t from = 0; from < old.size(); from++) {
+            if (old[from].symbol == NO_SYMBOL) {
+                continue;
+            }
+            uint32_t index = hash(old[from].symbol) & mask;
+            while (slots[index].symbol != NO_SYMBOL) {
+                index = (index + 1) & mask;
+            }
+            slots[index] = old[from];
+            moved[from]  = index;
+        }
+
+        for (Binding& binding : bindings) {
+            binding.slot = moved[binding.slot];
+        }
+    }
+};
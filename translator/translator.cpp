@@ -4,12 +4,20 @@
 #include "ASTNode.hpp"
 #include "binarizer.h"
 #include "codeGenerator.h"
+#include "constantFolder.h"
 #include "semanticAnalyzer.h"
 #include "treeGen.h"
 
 struct Args {
-    bool isHighLevel = true;
+    bool isHighLevel   = true;
+    bool fold          = true;
+    bool peephole      = true;
+    bool peepholeStats = false;
+    bool ssa           = false;
+    size_t inlineLimit = 32;
     std::optional<std::string> vizFile;
+    std::optional<std::string> dumpAsmFile;
+    std::optional<std::string> dumpSsaFile;
     std::string inputFile;
     std::string outputFile;
 };
@@ -18,11 +26,14 @@ Args parseArgs(const std::vector<std::string>& argsVec) {
     size_t argc = argsVec.size();
 
     if (argc < 3) {
-        throw std::runtime_error("Usage: ./translator [--asm|--hl] [--viz file] <input> <output>");
+        throw std::runtime_error(
+            "Usage: ./translator [--asm|--hl] [--viz file] [--dump-asm file] [--no-fold] "
+            "[--no-peephole] [--peephole-stats] [--inline-limit n] [--ssa] [--dump-ssa file] "
+            "<input> <output>");
     }
 
     Args args;
-    int counter = 1;
+    size_t counter = 1;
 
     while (counter < argc - 2) {
         const std::string& flag = argsVec[counter];
@@ -33,12 +44,42 @@ Args parseArgs(const std::vector<std::string>& argsVec) {
         } else if (flag == "--hl") {
             args.isHighLevel = true;
             counter++;
+        } else if (flag == "--no-fold") {
+            args.fold = false;
+            counter++;
+        } else if (flag == "--no-peephole") {
+            args.peephole = false;
+            counter++;
+        } else if (flag == "--peephole-stats") {
+            args.peepholeStats = true;
+            counter++;
+        } else if (flag == "--ssa") {
+            args.ssa = true;
+            counter++;
         } else if (flag == "--viz") {
             if (counter + 1 >= argc - 2) {
                 throw std::runtime_error("--viz requires a filename");
             }
             args.vizFile = argsVec[counter + 1];
             counter += 2;
+        } else if (flag == "--inline-limit") {
+            if (counter + 1 >= argc - 2) {
+                throw std::runtime_error("--inline-limit requires a number");
+            }
+            args.inlineLimit = std::stoul(argsVec[counter + 1]);
+            counter += 2;
+        } else if (flag == "--dump-asm") {
+            if (counter + 1 >= argc - 2) {
+                throw std::runtime_error("--dump-asm requires a filename");
+            }
+            args.dumpAsmFile = argsVec[counter + 1];
+            counter += 2;
+        } else if (flag == "--dump-ssa") {
+            if (counter + 1 >= argc - 2) {
+                throw std::runtime_error("--dump-ssa requires a filename");
+            }
+            args.dumpSsaFile = argsVec[counter + 1];
+            counter += 2;
         } else {
             throw std::runtime_error("Unknown flag: " + flag);
         }
@@ -55,7 +96,7 @@ int main(int argc, char* argv[]) {
         const std::vector<std::string> argsVec(argv, argv + argc);
 
         Args args = parseArgs(argsVec);
-        std::string code;
+        AsmProgram program;
 
         if (args.isHighLevel) {
             std::ifstream file(args.inputFile);
@@ -64,12 +105,17 @@ int main(int argc, char* argv[]) {
             std::string data = buffer.str();
 
             TreeGenerator treeGenerator;
-            std::unique_ptr<ASTNode> tree = treeGenerator.makeTree(data);
+            std::unique_ptr<AST> tree = treeGenerator.makeTree(data);
 
             SemanticAnalyzer semanticAnalyzer;
-            semanticAnalyzer.analyze(tree.get());
+            semanticAnalyzer.analyze(tree->root);
             std::cout << "Semantic analyze success\n";
 
+            if (args.fold) {
+                ConstantFolder folder;
+                folder.optimize(*tree);
+            }
+
             if (args.vizFile) {
                 // TreeVisualizer treeViz;
                 // std::string uml = treeViz.makeUML(tree);
@@ -78,17 +124,43 @@ int main(int argc, char* argv[]) {
                 // std::cout << "PlantUML visualize saved to " << *args.vizFile << "\n";
             }
 
-            CodeGenerator codeGenerator;
-            code = codeGenerator.generateCode(tree.get());
+            PeepholeOptimizer peephole;
+            SsaPassManager ssaPasses;
+            std::ofstream ssaDump;
+            if (args.dumpSsaFile) {
+                ssaDump.open(*args.dumpSsaFile);
+            }
+            CodeGenerator codeGenerator(args.peephole ? &peephole : nullptr, args.inlineLimit,
+                                        args.ssa ? &ssaPasses : nullptr,
+                                        args.dumpSsaFile ? &ssaDump : nullptr);
+            program = codeGenerator.generateCode(tree->root);
+
+            if (args.dumpSsaFile && args.ssa) {
+                std::cout << "SSA form saved to " << *args.dumpSsaFile << "\n";
+            }
+            if (args.peepholeStats) {
+                std::cout << "Peephole rule hits:\n";
+                peephole.report(std::cout);
+                if (args.ssa) {
+                    std::cout << "SSA pass changes:\n";
+                    ssaPasses.report(std::cout);
+                }
+            }
         } else {
             std::ifstream asm_file(args.inputFile);
             std::stringstream buffer;
             buffer << asm_file.rdbuf();
-            code = buffer.str();
+            parseAssembly(buffer.str(), program);
+        }
+
+        if (args.dumpAsmFile) {
+            std::ofstream dump(*args.dumpAsmFile);
+            program.print(dump);
+            std::cout << "Assembly saved to " << *args.dumpAsmFile << "\n";
         }
 
         Binarizer binarizer;
-        binarizer.parse(code);
+        binarizer.assemble(program);
         binarizer.writeToFile(args.outputFile);
 
         std::cout << "Binary program saved to " << args.outputFile << "\n";
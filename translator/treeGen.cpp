@@ -54,6 +54,16 @@ std::string TreeGenerator::tokenStr(const Token& token) {
             return "Divide";
         case TokenType::Rem:
             return "Rem";
+        case TokenType::ShiftLeft:
+            return "ShiftLeft";
+        case TokenType::ShiftRight:
+            return "ShiftRight";
+        case TokenType::BitAnd:
+            return "BitAnd";
+        case TokenType::BitOr:
+            return "BitOr";
+        case TokenType::BitXor:
+            return "BitXor";
         case TokenType::KeywordInt:
             return "KeywordInt";
         case TokenType::KeywordUint:
@@ -85,854 +95,685 @@ std::string TreeGenerator::tokenStr(const Token& token) {
     }
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::makeTree(const std::string& data) {
-    auto root = std::make_unique<BlockNode>();
+char TreeGenerator::decodeChar(std::string_view literal) {
+    if (literal.size() == 2 && literal[0] == '\\') {
+        switch (literal[1]) {
+            case 'n':
+                return '\n';
+            case 't':
+                return '\t';
+            default:
+                return literal[1];
+        }
+    }
+    return literal[0];
+}
 
-    std::vector<Token> tokens = tokenize(data);
+Operator TreeGenerator::toOperator(TokenType type) {
+    switch (type) {
+        case TokenType::Plus:
+            return Operator::Add;
+        case TokenType::Minus:
+            return Operator::Sub;
+        case TokenType::Multiply:
+            return Operator::Mul;
+        case TokenType::Divide:
+            return Operator::Div;
+        case TokenType::Rem:
+            return Operator::Rem;
+        case TokenType::ShiftLeft:
+            return Operator::ShiftLeft;
+        case TokenType::ShiftRight:
+            return Operator::ShiftRight;
+        case TokenType::BitAnd:
+            return Operator::BitAnd;
+        case TokenType::BitOr:
+            return Operator::BitOr;
+        case TokenType::BitXor:
+            return Operator::BitXor;
+        case TokenType::LogicEqual:
+            return Operator::Equal;
+        case TokenType::LogicNotEqual:
+            return Operator::NotEqual;
+        case TokenType::LogicGreater:
+            return Operator::Greater;
+        case TokenType::LogicGreaterEqual:
+            return Operator::GreaterEqual;
+        case TokenType::LogicLess:
+            return Operator::Less;
+        case TokenType::LogicLessEqual:
+            return Operator::LessEqual;
+        case TokenType::LogicAnd:
+            return Operator::And;
+        case TokenType::LogicOr:
+            return Operator::Or;
+        case TokenType::LogicNot:
+            return Operator::Not;
+        default:
+            throw std::runtime_error("Not an operator token");
+    }
+}
 
-    size_t pos = 0;
+std::unique_ptr<AST> TreeGenerator::makeTree(const std::string& data) {
+    auto unit = std::make_unique<AST>();
+    ast       = unit.get();
 
-    while (pos < tokens.size() && tokens[pos].type != TokenType::EndOfFile) {
-        root->addChild(parseStatement(tokens, pos));
+    TokenStream tokens(Lexer(ast->symbols).tokenize(data));
+
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::EndOfFile) {
+        scratch.push_back(parseStatement(tokens));
     }
+    ast->root = make<BlockNode>(takeList(mark));
 
-    return root;
+    ast = nullptr;
+    return unit;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseAssignStatement(std::vector<Token> tokens,
-                                                             size_t& pos) {
-    if (tokens[pos].type != TokenType::Identifier) {
+ASTNode* TreeGenerator::parseAssignStatement(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected variable name");
     }
-    std::string varName = tokens[pos].value;
-    pos++;
+    Token varName = tokens.peek();
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> var;
-    if (tokens[pos].type == TokenType::LBracket) {
-        pos++;
+    ASTNode* var;
+    if (tokens.peek().type == TokenType::LBracket) {
+        tokens.advance();
 
-        std::unique_ptr<ASTNode> expr = parseExpression(tokens, pos);
+        ASTNode* expr = parseExpression(tokens);
 
-        if (tokens[pos].type != TokenType::RBracket) {
+        if (tokens.peek().type != TokenType::RBracket) {
             throw std::runtime_error("Expected ']'");
         }
-        pos++;
+        tokens.advance();
 
-        var = std::make_unique<ArrayGetNode>(std::make_unique<IdentifierNode>(varName),
-                                             std::move(expr));
+        var = make<ArrayGetNode>(makeIdentifier(varName), expr);
     } else {
-        var = std::make_unique<IdentifierNode>(varName);
+        var = makeIdentifier(varName);
     }
 
-    if (tokens[pos].type != TokenType::Equals) {
-        throw std::runtime_error("Expected '=', got " + tokenStr(tokens[pos]));
+    if (tokens.peek().type != TokenType::Equals) {
+        throw std::runtime_error("Expected '=', got " + tokenStr(tokens.peek()));
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> expr = parseExpression(tokens, pos);
+    ASTNode* expr = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::Semicolon) {
+    if (tokens.peek().type != TokenType::Semicolon) {
         throw std::runtime_error("Expected ';'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<AssignNode>(std::move(var), std::move(expr));
+    return make<AssignNode>(var, expr);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseVarStatement(std::vector<Token> tokens, size_t& pos) {
-    std::string type;
-    if (tokens[pos].type == TokenType::KeywordInt) {
-        type = "int";
-    } else if (tokens[pos].type == TokenType::KeywordUint) {
-        type = "uint";
-    } else if (tokens[pos].type == TokenType::KeywordChar) {
-        type = "char";
-    } else if (tokens[pos].type == TokenType::KeywordString) {
-        type = "string";
-    } else if (tokens[pos].type == TokenType::KeywordBool) {
-        type = "bool";
-    } else if (tokens[pos].type == TokenType::KeywordIntArr) {
-        type = "int[]";
+ASTNode* TreeGenerator::parseVarStatement(TokenStream& tokens) {
+    TypeId type;
+    if (tokens.peek().type == TokenType::KeywordInt) {
+        type = TypeId::Int;
+    } else if (tokens.peek().type == TokenType::KeywordUint) {
+        type = TypeId::Uint;
+    } else if (tokens.peek().type == TokenType::KeywordChar) {
+        type = TypeId::Char;
+    } else if (tokens.peek().type == TokenType::KeywordString) {
+        type = TypeId::String;
+    } else if (tokens.peek().type == TokenType::KeywordBool) {
+        type = TypeId::Bool;
+    } else if (tokens.peek().type == TokenType::KeywordIntArr) {
+        type = TypeId::IntArray;
     } else {
         throw std::runtime_error("Expected data type");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Identifier) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected variable name");
     }
-    std::string varName = tokens[pos].value;
-    pos++;
+    Token varName = tokens.peek();
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Equals) {
+    if (tokens.peek().type != TokenType::Equals) {
         throw std::runtime_error("Expected '='");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> expr;
+    ASTNode* expr;
 
-    expr = parseExpression(tokens, pos);
+    expr = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::Semicolon) {
+    if (tokens.peek().type != TokenType::Semicolon) {
         throw std::runtime_error("Expected ';'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<VarDeclNode>(type, varName, std::move(expr));
+    return make<VarDeclNode>(type, varName.symbol, symbolName(varName), expr);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseArray(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::LBrace) {
+ASTNode* TreeGenerator::parseArray(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::LBrace) {
         throw std::runtime_error("Expected '{'");
     }
-    pos++;
+    tokens.advance();
 
-    std::vector<std::unique_ptr<ASTNode>> values;
-    while (tokens[pos].type != TokenType::RBrace) {
-        values.push_back(parseExpression(tokens, pos));
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::RBrace) {
+        scratch.push_back(parseExpression(tokens));
 
-        if (tokens[pos].type == TokenType::Comma) {
-            pos++;
-        } else if (tokens[pos].type != TokenType::RBrace) {
+        if (tokens.peek().type == TokenType::Comma) {
+            tokens.advance();
+        } else if (tokens.peek().type != TokenType::RBrace) {
             throw std::runtime_error("Expected ',' or '}'");
         }
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<IntArrayLiteralNode>(std::move(values));
+    return make<IntArrayLiteralNode>(takeList(mark));
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseStatement(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node;
-
-    if (tokens[pos].type == TokenType::KeywordInt || tokens[pos].type == TokenType::KeywordUint ||
-        tokens[pos].type == TokenType::KeywordChar ||
-        tokens[pos].type == TokenType::KeywordString ||
-        tokens[pos].type == TokenType::KeywordBool || tokens[pos].type == TokenType::KeywordVoid ||
-        tokens[pos].type == TokenType::KeywordIntArr) {
-        if (pos + 2 < tokens.size() && tokens[pos + 1].type == TokenType::Identifier &&
-            tokens[pos + 2].type == TokenType::LParen) {
-            return parseFunction(tokens, pos);
+ASTNode* TreeGenerator::parseStatement(TokenStream& tokens) {
+    TokenType type = tokens.peek().type;
+
+    if (type == TokenType::KeywordInt || type == TokenType::KeywordUint ||
+        type == TokenType::KeywordChar || type == TokenType::KeywordString ||
+        type == TokenType::KeywordBool || type == TokenType::KeywordVoid ||
+        type == TokenType::KeywordIntArr) {
+        if (tokens.peek(1).type == TokenType::Identifier &&
+            tokens.peek(2).type == TokenType::LParen) {
+            return parseFunction(tokens);
         }
 
-        return parseVarStatement(tokens, pos);
+        return parseVarStatement(tokens);
     }
-    if (tokens[pos].type == TokenType::KeywordIf) {
-        return parseIf(tokens, pos);
+    if (tokens.peek().type == TokenType::KeywordIf) {
+        return parseIf(tokens);
     }
-    if (tokens[pos].type == TokenType::KeywordWhile) {
-        return parseWhile(tokens, pos);
+    if (tokens.peek().type == TokenType::KeywordWhile) {
+        return parseWhile(tokens);
     }
-    if (tokens[pos].type == TokenType::KeywordBreak) {
-        return parseBreak(tokens, pos);
+    if (tokens.peek().type == TokenType::KeywordBreak) {
+        return parseBreak(tokens);
     }
-    if (tokens[pos].type == TokenType::KeywordReturn) {
-        return parseReturn(tokens, pos);
+    if (tokens.peek().type == TokenType::KeywordReturn) {
+        return parseReturn(tokens);
     }
-    if (tokens[pos].type == TokenType::Identifier) {
-        if (pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::LParen) {
-            std::unique_ptr<ASTNode> node = parseFunctionCall(tokens, pos);
+    if (tokens.peek().type == TokenType::Identifier) {
+        if (tokens.peek(1).type == TokenType::LParen) {
+            ASTNode* node = parseFunctionCall(tokens);
 
-            if (tokens[pos].type != TokenType::Semicolon) {
+            if (tokens.peek().type != TokenType::Semicolon) {
                 throw std::runtime_error("Expected ';'");
             }
-            pos++;
+            tokens.advance();
 
             return node;
         }
 
-        return parseAssignStatement(tokens, pos);
+        return parseAssignStatement(tokens);
     }
 
-    return parseExpression(tokens, pos);
+    return parseExpression(tokens);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseIf(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordIf) {
+ASTNode* TreeGenerator::parseIf(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::KeywordIf) {
         throw std::runtime_error("Expected 'if'");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LParen) {
+    if (tokens.peek().type != TokenType::LParen) {
         throw std::runtime_error("Expected '('");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> condition = parseExpression(tokens, pos);
+    ASTNode* condition = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::RParen) {
+    if (tokens.peek().type != TokenType::RParen) {
         throw std::runtime_error("Expected ')'");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> thenBranch = parseBlock(tokens, pos);
+    ASTNode* thenBranch = parseBlock(tokens);
 
-    std::unique_ptr<ASTNode> elseBranch = nullptr;
-    if (pos < tokens.size() && tokens[pos].type == TokenType::KeywordElse) {
-        pos++;
-        elseBranch = parseBlock(tokens, pos);
+    ASTNode* elseBranch = nullptr;
+    if (tokens.peek().type == TokenType::KeywordElse) {
+        tokens.advance();
+        elseBranch = parseBlock(tokens);
     }
 
-    return std::make_unique<IfNode>(std::move(condition), std::move(thenBranch),
-                                    std::move(elseBranch));
+    return make<IfNode>(condition, thenBranch, elseBranch);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseWhile(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordWhile) {
+ASTNode* TreeGenerator::parseWhile(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::KeywordWhile) {
         throw std::runtime_error("Expected 'while'");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LParen) {
+    if (tokens.peek().type != TokenType::LParen) {
         throw std::runtime_error("Expected '('");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> condition = parseExpression(tokens, pos);
+    ASTNode* condition = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::RParen) {
+    if (tokens.peek().type != TokenType::RParen) {
         throw std::runtime_error("Expected ')");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> body = parseBlock(tokens, pos);
+    ASTNode* body = parseBlock(tokens);
 
-    return std::make_unique<WhileNode>(std::move(condition), std::move(body));
+    return make<WhileNode>(condition, body);
 }
 
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-std::unique_ptr<ASTNode> TreeGenerator::parseBreak(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordBreak) {
+ASTNode* TreeGenerator::parseBreak(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::KeywordBreak) {
         throw std::runtime_error("Expected 'break'");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Semicolon) {
+    if (tokens.peek().type != TokenType::Semicolon) {
         throw std::runtime_error("Expected ';'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<BreakNode>();
+    return make<BreakNode>();
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseBlock(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::LBrace) {
+ASTNode* TreeGenerator::parseBlock(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::LBrace) {
         throw std::runtime_error("Expected '{'");
     }
-    pos++;
-
-    std::unique_ptr<BlockNode> block = std::make_unique<BlockNode>();
+    tokens.advance();
 
-    while (pos < tokens.size() && tokens[pos].type != TokenType::RBrace &&
-           tokens[pos].type != TokenType::EndOfFile) {
-        block->children.push_back(parseStatement(tokens, pos));
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::RBrace &&
+           tokens.peek().type != TokenType::EndOfFile) {
+        scratch.push_back(parseStatement(tokens));
     }
 
-    if (tokens[pos].type != TokenType::RBrace) {
+    if (tokens.peek().type != TokenType::RBrace) {
         throw std::runtime_error("Expected '}'");
     }
-    pos++;
+    tokens.advance();
 
-    return block;
+    return make<BlockNode>(takeList(mark));
 }
 
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-std::unique_ptr<ASTNode> TreeGenerator::parseParameter(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordInt && tokens[pos].type != TokenType::KeywordChar &&
-        tokens[pos].type != TokenType::KeywordString &&
-        tokens[pos].type != TokenType::KeywordBool &&
-        tokens[pos].type != TokenType::KeywordIntArr) {
+ASTNode* TreeGenerator::parseParameter(TokenStream& tokens) {
+    TokenType typeToken = tokens.peek().type;
+    if (typeToken != TokenType::KeywordInt && typeToken != TokenType::KeywordChar &&
+        typeToken != TokenType::KeywordString && typeToken != TokenType::KeywordBool &&
+        typeToken != TokenType::KeywordIntArr) {
         throw std::runtime_error("Expected data type");
     }
-    std::string type = tokens[pos].value;
-    pos++;
+    TypeId type = typeFromName(tokens.peek().value);
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Identifier) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::string name = tokens[pos].value;
-    pos++;
+    Token name = tokens.peek();
+    tokens.advance();
 
-    return std::make_unique<ParameterNode>(name, type);
+    return make<ParameterNode>(name.symbol, symbolName(name), type);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseFunction(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordInt && tokens[pos].type != TokenType::KeywordChar &&
-        tokens[pos].type != TokenType::KeywordString &&
-        tokens[pos].type != TokenType::KeywordBool && tokens[pos].type != TokenType::KeywordVoid &&
-        tokens[pos].type != TokenType::KeywordIntArr) {
+ASTNode* TreeGenerator::parseFunction(TokenStream& tokens) {
+    TokenType typeToken = tokens.peek().type;
+    if (typeToken != TokenType::KeywordInt && typeToken != TokenType::KeywordChar &&
+        typeToken != TokenType::KeywordString && typeToken != TokenType::KeywordBool &&
+        typeToken != TokenType::KeywordVoid && typeToken != TokenType::KeywordIntArr) {
         throw std::runtime_error("Expected data type");
     }
-    std::string returnType = tokens[pos].value;
-    pos++;
+    TypeId returnType = typeFromName(tokens.peek().value);
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Identifier) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::string name = tokens[pos].value;
-    pos++;
+    Token name = tokens.peek();
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LParen) {
+    if (tokens.peek().type != TokenType::LParen) {
         throw std::runtime_error("Expected '('");
     }
-    pos++;
+    tokens.advance();
 
-    std::vector<std::unique_ptr<ASTNode>> parameters;
-    while (pos < tokens.size() && tokens[pos].type != TokenType::RParen) {
-        parameters.push_back(parseParameter(tokens, pos));
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::RParen) {
+        scratch.push_back(parseParameter(tokens));
 
-        if (tokens[pos].type == TokenType::Comma) {
-            pos++;
-        } else if (tokens[pos].type != TokenType::RParen) {
+        if (tokens.peek().type == TokenType::Comma) {
+            tokens.advance();
+        } else if (tokens.peek().type != TokenType::RParen) {
             throw std::runtime_error("Expected ',' or ')'");
         }
     }
 
-    if (tokens[pos].type != TokenType::RParen) {
+    if (tokens.peek().type != TokenType::RParen) {
         throw std::runtime_error("Expected ')'");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> body = parseBlock(tokens, pos);
+    NodeList parameters = takeList(mark);
+    ASTNode* body       = parseBlock(tokens);
 
-    return std::make_unique<FunctionNode>(returnType, name, std::move(parameters), std::move(body));
+    return make<FunctionNode>(returnType, name.symbol, symbolName(name), parameters, body);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseFunctionCall(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::Identifier) {
+ASTNode* TreeGenerator::parseFunctionCall(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::string name = tokens[pos].value;
-    pos++;
+    Token name = tokens.peek();
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LParen) {
+    if (tokens.peek().type != TokenType::LParen) {
         throw std::runtime_error("Expected '('");
     }
-    pos++;
+    tokens.advance();
 
-    std::vector<std::unique_ptr<ASTNode>> parameters;
-    while (pos < tokens.size() && tokens[pos].type != TokenType::RParen) {
-        parameters.push_back(parseExpression(tokens, pos));
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::RParen) {
+        scratch.push_back(parseExpression(tokens));
 
-        if (tokens[pos].type == TokenType::Comma) {
-            pos++;
-        } else if (tokens[pos].type != TokenType::RParen) {
-            throw std::runtime_error("Expected ',' or ')' got " + tokenStr(tokens[pos]) + " of " +
-                                     std::to_string(pos));
+        if (tokens.peek().type == TokenType::Comma) {
+            tokens.advance();
+        } else if (tokens.peek().type != TokenType::RParen) {
+            throw std::runtime_error("Expected ',' or ')' got " + tokenStr(tokens.peek()) + " of " +
+                                     std::to_string(tokens.position()));
         }
     }
 
-    if (tokens[pos].type != TokenType::RParen) {
+    if (tokens.peek().type != TokenType::RParen) {
         throw std::runtime_error("Expected ')'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<FunctionCallNode>(name, std::move(parameters));
+    return make<FunctionCallNode>(name.symbol, symbolName(name), takeList(mark));
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseReturn(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::KeywordReturn) {
+ASTNode* TreeGenerator::parseReturn(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::KeywordReturn) {
         throw std::runtime_error("Expected 'return'");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type == TokenType::Semicolon) {
-        pos++;
-        return std::make_unique<ReturnNode>(std::make_unique<VoidLiteralNode>());
+    if (tokens.peek().type == TokenType::Semicolon) {
+        tokens.advance();
+        return make<ReturnNode>(make<VoidLiteralNode>());
     }
 
-    std::unique_ptr<ASTNode> node = parseExpression(tokens, pos);
+    ASTNode* node = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::Semicolon) {
+    if (tokens.peek().type != TokenType::Semicolon) {
         throw std::runtime_error("Expected ';'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<ReturnNode>(std::move(node));
+    return make<ReturnNode>(node);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseArrayGet(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::Identifier) {
+ASTNode* TreeGenerator::parseArrayGet(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::unique_ptr<ASTNode> object = std::make_unique<IdentifierNode>(tokens[pos].value);
-    pos++;
+    ASTNode* object = makeIdentifier(tokens.peek());
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LBracket) {
+    if (tokens.peek().type != TokenType::LBracket) {
         throw std::runtime_error("Expected '['");
     }
-    pos++;
+    tokens.advance();
 
-    std::unique_ptr<ASTNode> expr = parseExpression(tokens, pos);
+    ASTNode* expr = parseExpression(tokens);
 
-    if (tokens[pos].type != TokenType::RBracket) {
+    if (tokens.peek().type != TokenType::RBracket) {
         throw std::runtime_error("Expected ']'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<ArrayGetNode>(std::move(object), std::move(expr));
+    return make<ArrayGetNode>(object, expr);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseMethodCall(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type != TokenType::Identifier) {
+ASTNode* TreeGenerator::parseMethodCall(TokenStream& tokens) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::unique_ptr<ASTNode> objectNode = std::make_unique<IdentifierNode>(tokens[pos].value);
-    pos++;
+    ASTNode* objectNode = makeIdentifier(tokens.peek());
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Dot) {
+    if (tokens.peek().type != TokenType::Dot) {
         throw std::runtime_error("Expected dot");
     }
-    pos++;
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::Identifier) {
+    if (tokens.peek().type != TokenType::Identifier) {
         throw std::runtime_error("Expected identifier");
     }
-    std::string methodName = tokens[pos].value;
-    pos++;
+    SymbolId method             = tokens.peek().symbol;
+    std::string_view methodName = symbolName(tokens.peek());
+    tokens.advance();
 
-    if (tokens[pos].type != TokenType::LParen) {
+    if (tokens.peek().type != TokenType::LParen) {
         throw std::runtime_error("Expected '('");
     }
-    pos++;
+    tokens.advance();
 
-    std::vector<std::unique_ptr<ASTNode>> args;
-    while (tokens[pos].type != TokenType::RParen) {
-        args.push_back(parsePrimary(tokens, pos));
+    size_t mark = scratch.size();
+    while (tokens.peek().type != TokenType::RParen) {
+        scratch.push_back(parsePrimary(tokens));
 
-        if (tokens[pos].type == TokenType::Comma) {
-            pos++;
+        if (tokens.peek().type == TokenType::Comma) {
+            tokens.advance();
         }
     }
 
-    if (tokens[pos].type != TokenType::RParen) {
+    if (tokens.peek().type != TokenType::RParen) {
         throw std::runtime_error("Expected ')'");
     }
-    pos++;
+    tokens.advance();
 
-    return std::make_unique<MethodCallNode>(std::move(objectNode), methodName, std::move(args));
+    return make<MethodCallNode>(objectNode, method, methodName, takeList(mark));
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseExpression(std::vector<Token> tokens, size_t& pos) {
-    return parseLogicOr(std::move(tokens), pos);
+ASTNode* TreeGenerator::parseExpression(TokenStream& tokens) {
+    return parseLogicOr(tokens);
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseTerm(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseFactor(tokens, pos);
+ASTNode* TreeGenerator::parseTerm(TokenStream& tokens) {
+    ASTNode* node = parseFactor(tokens);
 
-    while (pos < tokens.size() &&
-           (tokens[pos].type == TokenType::Plus || tokens[pos].type == TokenType::Minus)) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseFactor(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+    while (tokens.peek().type == TokenType::Plus || tokens.peek().type == TokenType::Minus) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseFactor(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseFactor(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseUnary(tokens, pos);
+ASTNode* TreeGenerator::parseFactor(TokenStream& tokens) {
+    ASTNode* node = parseUnary(tokens);
 
-    while (pos < tokens.size() &&
-           (tokens[pos].type == TokenType::Multiply || tokens[pos].type == TokenType::Divide ||
-            tokens[pos].type == TokenType::Rem)) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseUnary(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+    while (tokens.peek().type == TokenType::Multiply || tokens.peek().type == TokenType::Divide ||
+           tokens.peek().type == TokenType::Rem) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseUnary(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseLogicOr(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseLogicAnd(tokens, pos);
-    while (pos < tokens.size() && tokens[pos].type == TokenType::LogicOr) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseLogicAnd(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+ASTNode* TreeGenerator::parseLogicOr(TokenStream& tokens) {
+    ASTNode* node = parseLogicAnd(tokens);
+    while (tokens.peek().type == TokenType::LogicOr) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseLogicAnd(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseLogicAnd(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseEquality(tokens, pos);
-    while (pos < tokens.size() && tokens[pos].type == TokenType::LogicAnd) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseEquality(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+ASTNode* TreeGenerator::parseLogicAnd(TokenStream& tokens) {
+    ASTNode* node = parseBitOr(tokens);
+    while (tokens.peek().type == TokenType::LogicAnd) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseBitOr(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseEquality(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseComparsion(tokens, pos);
-    while (pos < tokens.size() && (tokens[pos].type == TokenType::LogicEqual ||
-                                   tokens[pos].type == TokenType::LogicNotEqual)) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseComparsion(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+// Bitwise operators bind looser than comparisons, as in C.
+ASTNode* TreeGenerator::parseBitOr(TokenStream& tokens) {
+    ASTNode* node = parseBitXor(tokens);
+    while (tokens.peek().type == TokenType::BitOr) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseBitXor(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseComparsion(std::vector<Token> tokens, size_t& pos) {
-    std::unique_ptr<ASTNode> node = parseTerm(tokens, pos);
-    while (pos < tokens.size() && (tokens[pos].type == TokenType::LogicGreater ||
-                                   tokens[pos].type == TokenType::LogicGreaterEqual ||
-                                   tokens[pos].type == TokenType::LogicLess ||
-                                   tokens[pos].type == TokenType::LogicLessEqual)) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> right = parseTerm(tokens, pos);
-        node = std::make_unique<BinaryOpNode>(opr, std::move(node), std::move(right));
+ASTNode* TreeGenerator::parseBitXor(TokenStream& tokens) {
+    ASTNode* node = parseBitAnd(tokens);
+    while (tokens.peek().type == TokenType::BitXor) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseBitAnd(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
     return node;
 }
 
-std::unique_ptr<ASTNode> TreeGenerator::parseUnary(std::vector<Token> tokens, size_t& pos) {
-    if (pos < tokens.size() &&
-        (tokens[pos].type == TokenType::LogicNot || tokens[pos].type == TokenType::Minus)) {
-        std::string opr = tokens[pos].value;
-        pos++;
-        std::unique_ptr<ASTNode> operand = parseUnary(tokens, pos);
-        return std::make_unique<UnaryOpNode>(opr, std::move(operand));
+ASTNode* TreeGenerator::parseBitAnd(TokenStream& tokens) {
+    ASTNode* node = parseEquality(tokens);
+    while (tokens.peek().type == TokenType::BitAnd) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseEquality(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
-    return parsePrimary(tokens, pos);
-}
 
-std::unique_ptr<ASTNode> TreeGenerator::parsePrimary(std::vector<Token> tokens, size_t& pos) {
-    if (tokens[pos].type == TokenType::Number) {
-        long value = std::stol(tokens[pos].value);
-        pos++;
-        return std::make_unique<NumberLiteralNode>(value);
-    }
-    if (tokens[pos].type == TokenType::Char) {
-        char value = tokens[pos].value[0];
-        pos++;
-        return std::make_unique<CharLiteralNode>(value);
-    }
-    if (tokens[pos].type == TokenType::String) {
-        std::string value = tokens[pos].value;
-        pos++;
-        return std::make_unique<StringLiteralNode>(value);
-    }
-    if (tokens[pos].type == TokenType::Boolean) {
-        bool value = tokens[pos].value == "true";
-        pos++;
-        return std::make_unique<BooleanLiteralNode>(value);
-    }
-    if (tokens[pos].type == TokenType::Identifier) {
-        if (pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::LParen) {
-            return parseFunctionCall(tokens, pos);
-        }
-        if (pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::LBracket) {
-            return parseArrayGet(tokens, pos);
-        }
-        if (pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::Dot) {
-            return parseMethodCall(tokens, pos);
-        }
+    return node;
+}
 
-        std::string name = tokens[pos].value;
-        pos++;
-        return std::make_unique<IdentifierNode>(name);
-    }
-    if (tokens[pos].type == TokenType::LParen) {
-        pos++;
-        std::unique_ptr<ASTNode> expr = parseExpression(tokens, pos);
-        if (tokens[pos].type != TokenType::RParen) {
-            throw std::runtime_error("Expected ')'");
-        }
-        pos++;
-        return expr;
-    }
-    if (tokens[pos].type == TokenType::LBrace) {
-        return parseArray(tokens, pos);
+ASTNode* TreeGenerator::parseEquality(TokenStream& tokens) {
+    ASTNode* node = parseComparsion(tokens);
+    while (tokens.peek().type == TokenType::LogicEqual ||
+           tokens.peek().type == TokenType::LogicNotEqual) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseComparsion(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
     }
 
-    throw std::runtime_error("Unexpected token in factor: " + tokenStr(tokens[pos]));
+    return node;
 }
 
-// NOLINTNEXTLINE(readability-function-cognitive-complexity)
-std::vector<Token> TreeGenerator::tokenize(const std::string& input) {
-    std::vector<Token> tokens;
-    size_t pos = 0;
-
-    while (pos < input.size()) {
-        char current = input[pos];
-
-        if (current == '\n') {
-            pos++;
-            continue;
-        }
+ASTNode* TreeGenerator::parseComparsion(TokenStream& tokens) {
+    ASTNode* node = parseShift(tokens);
+    while (tokens.peek().type == TokenType::LogicGreater ||
+           tokens.peek().type == TokenType::LogicGreaterEqual ||
+           tokens.peek().type == TokenType::LogicLess ||
+           tokens.peek().type == TokenType::LogicLessEqual) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseShift(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
+    }
 
-        if (isspace(current) != 0) {
-            pos++;
-            continue;
-        }
+    return node;
+}
 
-        if (isAlpha(current)) {
-            size_t start = pos;
-            while (pos < input.size() && isAlnum(input[pos])) {
-                pos++;
-            }
+ASTNode* TreeGenerator::parseShift(TokenStream& tokens) {
+    ASTNode* node = parseTerm(tokens);
+    while (tokens.peek().type == TokenType::ShiftLeft ||
+           tokens.peek().type == TokenType::ShiftRight) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* right = parseTerm(tokens);
+        node = make<BinaryOpNode>(opr, node, right);
+    }
 
-            std::string word = input.substr(start, pos - start);
-            if (word == "if") {
-                tokens.emplace_back(TokenType::KeywordIf, word);
-            } else if (word == "else") {
-                tokens.emplace_back(TokenType::KeywordElse, word);
-            } else if (word == "while") {
-                tokens.emplace_back(TokenType::KeywordWhile, word);
-            } else if (word == "break") {
-                tokens.emplace_back(TokenType::KeywordBreak, word);
-            } else if (word == "true" || word == "false") {
-                tokens.emplace_back(TokenType::Boolean, word);
-            } else if (word == "void") {
-                tokens.emplace_back(TokenType::KeywordVoid, word);
-            } else if (word == "int") {
-                size_t tempPos = pos;
-                while (tempPos < input.size() && isspace(input[tempPos]) != 0) {
-                    tempPos++;
-                }
-
-                if (tempPos < input.size() && input[tempPos] == '[') {
-                    tempPos++;
-                    while (tempPos < input.size() && isspace(input[tempPos]) != 0) {
-                        tempPos++;
-                    }
-
-                    if (tempPos < input.size() && input[tempPos] == ']') {
-                        tempPos++;
-                        pos = tempPos;
-                        tokens.emplace_back(TokenType::KeywordIntArr, "int[]");
-                        continue;
-                    }
-                }
-
-                tokens.emplace_back(TokenType::KeywordInt, word);
-                continue;
-            } else if (word == "uint") {
-                tokens.emplace_back(TokenType::KeywordUint, word);
-            } else if (word == "char") {
-                tokens.emplace_back(TokenType::KeywordChar, word);
-            } else if (word == "string") {
-                tokens.emplace_back(TokenType::KeywordString, word);
-            } else if (word == "bool") {
-                tokens.emplace_back(TokenType::KeywordBool, word);
-            } else if (word == "return") {
-                tokens.emplace_back(TokenType::KeywordReturn, word);
-            } else {
-                tokens.emplace_back(TokenType::Identifier, word);
-            }
+    return node;
+}
 
-            continue;
-        }
+ASTNode* TreeGenerator::parseUnary(TokenStream& tokens) {
+    if (tokens.peek().type == TokenType::LogicNot || tokens.peek().type == TokenType::Minus) {
+        Operator opr = toOperator(tokens.peek().type);
+        tokens.advance();
+        ASTNode* operand = parseUnary(tokens);
+        return make<UnaryOpNode>(opr, operand);
+    }
+    return parsePrimary(tokens);
+}
 
-        if (isDigit(current)) {
-            size_t start = pos;
-            while (pos < input.size() && isDigit(input[pos])) {
-                pos++;
-            }
-            tokens.emplace_back(TokenType::Number, input.substr(start, pos - start));
-            continue;
+ASTNode* TreeGenerator::parsePrimary(TokenStream& tokens) {
+    if (tokens.peek().type == TokenType::Number) {
+        long value = std::stol(std::string(tokens.peek().value));
+        tokens.advance();
+        return make<NumberLiteralNode>(value);
+    }
+    if (tokens.peek().type == TokenType::Char) {
+        char value = decodeChar(tokens.peek().value);
+        tokens.advance();
+        return make<CharLiteralNode>(value);
+    }
+    if (tokens.peek().type == TokenType::String) {
+        std::string_view value = ast->arena.copyString(tokens.peek().value);
+        tokens.advance();
+        return make<StringLiteralNode>(value);
+    }
+    if (tokens.peek().type == TokenType::Boolean) {
+        bool value = tokens.peek().value == "true";
+        tokens.advance();
+        return make<BooleanLiteralNode>(value);
+    }
+    if (tokens.peek().type == TokenType::Identifier) {
+        if (tokens.peek(1).type == TokenType::LParen) {
+            return parseFunctionCall(tokens);
         }
-
-        if (current == '"') {
-            pos++;
-            std::string str;
-
-            while (pos < input.size() && input[pos] != '"') {
-                str += input[pos++];
-            }
-
-            if (pos < input.size() && input[pos] == '"') {
-                pos++;
-                tokens.emplace_back(TokenType::String, str);
-            } else {
-                throw std::runtime_error("Expected \"");
-            }
-
-            continue;
+        if (tokens.peek(1).type == TokenType::LBracket) {
+            return parseArrayGet(tokens);
         }
-
-        if (current == '\'') {
-            pos++;
-
-            if (pos >= input.size()) {
-                throw std::runtime_error("expected \'");
-            }
-
-            char char_value = 0;
-
-            if (pos < input.size() && input[pos] == '\\') {
-                pos++;
-
-                if (pos >= input.size()) {
-                    throw std::runtime_error("incomplete char literal");
-                }
-
-                switch (input[pos]) {
-                    case 'n':
-                        char_value = '\n';
-                        break;
-                    case 't':
-                        char_value = '\t';
-                        break;
-                    case '\\':
-                        char_value = '\\';
-                        break;
-                    case '\'':
-                        char_value = '\'';
-                        break;
-                    default:
-                        throw std::runtime_error("unsuppoerted escapte-sequence: " +
-                                                 std::to_string(input[pos]));
-                }
-            } else {
-                if (pos >= input.size()) {
-                    throw std::runtime_error("incomplete char literal");
-                }
-
-                char_value = input[pos];
-            }
-            pos++;
-
-            if (pos >= input.size() || input[pos] != '\'') {
-                throw std::runtime_error("expected \'");
-            }
-            pos++;
-
-            tokens.emplace_back(TokenType::Char, std::string(1, char_value));
-            continue;
+        if (tokens.peek(1).type == TokenType::Dot) {
+            return parseMethodCall(tokens);
         }
 
-        switch (current) {
-            case '=':
-                if (pos + 1 < input.size() && input[pos + 1] == '=') {
-                    tokens.emplace_back(TokenType::LogicEqual, "==");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::Equals, "=");
-                    pos++;
-                }
-                break;
-            case ';':
-                tokens.emplace_back(TokenType::Semicolon, ";");
-                pos++;
-                break;
-            case '.':
-                tokens.emplace_back(TokenType::Dot, ".");
-                pos++;
-                break;
-            case ',':
-                tokens.emplace_back(TokenType::Comma, ",");
-                pos++;
-                break;
-            case '(':
-                tokens.emplace_back(TokenType::LParen, "(");
-                pos++;
-                break;
-            case ')':
-                tokens.emplace_back(TokenType::RParen, ")");
-                pos++;
-                break;
-            case '{':
-                tokens.emplace_back(TokenType::LBrace, "{");
-                pos++;
-                break;
-            case '}':
-                tokens.emplace_back(TokenType::RBrace, "}");
-                pos++;
-                break;
-            case '[':
-                tokens.emplace_back(TokenType::LBracket, "[");
-                pos++;
-                break;
-            case ']':
-                tokens.emplace_back(TokenType::RBracket, "]");
-                pos++;
-                break;
-            case '!':
-                if (pos + 1 < input.size() && input[pos + 1] == '=') {
-                    tokens.emplace_back(TokenType::LogicNotEqual, "!=");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::LogicNot, "!");
-                    pos++;
-                }
-                break;
-            case '+':
-                tokens.emplace_back(TokenType::Plus, "+");
-                pos++;
-                break;
-            case '-':
-                tokens.emplace_back(TokenType::Minus, "-");
-                pos++;
-                break;
-            case '*':
-                tokens.emplace_back(TokenType::Multiply, "*");
-                pos++;
-                break;
-            case '/':
-                tokens.emplace_back(TokenType::Divide, "/");
-                pos++;
-                break;
-            case '%':
-                tokens.emplace_back(TokenType::Rem, "%");
-                pos++;
-                break;
-            case '&':
-                if (pos + 1 < input.size() && input[pos + 1] == '&') {
-                    tokens.emplace_back(TokenType::LogicAnd, "&&");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::Unknown, "&");
-                    pos++;
-                }
-                break;
-            case '|':
-                if (pos + 1 < input.size() && input[pos + 1] == '|') {
-                    tokens.emplace_back(TokenType::LogicOr, "||");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::Unknown, "|");
-                    pos++;
-                }
-                break;
-            case '>':
-                if (pos + 1 < input.size() && input[pos + 1] == '=') {
-                    tokens.emplace_back(TokenType::LogicGreaterEqual, ">=");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::LogicGreater, ">");
-                    pos++;
-                }
-                break;
-            case '<':
-                if (pos + 1 < input.size() && input[pos + 1] == '=') {
-                    tokens.emplace_back(TokenType::LogicLessEqual, "<=");
-                    pos += 2;
-                } else {
-                    tokens.emplace_back(TokenType::LogicLess, "<");
-                    pos++;
-                }
-                break;
-            default:
-                tokens.emplace_back(TokenType::Unknown, std::string(1, current));
-                pos++;
-                break;
+        ASTNode* identifier = makeIdentifier(tokens.peek());
+        tokens.advance();
+        return identifier;
+    }
+    if (tokens.peek().type == TokenType::LParen) {
+        tokens.advance();
+        ASTNode* expr = parseExpression(tokens);
+        if (tokens.peek().type != TokenType::RParen) {
+            throw std::runtime_error("Expected ')'");
         }
+        tokens.advance();
+        return expr;
     }
+    if (tokens.peek().type == TokenType::LBrace) {
+        return parseArray(tokens);
+    }
+
+    throw std::runtime_error("Unexpected token in factor: " + tokenStr(tokens.peek()));
+}
 
-    tokens.emplace_back(TokenType::EndOfFile, "");
-    return tokens;
-}
\ No newline at end of file
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
@@ -4,126 +4,111 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "ASTNode.hpp"
+#include "lexer.h"
 #include "semanticAnalyzer.h"
 
-enum class TokenType : uint8_t {
-    // Keywords
-    KeywordIf,
-    KeywordElse,
-    KeywordWhile,
-    KeywordBreak,
-    KeywordReturn,
-    KeywordVoid,
-
-    // Data types
-    KeywordInt,
-    KeywordUint,
-    KeywordChar,
-    KeywordString,
-    KeywordBool,
-    KeywordIntArr,
-
-    // Utility
-    Identifier,
-    Equals,
-    Number,
-    Char,
-    String,
-    Boolean,
-
-    // Delimeters
-    LParen,
-    RParen,
-    LBrace,
-    RBrace,
-    LBracket,
-    RBracket,
-    Semicolon,
-    Dot,
-    Comma,
-
-    // Logic operators
-    LogicNot,
-    LogicAnd,
-    LogicOr,
-    LogicEqual,
-    LogicNotEqual,
-    LogicGreater,
-    LogicGreaterEqual,
-    LogicLess,
-    LogicLessEqual,
-
-    // Operators
-    Plus,
-    Minus,
-    Multiply,
-    Divide,
-    Rem,
-
-    // Utility
-    EndOfFile,
-    Unknown
-};
+// Cursor over the token list that the whole parser shares by reference. Reading past the end
+// keeps returning the trailing EndOfFile token.
+class TokenStream {
+public:
+    explicit TokenStream(std::vector<Token> tokens) : tokens(std::move(tokens)) {
+        if (this->tokens.empty() || this->tokens.back().type != TokenType::EndOfFile) {
+            this->tokens.emplace_back(TokenType::EndOfFile, "");
+        }
+    }
+
+    [[nodiscard]] const Token& peek(size_t offset = 0) const {
+        size_t index = pos + offset;
+        return index < tokens.size() ? tokens[index] : tokens.back();
+    }
 
-struct Token {
-    TokenType type;
-    std::string value;
+    void advance() {
+        if (pos < tokens.size()) {
+            pos++;
+        }
+    }
 
-    Token(TokenType type, std::string value) : type(type), value(std::move(value)) {
+    [[nodiscard]] size_t position() const {
+        return pos;
     }
+
+private:
+    std::vector<Token> tokens;
+    size_t pos = 0;
 };
 
 class TreeGenerator {
 public:
     TreeGenerator() = default;
 
-    std::unique_ptr<ASTNode> makeTree(const std::string& data);
+    std::unique_ptr<AST> makeTree(const std::string& data);
 
 private:
-    static std::vector<Token> tokenize(const std::string& input);
-
-    std::unique_ptr<ASTNode> parseVarStatement(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseAssignStatement(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseBlock(std::vector<Token> tokens, size_t& pos);
-
-    std::unique_ptr<ASTNode> parseStatement(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseIf(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseWhile(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseBreak(std::vector<Token> tokens, size_t& pos);
-
-    std::unique_ptr<ASTNode> parseParameter(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseFunction(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseFunctionCall(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseReturn(std::vector<Token> tokens, size_t& pos);
-
-    std::unique_ptr<ASTNode> parseExpression(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseArray(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseArrayGet(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseMethodCall(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseTerm(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseFactor(std::vector<Token> tokens, size_t& pos);
-
-    std::unique_ptr<ASTNode> parseLogicOr(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseLogicAnd(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseEquality(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseComparsion(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parseUnary(std::vector<Token> tokens, size_t& pos);
-    std::unique_ptr<ASTNode> parsePrimary(std::vector<Token> tokens, size_t& pos);
+    // Unit being built by makeTree().
+    AST* ast = nullptr;
 
-    static std::string tokenStr(const Token& token);
+    // Children of every list under construction, innermost last. A list pushes onto the end and
+    // moves its run into the arena with takeList() once it is complete.
+    std::vector<ASTNode*> scratch;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return ast->arena.make<T>(std::forward<Args>(args)...);
+    }
 
-    static bool isAlpha(char character) {
-        return std::isalpha(static_cast<unsigned char>(character)) != 0 || character == '_';
+    NodeList takeList(size_t mark) {
+        NodeList list = ast->arena.makeList(scratch.data() + mark, scratch.size() - mark);
+        scratch.resize(mark);
+        return list;
     }
-    static bool isDigit(char character) {
-        return std::isdigit(static_cast<unsigned char>(character)) != 0;
+
+    [[nodiscard]] std::string_view symbolName(const Token& token) const {
+        return ast->symbols.name(token.symbol);
     }
-    static bool isAlnum(char character) {
-        return isAlpha(character) || isDigit(character);
+
+    IdentifierNode* makeIdentifier(const Token& token) {
+        return make<IdentifierNode>(token.symbol, symbolName(token));
     }
+
+    ASTNode* parseVarStatement(TokenStream& tokens);
+    ASTNode* parseAssignStatement(TokenStream& tokens);
+    ASTNode* parseBlock(TokenStream& tokens);
+
+    ASTNode* parseStatement(TokenStream& tokens);
+    ASTNode* parseIf(TokenStream& tokens);
+    ASTNode* parseWhile(TokenStream& tokens);
+    ASTNode* parseBreak(TokenStream& tokens);
+
+    ASTNode* parseParameter(TokenStream& tokens);
+    ASTNode* parseFunction(TokenStream& tokens);
+    ASTNode* parseFunctionCall(TokenStream& tokens);
+    ASTNode* parseReturn(TokenStream& tokens);
+
+    ASTNode* parseExpression(TokenStream& tokens);
+    ASTNode* parseArray(TokenStream& tokens);
+    ASTNode* parseArrayGet(TokenStream& tokens);
+    ASTNode* parseMethodCall(TokenStream& tokens);
+    ASTNode* parseTerm(TokenStream& tokens);
+    ASTNode* parseFactor(TokenStream& tokens);
+
+    ASTNode* parseLogicOr(TokenStream& tokens);
+    ASTNode* parseLogicAnd(TokenStream& tokens);
+    ASTNode* parseBitOr(TokenStream& tokens);
+    ASTNode* parseBitXor(TokenStream& tokens);
+    ASTNode* parseBitAnd(TokenStream& tokens);
+    ASTNode* parseEquality(TokenStream& tokens);
+    ASTNode* parseComparsion(TokenStream& tokens);
+    ASTNode* parseShift(TokenStream& tokens);
+    ASTNode* parseUnary(TokenStream& tokens);
+    ASTNode* parsePrimary(TokenStream& tokens);
+
+    static std::string tokenStr(const Token& token);
+    static char decodeChar(std::string_view literal);
+    static Operator toOperator(TokenType type);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// The language has a closed set of types, so they are plain ids into one table. Type checks and
+// overload matching compare ids; names and mangling suffixes are looked up only for output.
+enum class TypeId : uint8_t {
+    None,  // not resolved yet / no expectation
+    Void,
+    Int,
+    Uint,
+    Char,
+    String,
+    Bool,
+    IntArray,
+    COUNT
+};
+
+struct TypeInfo {
+    std::string_view name;
+    std::string_view mangled;  // suffix in func_<name>_<suffix>... labels
+};
+
+// clang-format off
+constexpr std::array<TypeInfo, static_cast<size_t>(TypeId::COUNT)> TYPE_TABLE = {{
+    {"",       ""},
+    {"void",   ""},
+    {"int",    "i"},
+    {"uint",   ""},
+    {"char",   ""},
+    {"string", "s"},
+    {"bool",   "b"},
+    {"int[]",  "ai"},
+}};
+// clang-format on
+
+constexpr const TypeInfo& typeInfo(TypeId type) {
+    return TYPE_TABLE[static_cast<size_t>(type)];
+}
+
+inline std::string typeName(TypeId type) {
+    return std::string(typeInfo(type).name);
+}
+
+inline TypeId typeFromName(std::string_view name) {
+    for (size_t index = 1; index < TYPE_TABLE.size(); index++) {
+        if (TYPE_TABLE[index].name == name) {
+            return static_cast<TypeId>(index);
+        }
+    }
+    throw std::runtime_error("Unknown type: " + std::string(name));
+}
+
+inline bool isNumeric(TypeId type) {
+    return type == TypeId::Int || type == TypeId::Uint;
+}